@@ -6,6 +6,17 @@
 
 /**
  * @file canvas.cpp
+ *
+ * this file contains the canvas agnostic way of detecting which items are at
+ * a certain position, so all canvas implementations select the same items.
+ *
+ * This also allows for a less precise item selection and especially
+ * to differentiate between the clicks on a polygon border and its
+ * interior
+ *
+ * References:
+ * https://en.wikipedia.org/wiki/Point_in_polygon
+ * https://www.visibone.com/inpoly/
  */
 
 #include "canvas.h"
@@ -19,11 +30,24 @@
 #include <cstdio>
 #include <limits>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "osm2go_annotations.h"
 #include "osm2go_stl.h"
 
 canvas_t::canvas_t(osm2go_platform::Widget *w)
   : widget(w)
+  , hit_index(new canvas_hit_index_t())
+{
+}
+
+canvas_t::~canvas_t()
 {
 }
 
@@ -56,30 +80,38 @@ public:
     const canvas_t::item_mapping_t::iterator it = canvas->item_mapping.find(item);
     assert(it != canvas->item_mapping.end());
     canvas->item_mapping.erase(it);
+    canvas->hit_index->erase(info);
     delete info;
   }
 };
 
 } // namespace
 
-canvas_item_info_t::canvas_item_info_t(canvas_item_type_t t, canvas_t *cv, canvas_item_t *it, canvas_item_destroyer *d)
+canvas_item_info_t::canvas_item_info_t(canvas_item_type_t t, canvas_t *cv, canvas_group_t g,
+                                       canvas_item_t *it, canvas_item_destroyer *d)
   : type(t)
+  , group(g)
+  , item(it)
+  , stacking(0)
+  , zoom_max(0)
 {
   cv->item_mapping[it] = this;
 
   it->destroy_connect(d);
 }
 
-canvas_item_info_circle::canvas_item_info_circle(canvas_t *cv, canvas_item_t *it, lpos_t c, const unsigned int r)
-  : canvas_item_info_t(CANVAS_ITEM_CIRCLE, cv, it, new item_info_destroyer<canvas_item_info_circle>(this, cv))
+canvas_item_info_circle::canvas_item_info_circle(canvas_t *cv, canvas_group_t g, canvas_item_t *it,
+                                                 lpos_t c, const unsigned int r)
+  : canvas_item_info_t(CANVAS_ITEM_CIRCLE, cv, g, it, new item_info_destroyer<canvas_item_info_circle>(this, cv))
   , center(c)
   , radius(r)
 {
+  cv->hit_index->insert(this);
 }
 
-canvas_item_info_poly::canvas_item_info_poly(canvas_t* cv, canvas_item_t* it,
+canvas_item_info_poly::canvas_item_info_poly(canvas_t* cv, canvas_group_t g, canvas_item_t* it,
                                              bool poly, float wd, const std::vector<lpos_t> &p)
-  : canvas_item_info_t(CANVAS_ITEM_POLY, cv, it, new item_info_destroyer<canvas_item_info_poly>(this, cv))
+  : canvas_item_info_t(CANVAS_ITEM_POLY, cv, g, it, new item_info_destroyer<canvas_item_info_poly>(this, cv))
   , is_polygon(poly)
   , width(wd)
   , num_points(p.size())
@@ -87,52 +119,530 @@ canvas_item_info_poly::canvas_item_info_poly(canvas_t* cv, canvas_item_t* it,
 {
   // data() is a C++11 extension, but gcc has it since at least 4.2
   memcpy(points.get(), p.data(), p.size() * sizeof(points[0]));
+
+  cv->hit_index->insert(this);
+}
+
+namespace {
+
+/**
+ * @brief check if the position is next to the segment
+ * @param n the distance of the position to the segment is returned here
+ */
+inline bool
+segment_distance(const lpos_t pos, const lpos_t posnext, int x, int y, float &n)
+{
+  const int dxi = posnext.x - pos.x;
+  const int dyi = posnext.y - pos.y;
+  const float dx = dxi;
+  const float dy = dyi;
+  float len = dy * dy + dx * dx;
+  float m = ((x - pos.x) * dx + (y - pos.y) * dy) / len;
+
+  /* this is a possible candidate */
+  if(!((m >= 0.0f) && (m <= 1.0f)))
+    return false;
+
+  if(abs(dxi) > abs(dyi))
+    n = fabsf(sqrtf(len) * (pos.y - y + m * dy) / dx);
+  else
+    n = fabsf(sqrtf(len) * -(pos.x - x + m * dx) / dy);
+
+  return true;
+}
+
+/**
+ * @brief check the segments [first, last) one by one
+ */
+inline void
+segment_scan(const lpos_t *points, unsigned int first, unsigned int last, int x, int y,
+             float &mindist, std::optional<unsigned int> &ret)
+{
+  for(unsigned int i = first; i < last; i++) {
+    float n;
+    /* check if this is actually on the line and closer than anything */
+    /* we found so far */
+    if(segment_distance(points[i], points[i + 1], x, y, n) && n < mindist) {
+      ret = i;
+      mindist = n;
+    }
+  }
+}
+
+/*
+ * The SIMD kernels only preselect the segments: they calculate the squared
+ * distance of the position to SegmentLanes segments at once in a simpler
+ * way. The segments that may be closer than the current minimum are then
+ * checked with segment_distance(), so the result is exactly the same as
+ * with the plain loop. The limits are slightly extended so that different
+ * rounding never drops a segment that segment_distance() would accept.
+ */
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+#define SEGMENT_SIMD 1
+
+// the bound of the distance is mindist + tolerance * (|dx| + |dy| + mindist) + offset
+const float segment_tolerance = 1e-5f;
+const float segment_offset = 1e-3f;
+const float segment_mmin = -0.01f;
+const float segment_mmax = 1.01f;
+#endif
+
+#if defined(__AVX2__)
+enum { SegmentLanes = 8 };
+
+/**
+ * @brief get the segments starting at p that may be closer than mindist
+ * @returns a bitmask of the candidate segments
+ */
+unsigned int
+segment_candidates(const lpos_t *p, int x, int y, float mindist)
+{
+  const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+  // x0 x1 x2 x3 y0 y1 y2 y3, then the same for points 4-7
+  const __m256i lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), order);
+  const __m256i hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 4)), order);
+  const __m256i nlo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), order);
+  const __m256i nhi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 5)), order);
+  const __m256i px = _mm256_permute2x128_si256(lo, hi, 0x20);
+  const __m256i py = _mm256_permute2x128_si256(lo, hi, 0x31);
+  const __m256i nx = _mm256_permute2x128_si256(nlo, nhi, 0x20);
+  const __m256i ny = _mm256_permute2x128_si256(nlo, nhi, 0x31);
+
+  const __m256 dx = _mm256_cvtepi32_ps(_mm256_sub_epi32(nx, px));
+  const __m256 dy = _mm256_cvtepi32_ps(_mm256_sub_epi32(ny, py));
+  const __m256 ax = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_set1_epi32(x), px));
+  const __m256 ay = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_set1_epi32(y), py));
+
+  const __m256 len = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+  const __m256 dot = _mm256_add_ps(_mm256_mul_ps(ax, dx), _mm256_mul_ps(ay, dy));
+  const __m256 cross = _mm256_sub_ps(_mm256_mul_ps(ax, dy), _mm256_mul_ps(ay, dx));
+
+  const __m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 md = _mm256_set1_ps(mindist);
+  const __m256 size = _mm256_add_ps(_mm256_add_ps(_mm256_and_ps(dx, absmask), _mm256_and_ps(dy, absmask)), md);
+  const __m256 lim = _mm256_add_ps(md, _mm256_add_ps(_mm256_mul_ps(size, _mm256_set1_ps(segment_tolerance)),
+                                                     _mm256_set1_ps(segment_offset)));
+
+  const __m256 inside = _mm256_and_ps(_mm256_cmp_ps(dot, _mm256_mul_ps(len, _mm256_set1_ps(segment_mmin)), _CMP_GE_OQ),
+                                      _mm256_cmp_ps(dot, _mm256_mul_ps(len, _mm256_set1_ps(segment_mmax)), _CMP_LE_OQ));
+  const __m256 near = _mm256_cmp_ps(_mm256_mul_ps(cross, cross), _mm256_mul_ps(_mm256_mul_ps(lim, lim), len), _CMP_LE_OQ);
+
+  return _mm256_movemask_ps(_mm256_and_ps(inside, near));
 }
 
+#elif defined(__SSE2__)
+enum { SegmentLanes = 4 };
+
+inline __m128i
+sse_shuffle(__m128i a, __m128i b, int odd)
+{
+  return odd ?
+         _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1))) :
+         _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+/**
+ * @brief get the segments starting at p that may be closer than mindist
+ * @returns a bitmask of the candidate segments
+ */
+unsigned int
+segment_candidates(const lpos_t *p, int x, int y, float mindist)
+{
+  // x0 y0 x1 y1 and x2 y2 x3 y3
+  const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2));
+  const __m128i nlo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+  const __m128i nhi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3));
+  const __m128i px = sse_shuffle(lo, hi, 0);
+  const __m128i py = sse_shuffle(lo, hi, 1);
+  const __m128i nx = sse_shuffle(nlo, nhi, 0);
+  const __m128i ny = sse_shuffle(nlo, nhi, 1);
+
+  const __m128 dx = _mm_cvtepi32_ps(_mm_sub_epi32(nx, px));
+  const __m128 dy = _mm_cvtepi32_ps(_mm_sub_epi32(ny, py));
+  const __m128 ax = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(x), px));
+  const __m128 ay = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_set1_epi32(y), py));
+
+  const __m128 len = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+  const __m128 dot = _mm_add_ps(_mm_mul_ps(ax, dx), _mm_mul_ps(ay, dy));
+  const __m128 cross = _mm_sub_ps(_mm_mul_ps(ax, dy), _mm_mul_ps(ay, dx));
+
+  const __m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 md = _mm_set1_ps(mindist);
+  const __m128 size = _mm_add_ps(_mm_add_ps(_mm_and_ps(dx, absmask), _mm_and_ps(dy, absmask)), md);
+  const __m128 lim = _mm_add_ps(md, _mm_add_ps(_mm_mul_ps(size, _mm_set1_ps(segment_tolerance)),
+                                               _mm_set1_ps(segment_offset)));
+
+  const __m128 inside = _mm_and_ps(_mm_cmpge_ps(dot, _mm_mul_ps(len, _mm_set1_ps(segment_mmin))),
+                                   _mm_cmple_ps(dot, _mm_mul_ps(len, _mm_set1_ps(segment_mmax))));
+  const __m128 near = _mm_cmple_ps(_mm_mul_ps(cross, cross), _mm_mul_ps(_mm_mul_ps(lim, lim), len));
+
+  return _mm_movemask_ps(_mm_and_ps(inside, near));
+}
+
+#elif defined(__ARM_NEON)
+enum { SegmentLanes = 4 };
+
+/**
+ * @brief get the segments starting at p that may be closer than mindist
+ * @returns a bitmask of the candidate segments
+ */
+unsigned int
+segment_candidates(const lpos_t *p, int x, int y, float mindist)
+{
+  // the loads split the coordinates into x and y
+  const int32x4x2_t pos = vld2q_s32(reinterpret_cast<const int32_t *>(p));
+  const int32x4x2_t next = vld2q_s32(reinterpret_cast<const int32_t *>(p + 1));
+
+  const float32x4_t dx = vcvtq_f32_s32(vsubq_s32(next.val[0], pos.val[0]));
+  const float32x4_t dy = vcvtq_f32_s32(vsubq_s32(next.val[1], pos.val[1]));
+  const float32x4_t ax = vcvtq_f32_s32(vsubq_s32(vdupq_n_s32(x), pos.val[0]));
+  const float32x4_t ay = vcvtq_f32_s32(vsubq_s32(vdupq_n_s32(y), pos.val[1]));
+
+  const float32x4_t len = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+  const float32x4_t dot = vaddq_f32(vmulq_f32(ax, dx), vmulq_f32(ay, dy));
+  const float32x4_t cross = vsubq_f32(vmulq_f32(ax, dy), vmulq_f32(ay, dx));
+
+  const float32x4_t md = vdupq_n_f32(mindist);
+  const float32x4_t size = vaddq_f32(vaddq_f32(vabsq_f32(dx), vabsq_f32(dy)), md);
+  const float32x4_t lim = vaddq_f32(md, vaddq_f32(vmulq_f32(size, vdupq_n_f32(segment_tolerance)),
+                                                  vdupq_n_f32(segment_offset)));
+
+  const uint32x4_t inside = vandq_u32(vcgeq_f32(dot, vmulq_f32(len, vdupq_n_f32(segment_mmin))),
+                                      vcleq_f32(dot, vmulq_f32(len, vdupq_n_f32(segment_mmax))));
+  const uint32x4_t near = vcleq_f32(vmulq_f32(cross, cross), vmulq_f32(vmulq_f32(lim, lim), len));
+
+  const uint32_t laneBits[SegmentLanes] = { 1, 2, 4, 8 };
+  const uint32x4_t bits = vandq_u32(vandq_u32(inside, near), vld1q_u32(laneBits));
+  return vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2) | vgetq_lane_u32(bits, 3);
+}
+#endif
+
+} // namespace
+
 std::optional<unsigned int> canvas_item_info_poly::get_segment(int x, int y, float fuzziness) const
 {
-  unsigned int retval;
-  bool found = false;
+#ifdef SEGMENT_SIMD
+  std::optional<unsigned int> ret;
   float mindist = width / 2 + fuzziness;
-  for(unsigned int i = 0; i < num_points - 1; i++) {
-    const lpos_t pos = points[i];
-    const lpos_t posnext = points[i + 1];
-
-    const int dxi = posnext.x - pos.x;
-    const int dyi = posnext.y - pos.y;
-    const float dx = dxi;
-    const float dy = dyi;
-    float len = dy * dy + dx * dx;
-    float m = ((x - pos.x) * dx + (y - pos.y) * dy) / len;
-
-    /* this is a possible candidate */
-    if((m >= 0.0f) && (m <= 1.0f)) {
-
-      float n;
-      if(abs(dxi) > abs(dyi))
-        n = fabsf(sqrtf(len) * (pos.y - y + m * dy) / dx);
-      else
-        n = fabsf(sqrtf(len) * -(pos.x - x + m * dx) / dy);
-
-      /* check if this is actually on the line and closer than anything */
-      /* we found so far */
-      if(n < mindist) {
-        retval = i;
-        found = true;
-        mindist = n;
-      }
-    }
+  const lpos_t * const p = points.get();
+  const unsigned int segments = num_points - 1;
+
+  // the kernels read the points of SegmentLanes segments plus the last end point
+  unsigned int i = 0;
+  for(; i + SegmentLanes <= segments; i += SegmentLanes) {
+    unsigned int mask = segment_candidates(p + i, x, y, mindist);
+    // the segments are checked in order so the first one wins on equal distance
+    for(unsigned int lane = 0; mask != 0; lane++, mask >>= 1)
+      if(mask & 1)
+        segment_scan(p, i + lane, i + lane + 1, x, y, mindist, ret);
   }
 
+  segment_scan(p, i, segments, x, y, mindist, ret);
+
   /* the last and first point are identical for polygons in osm2go. */
   /* goocanvas doesn't need that, but that's how OSM works and it saves */
   /* us from having to check the last->first connection for polygons */
   /* seperately */
 
-  if (found)
-    return retval;
-  else
-    return std::optional<unsigned int>();
+  return ret;
+#else
+  return get_segment_scalar(x, y, fuzziness);
+#endif
+}
+
+std::optional<unsigned int> canvas_item_info_poly::get_segment_scalar(int x, int y, float fuzziness) const
+{
+  std::optional<unsigned int> ret;
+  float mindist = width / 2 + fuzziness;
+
+  segment_scan(points.get(), 0, num_points - 1, x, y, mindist, ret);
+
+  return ret;
+}
+
+namespace {
+
+/* check whether a given point is inside a polygon */
+/* inpoly() taken from https://www.visibone.com/inpoly/ */
+bool
+inpoly(const canvas_item_info_poly *poly, int x, int y, int fuzziness)
+{
+  if(poly->num_points < 3)
+    return false;
+
+  lpos_t oldPos = poly->points[poly->num_points - 1];
+  bool inside = false;
+
+  for (unsigned i = 0 ; i < poly->num_points ; i++) {
+    float x1, y1, x2, y2;
+    lpos_t newPos = poly->points[i];
+
+    // in contrast to the original algorithm we want to consider the corners as always inside the polygon
+    // the distance is calculated as float as it may be far away for big polygons
+    const float dx = x - newPos.x;
+    const float dy = y - newPos.y;
+    float dist_sq = dx * dx + dy * dy;
+    if (dist_sq < fuzziness * fuzziness)
+      return true;
+
+    if (newPos.x > oldPos.x) {
+      x1 = oldPos.x;
+      x2 = newPos.x;
+      y1 = oldPos.y;
+      y2 = newPos.y;
+    } else {
+      x1 = newPos.x;
+      x2 = oldPos.x;
+      y1 = newPos.y;
+      y2 = oldPos.y;
+    }
+    if ((newPos.x < x) == (x <= oldPos.x)          /* edge "open" at one end */
+        && (y - y1) * (x2 - x1) < (y2 - y1) * (x - x1))
+      inside = !inside;
+
+    oldPos = newPos;
+  }
+
+  return inside;
+}
+
+class item_at_functor {
+  const int x;
+  const int y;
+  const float ffuzziness;
+public:
+  const int fuzziness;
+  inline item_at_functor(const lpos_t pos, float f)
+    : x(pos.x), y(pos.y), ffuzziness(f), fuzziness(f) {}
+  bool operator()(const canvas_item_info_t *item) const;
+};
+
+bool item_at_functor::operator()(const canvas_item_info_t *item) const
+{
+  switch(item->type) {
+  case CANVAS_ITEM_CIRCLE: {
+    const canvas_item_info_circle *circle = static_cast<const canvas_item_info_circle *>(item);
+    int xdist = circle->center.x - x;
+    int ydist = circle->center.y - y;
+    return (xdist * xdist + ydist * ydist <
+           (static_cast<int>(circle->radius) + fuzziness) * (static_cast<int>(circle->radius) + fuzziness));
+  }
+
+  case CANVAS_ITEM_POLY: {
+    const canvas_item_info_poly *poly = static_cast<const canvas_item_info_poly *>(item);
+    return poly->get_segment(x, y, ffuzziness) || (poly->is_polygon && inpoly(poly, x, y, fuzziness));
+  }
+  }
+  assert_unreachable();
+}
+
+} // namespace
+
+/**
+ * @brief call f.cell(key) for every cell the item is stored in
+ *
+ * If the item is too big f.large() is called instead.
+ */
+template<typename F>
+void canvas_hit_index_t::forItemCells(const canvas_item_info_t *info, F &f)
+{
+  lpos_t bmin, bmax;
+
+  if(info->type == CANVAS_ITEM_CIRCLE) {
+    const canvas_item_info_circle *circle = static_cast<const canvas_item_info_circle *>(info);
+    const int r = circle->radius;
+    bmin = lpos_t(circle->center.x - r, circle->center.y - r);
+    bmax = lpos_t(circle->center.x + r, circle->center.y + r);
+  } else {
+    const canvas_item_info_poly *poly = static_cast<const canvas_item_info_poly *>(info);
+    const int w = static_cast<int>(ceilf(poly->width / 2));
+
+    if(!poly->is_polygon) {
+      // a single pass to find out if one of the segments is too big, the
+      // item must either be stored in the cells or in the large list
+      for(unsigned int i = 1; i < poly->num_points; i++) {
+        const lpos_t a = poly->points[i - 1];
+        const lpos_t b = poly->points[i];
+        const int xmin = cellCoord(std::min(a.x, b.x) - w);
+        const int xmax = cellCoord(std::max(a.x, b.x) + w);
+        const int ymin = cellCoord(std::min(a.y, b.y) - w);
+        const int ymax = cellCoord(std::max(a.y, b.y) + w);
+        if((xmax - xmin + 1) * (ymax - ymin + 1) > MaxCells) {
+          f.large();
+          return;
+        }
+      }
+
+      for(unsigned int i = 1; i < poly->num_points; i++) {
+        const lpos_t a = poly->points[i - 1];
+        const lpos_t b = poly->points[i];
+        const int xmin = cellCoord(std::min(a.x, b.x) - w);
+        const int xmax = cellCoord(std::max(a.x, b.x) + w);
+        const int ymin = cellCoord(std::min(a.y, b.y) - w);
+        const int ymax = cellCoord(std::max(a.y, b.y) + w);
+        for(int cx = xmin; cx <= xmax; cx++)
+          for(int cy = ymin; cy <= ymax; cy++)
+            f.cell(cellKey(cx, cy));
+      }
+      return;
+    }
+
+    // the inside of polygons is also a hit, so all cells are needed
+    bmin = bmax = poly->points[0];
+    for(unsigned int i = 1; i < poly->num_points; i++) {
+      const lpos_t p = poly->points[i];
+      bmin.x = std::min(bmin.x, p.x);
+      bmin.y = std::min(bmin.y, p.y);
+      bmax.x = std::max(bmax.x, p.x);
+      bmax.y = std::max(bmax.y, p.y);
+    }
+    bmin.x -= w;
+    bmin.y -= w;
+    bmax.x += w;
+    bmax.y += w;
+  }
+
+  const int xmin = cellCoord(bmin.x);
+  const int xmax = cellCoord(bmax.x);
+  const int ymin = cellCoord(bmin.y);
+  const int ymax = cellCoord(bmax.y);
+  if((xmax - xmin + 1) * (ymax - ymin + 1) > MaxCells) {
+    f.large();
+    return;
+  }
+
+  for(int cx = xmin; cx <= xmax; cx++)
+    for(int cy = ymin; cy <= ymax; cy++)
+      f.cell(cellKey(cx, cy));
+}
+
+class canvas_hit_index_t::insert_functor {
+  canvas_hit_index_t &index;
+  canvas_item_info_t * const info;
+public:
+  inline insert_functor(canvas_hit_index_t &i, canvas_item_info_t *n) : index(i), info(n) {}
+
+  inline void large()
+  { index.large.push_back(info); }
+  inline void cell(uint64_t key)
+  {
+    std::vector<canvas_item_info_t *> &entries = index.cells[key];
+    // consecutive segments are often in the same cell
+    if(entries.empty() || entries.back() != info)
+      entries.push_back(info);
+  }
+};
+
+class canvas_hit_index_t::erase_functor {
+  canvas_hit_index_t &index;
+  const canvas_item_info_t * const info;
+public:
+  inline erase_functor(canvas_hit_index_t &i, const canvas_item_info_t *n) : index(i), info(n) {}
+
+  inline void large()
+  { index.large.erase(std::remove(index.large.begin(), index.large.end(), info), index.large.end()); }
+  void cell(uint64_t key)
+  {
+    const CellMap::iterator it = index.cells.find(key);
+    // the cell is gone if the item was already removed from it
+    if(it == index.cells.end())
+      return;
+    std::vector<canvas_item_info_t *> &entries = it->second;
+    entries.erase(std::remove(entries.begin(), entries.end(), info), entries.end());
+    if(entries.empty())
+      index.cells.erase(it);
+  }
+};
+
+void canvas_hit_index_t::insert(canvas_item_info_t *info)
+{
+  info->stacking = ++top;
+
+  insert_functor fc(*this, info);
+  forItemCells(info, fc);
+}
+
+void canvas_hit_index_t::erase(canvas_item_info_t *info)
+{
+  erase_functor fc(*this, info);
+  forItemCells(info, fc);
+}
+
+/**
+ * @brief find the topmost visible candidate that is actually hit
+ *
+ * The stacking is checked first, so the more expensive hit test is only done
+ * for candidates that would be better than the current result.
+ */
+class canvas_hit_index_t::find_functor {
+  const item_at_functor hit;
+  const double zoom;
+public:
+  const canvas_item_info_t *ret;
+
+  inline find_functor(lpos_t pos, float fuzziness, double z)
+    : hit(pos, fuzziness), zoom(z), ret(nullptr) {}
+
+  void operator()(const canvas_item_info_t *info)
+  {
+    if(ret != nullptr && !info->above(ret))
+      return;
+    if(info->zoom_max > 0 && zoom < info->zoom_max)
+      return;
+    if(hit(info))
+      ret = info;
+  }
+
+  inline void operator()(int, int, const std::vector<canvas_item_info_t *> &cell)
+  {
+    const std::vector<canvas_item_info_t *>::const_iterator itEnd = cell.end();
+    for(std::vector<canvas_item_info_t *>::const_iterator it = cell.begin(); it != itEnd; it++)
+      operator()(*it);
+  }
+};
+
+const canvas_item_info_t *canvas_hit_index_t::find(lpos_t pos, float fuzziness, double zoom) const
+{
+  find_functor fc(pos, fuzziness, zoom);
+
+  const int f = fuzziness;
+  forCells(cells, lpos_t(pos.x - f, pos.y - f), lpos_t(pos.x + f, pos.y + f), fc);
+  fc(0, 0, large);
+
+  return fc.ret;
+}
+
+/* try to find the object at position x/y by searching through the */
+/* item_info list */
+canvas_item_t *canvas_t::get_item_at(lpos_t pos) const
+{
+  const double zoom = get_zoom();
+  /* convert all "fuzziness" into meters */
+  const float fuzziness = EXTRA_FUZZINESS_METER + EXTRA_FUZZINESS_PIXEL / zoom;
+
+  const canvas_item_info_t *info = hit_index->find(pos, fuzziness, zoom);
+
+  return info == nullptr ? nullptr : info->item;
+}
+
+canvas_item_t *canvas_t::get_next_item_at(lpos_t pos, canvas_item_t *oldtop) const
+{
+  const item_mapping_t::const_iterator it = item_mapping.find(oldtop);
+  if(likely(it != item_mapping.end()))
+    hit_index->lower(it->second);
+  oldtop->lower();
+
+  return get_item_at(pos);
+}
+
+void canvas_t::set_item_zoom_max(canvas_item_t *item, float zoom_max)
+{
+  item->set_zoom_max(zoom_max);
+
+  const item_mapping_t::const_iterator it = item_mapping.find(item);
+  if(it != item_mapping.end())
+    it->second->zoom_max = zoom_max;
 }
 
 void map_item_destroyer::run(canvas_item_t *)
@@ -10,6 +10,7 @@
 #include "pos.h"
 
 #include <array>
+#include <memory>
 #include <optional>
 #include <unordered_map>
 #include <vector>
@@ -50,6 +51,7 @@ typedef enum {
 #error "More than 16 canvas groups needs adjustment e.g. in map.cpp"
 #endif
 
+class canvas_hit_index_t;
 class canvas_item_info_t;
 class icon_item;
 struct map_item_t;
@@ -63,10 +65,29 @@ struct canvas_item_t {
   static void operator delete(void *ptr);
 
   /****** manipulating items ******/
+  /**
+   * @brief hide the item if the zoom is below the given value
+   *
+   * Selectable items should use canvas_t::set_item_zoom_max() instead so
+   * hidden items are not found by canvas_t::get_item_at().
+   */
   void set_zoom_max(float zoom_max);
   void set_dashed(float line_width, unsigned int dash_length_on,
                   unsigned int dash_length_off);
 
+  /**
+   * @brief show the item below all other items of its group
+   */
+  void lower();
+
+  /**
+   * @brief change the points that are drawn for a polyline or polygon
+   *
+   * This is meant to show a simplified version of the shape. The points used
+   * to check if the item is hit are not changed.
+   */
+  void set_shape(const std::vector<lpos_t> &points);
+
   /**
    * @brief associates the map item with this canvas item
    *
@@ -118,6 +139,34 @@ struct canvas_item_pixmap : public canvas_item_t {
   canvas_item_pixmap &operator=(const canvas_item_pixmap &) O2G_DELETED_FUNCTION;
 };
 
+/**
+ * @brief a polyline or polygon to be created by canvas_t::poly_batch_new()
+ */
+struct canvas_poly_t {
+  inline canvas_poly_t(bool poly, float w, color_t c, color_t f = color_t::transparent())
+    : width(w), color(c), fill(f), polygon(poly) {}
+
+  std::vector<lpos_t> points;
+  float width;
+  color_t color;
+  color_t fill;     ///< the fill color of polygons
+  bool polygon;
+};
+
+/**
+ * @brief a circle to be created by canvas_t::circle_batch_new()
+ */
+struct canvas_circle_t {
+  inline canvas_circle_t(lpos_t c, float r, int b, color_t f, color_t bc)
+    : center(c), radius(r), border(b), fill(f), border_color(bc) {}
+
+  lpos_t center;
+  float radius;
+  int border;
+  color_t fill;
+  color_t border_color;
+};
+
 class canvas_t {
 protected:
   explicit canvas_t(osm2go_platform::Widget *w);
@@ -126,6 +175,12 @@ public:
   osm2go_platform::Widget * const widget;
   typedef std::unordered_map<const canvas_item_t *, canvas_item_info_t *> item_mapping_t;
   item_mapping_t item_mapping;
+  /**
+   * @brief the positions and stacking of the items in item_mapping
+   */
+  const std::unique_ptr<canvas_hit_index_t> hit_index;
+
+  ~canvas_t();
 
   lpos_t window2world(const osm2go_platform::screenpos &p) const;
 
@@ -155,6 +210,8 @@ public:
 
   /**
    * @brief get the top item at the given position
+   *
+   * Only selectable items that are not hidden at the current zoom are found.
    */
   canvas_item_t *get_item_at(lpos_t pos) const;
 
@@ -204,6 +261,38 @@ public:
                              color_t fill);
   canvas_item_pixmap *image_new(canvas_group_t group, icon_item *icon, lpos_t pos, float scale);
 
+  /**
+   * @brief create many polylines and polygons in one group
+   * @param group the group of all new items
+   * @param polys the shapes and their styles
+   * @param items the new items are appended here in the order of polys
+   *
+   * The item lookup is prepared for the number of new items. Only the Qt
+   * backend gains more from this: it suspends the scene index for big
+   * batches and builds it once afterwards. GooCanvas already defers the
+   * updates of new items until the next redraw, so the items are simply
+   * created one by one there.
+   */
+  void poly_batch_new(canvas_group_t group, const std::vector<canvas_poly_t> &polys,
+                      std::vector<canvas_item_t *> &items);
+
+  /**
+   * @brief create many circles in one group
+   * @param group the group of all new items
+   * @param circles the positions and styles of the circles
+   * @param items the new items are appended here in the order of circles
+   *
+   * @see poly_batch_new
+   */
+  void circle_batch_new(canvas_group_t group, const std::vector<canvas_circle_t> &circles,
+                        std::vector<canvas_item_circle *> &items);
+
+  /**
+   * @brief hide the item if the zoom is below the given value
+   * @see canvas_item_t::set_zoom_max
+   */
+  void set_item_zoom_max(canvas_item_t *item, float zoom_max);
+
   /**
    * @brief get the polygon/polyway segment a certain coordinate is over
    */
@@ -216,4 +305,11 @@ public:
    * The coordinate must be within the project bounds.
    */
   bool ensureVisible(const lpos_t lpos);
+
+  /**
+   * @brief get the part of the map that is currently shown on screen
+   * @param min returns the top left corner
+   * @param max returns the bottom right corner
+   */
+  void visible_area(lpos_t &min, lpos_t &max) const;
 };
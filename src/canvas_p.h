@@ -7,8 +7,10 @@
 #pragma once
 
 #include "canvas.h"
+#include "grid_cells.h"
 #include "pos.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -27,16 +29,30 @@ enum canvas_item_type_t { CANVAS_ITEM_CIRCLE, CANVAS_ITEM_POLY };
 
 class canvas_item_info_t {
 protected:
-  canvas_item_info_t(canvas_item_type_t t, canvas_t *cv, canvas_item_t *it, canvas_item_destroyer *d);
+  canvas_item_info_t(canvas_item_type_t t, canvas_t *cv, canvas_group_t g, canvas_item_t *it,
+                     canvas_item_destroyer *d);
   inline ~canvas_item_info_t() {}
 public:
 
   const canvas_item_type_t type;
+  const canvas_group_t group;
+  canvas_item_t * const item;
+  int64_t stacking;   ///< the position inside the group, higher values are on top
+  float zoom_max;     ///< the item is hidden if the zoom is below this
+
+  /**
+   * @brief check if this item is above the other one
+   */
+  inline bool above(const canvas_item_info_t *other) const
+  {
+    return group > other->group || (group == other->group && stacking > other->stacking);
+  }
 };
 
 class canvas_item_info_circle : public canvas_item_info_t {
 public:
-  canvas_item_info_circle(canvas_t *cv, canvas_item_t *it, lpos_t c, const unsigned int r);
+  canvas_item_info_circle(canvas_t *cv, canvas_group_t g, canvas_item_t *it, lpos_t c,
+                          const unsigned int r);
 
   const lpos_t center;
   const unsigned int radius;
@@ -44,7 +60,7 @@ public:
 
 class canvas_item_info_poly : public canvas_item_info_t {
 public:
-  canvas_item_info_poly(canvas_t *cv, canvas_item_t *it, bool poly,
+  canvas_item_info_poly(canvas_t *cv, canvas_group_t g, canvas_item_t *it, bool poly,
                         float wd, const std::vector<lpos_t> &p);
 
   bool is_polygon;
@@ -55,6 +71,64 @@ public:
 
   /**
    * @brief get the polygon/polyway segment a certain coordinate is over
+   *
+   * Several segments are checked at once with SIMD instructions if
+   * available, the result is the same as the one of get_segment_scalar().
    */
   std::optional<unsigned int> get_segment(int x, int y, float fuzziness) const;
+
+  /**
+   * @brief the plain implementation of get_segment() checking one segment at a time
+   */
+  std::optional<unsigned int> get_segment_scalar(int x, int y, float fuzziness) const;
+};
+
+/**
+ * @brief a uniform grid over the selectable items of the canvas
+ *
+ * Circles and polygons are stored in all cells their bounding box touches,
+ * polylines only in the cells touched by the bounding boxes of their
+ * segments, so long diagonal ways do not clutter unrelated cells. Items that
+ * would need more than MaxCells cells at once are kept in a separate list
+ * that is checked on every query.
+ *
+ * The index also tracks the stacking order of the items, so the result of a
+ * query does not depend on the toolkit.
+ */
+class canvas_hit_index_t : public grid_cells_t<128> {
+  typedef std::unordered_map<uint64_t, std::vector<canvas_item_info_t *> > CellMap;
+  CellMap cells;
+  std::vector<canvas_item_info_t *> large;
+  int64_t top;       ///< stacking of the last item put on top
+  int64_t bottom;    ///< stacking of the last item put to the bottom
+
+  template<typename F> static void forItemCells(const canvas_item_info_t *info, F &f);
+
+  class insert_functor;
+  class erase_functor;
+  class find_functor;
+public:
+  enum { MaxCells = 64 };
+
+  inline canvas_hit_index_t() : top(0), bottom(0) {}
+
+  /**
+   * @brief add a new item on top of all other items of its group
+   */
+  void insert(canvas_item_info_t *info);
+  void erase(canvas_item_info_t *info);
+
+  /**
+   * @brief move the item below all other items of its group
+   */
+  inline void lower(canvas_item_info_t *info)
+  { info->stacking = --bottom; }
+
+  /**
+   * @brief get the topmost item at the given position
+   * @param pos the position to check
+   * @param fuzziness how far besides the items the position may be
+   * @param zoom the current zoom, items hidden at this zoom are ignored
+   */
+  const canvas_item_info_t *find(lpos_t pos, float fuzziness, double zoom) const;
 };
@@ -312,7 +312,7 @@ T *restore_object(xmlNodePtr xml_node, osm_t::ref osm)
     if(id < 0) {
       printf("  Restoring NEW object\n");
 
-      ret = new T(base_attributes(id));
+      ret = new(osm->pools.get<T>()) T(base_attributes(id));
 
       osm->insert(ret);
     } else {
@@ -345,10 +345,8 @@ diff_restore_node(xmlNodePtr node_node, osm_t::ref osm)
     return;
   }
   bool pos_diff = node->isNew() || node->pos != pos;
-  if (pos_diff) {
-    node->pos = pos;
-    node->lpos = node->pos.toLpos(osm->bounds);
-  }
+  if (pos_diff)
+    osm->node_move(node, pos);
 
   osm_t::TagMap ntags = xml_scan_tags(node_node->children);
   /* check if the same changes have been done upstream */
@@ -359,6 +357,7 @@ diff_restore_node(xmlNodePtr node_node, osm_t::ref osm)
   }
 
   node->tags.replace(ntags);
+  osm->addTagRefs(object_t(node));
 }
 
 void
@@ -395,10 +394,12 @@ diff_restore_way(xmlNodePtr node_way, osm_t::ref osm)
     way->node_chain.swap(new_chain);
     osm_node_chain_unref(new_chain);
     new_chain.clear();
+    osm->addNodeWayRefs(way);
 
     osm_t::TagMap ntags = xml_scan_tags(node_way->children);
     if (way->tags != ntags) {
       way->tags.replace(ntags);
+      osm->addTagRefs(object_t(way));
     } else if (!ntags.empty()) {
       if (sameChain) {
         printf("way " ITEM_ID_FORMAT " has the same nodes and tags as upstream, discarding diff\n", way->id);
@@ -425,6 +426,7 @@ diff_restore_relation(xmlNodePtr node_rel, osm_t::ref osm)
   osm_t::TagMap ntags = xml_scan_tags(node_rel->children);
   if(relation->tags != ntags) {
     relation->tags.replace(ntags);
+    osm->addTagRefs(object_t(relation));
     was_changed = true;
   }
 
@@ -446,6 +448,7 @@ diff_restore_relation(xmlNodePtr node_rel, osm_t::ref osm)
     /* this may be an existing relation, so remove members to */
     /* make space for new ones */
     relation->members.swap(members);
+    osm->addMemberRefs(relation);
     was_changed = true;
   }
 
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Rolf Eike Beer <eike@sf-mail.de>
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "pos.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <osm2go_annotations.h>
+
+/**
+ * @brief the cell handling shared by the spatial indexes
+ *
+ * The cells are squares of CellSize local units. They are kept in a hash map
+ * so the empty parts of the project do not need any memory.
+ */
+template<int S> class grid_cells_t {
+protected:
+  static inline uint64_t cellKey(int cx, int cy) noexcept
+  { return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy); }
+  static inline int cellCoord(int c) noexcept
+  {
+    // round towards negative infinity so cells do not overlap around 0
+    return c >= 0 ? c / CellSize : -((-c - 1) / CellSize) - 1;
+  }
+  static inline uint64_t cellKey(lpos_t pos) noexcept
+  { return cellKey(cellCoord(pos.x), cellCoord(pos.y)); }
+
+  /**
+   * @brief call f(cx, cy, cell) for every existing cell intersecting the given area
+   *
+   * If the area covers more cells than exist the existing cells are scanned
+   * instead of looking up every possible one.
+   */
+  template<typename T, typename F>
+  static void forCells(const std::unordered_map<uint64_t, T> &cells, lpos_t min, lpos_t max, F &f)
+  {
+    if(unlikely(min.x > max.x || min.y > max.y))
+      return;
+
+    const int xmin = cellCoord(min.x);
+    const int xmax = cellCoord(max.x);
+    const int ymin = cellCoord(min.y);
+    const int ymax = cellCoord(max.y);
+    typedef typename std::unordered_map<uint64_t, T>::const_iterator Iter;
+    const Iter citEnd = cells.end();
+
+    if(static_cast<uint64_t>(xmax - xmin + 1) * static_cast<uint64_t>(ymax - ymin + 1) > cells.size()) {
+      for(Iter cit = cells.begin(); cit != citEnd; cit++) {
+        const int cx = static_cast<int32_t>(cit->first >> 32);
+        const int cy = static_cast<int32_t>(cit->first & 0xffffffff);
+        if(cx >= xmin && cx <= xmax && cy >= ymin && cy <= ymax)
+          f(cx, cy, cit->second);
+      }
+      return;
+    }
+
+    for(int cx = xmin; cx <= xmax; cx++) {
+      for(int cy = ymin; cy <= ymax; cy++) {
+        const Iter cit = cells.find(cellKey(cx, cy));
+        if(cit != citEnd)
+          f(cx, cy, cit->second);
+      }
+    }
+  }
+
+public:
+  enum { CellSize = S };
+};
@@ -26,7 +26,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "osm2go_annotations.h"
@@ -44,6 +46,11 @@ struct map_bg_modifier {
   {
     map->background_items[way] = item;
   }
+  static inline map_item_t *get(map_t *map, visible_item_t *way)
+  {
+    std::unordered_map<visible_item_t *, map_item_t *>::const_iterator it = map->background_items.find(way);
+    return it == map->background_items.end() ? nullptr : it->second;
+  }
 };
 
 void map_bg_modifier::remove(map_t *map, visible_item_t *way)
@@ -154,6 +161,123 @@ points_from_node_chain(const way_t *way)
   return points;
 }
 
+} // namespace
+
+namespace {
+
+/**
+ * @brief the squared distance of p to the segment from a to b
+ */
+float segment_distance2(lpos_t p, lpos_t a, lpos_t b)
+{
+  const float dx = b.x - a.x;
+  const float dy = b.y - a.y;
+  const float len2 = dx * dx + dy * dy;
+  float px = p.x - a.x;
+  float py = p.y - a.y;
+
+  if(likely(len2 > 0)) {
+    const float m = std::max(0.0f, std::min(1.0f, (px * dx + py * dy) / len2));
+    px -= m * dx;
+    py -= m * dy;
+  }
+
+  return px * px + py * py;
+}
+
+struct lod_range {
+  inline lod_range(unsigned int f, unsigned int l, float lim) : first(f), last(l), limit(lim) {}
+  unsigned int first, last;
+  float limit;    ///< the importance of the point that split this range off
+};
+
+} // namespace
+
+way_lod_t::way_lod_t(const std::vector<lpos_t> &p)
+  : points(p)
+  , importance(p.size(), 0.0f)
+{
+  assert_cmpnum_op(points.size(), >=, 2);
+
+  const float keep = std::numeric_limits<float>::max();
+  importance.front() = keep;
+  importance.back() = keep;
+
+  std::vector<lod_range> ranges(1, lod_range(0, points.size() - 1, keep));
+  while(!ranges.empty()) {
+    const lod_range r = ranges.back();
+    ranges.pop_back();
+    if(r.last - r.first < 2)
+      continue;
+
+    unsigned int split = r.first + 1;
+    float maxd = -1.0f;
+    for(unsigned int i = r.first + 1; i < r.last; i++) {
+      const float d = segment_distance2(points[i], points[r.first], points[r.last]);
+      if(d > maxd) {
+        maxd = d;
+        split = i;
+      }
+    }
+
+    // a point must never be more important than the one it depends on,
+    // otherwise it could be kept while that one is dropped
+    const float imp = std::min(sqrtf(maxd), r.limit);
+    importance[split] = imp;
+    ranges.push_back(lod_range(r.first, split, imp));
+    ranges.push_back(lod_range(split, r.last, imp));
+  }
+}
+
+std::vector<lpos_t> way_lod_t::simplified(float tolerance) const
+{
+  std::vector<lpos_t> ret;
+  ret.reserve(points.size());
+
+  const size_t cnt = points.size();
+  for(size_t i = 0; i < cnt; i++)
+    if(importance[i] >= tolerance)
+      ret.push_back(points[i]);
+
+  return ret;
+}
+
+namespace {
+
+/**
+ * @brief get the level of detail for the given zoom
+ *
+ * The zoom levels are grouped into bands so the ways do not need to be
+ * updated on every zoom step. Band 0 means full resolution, band n removes
+ * details smaller than 2^(n-1) canvas units, which is at most one pixel.
+ */
+unsigned int lodBandForZoom(double zoom)
+{
+  const unsigned int maxBand = 7;
+  const double tolerance = 1.0 / zoom;
+  unsigned int band = 0;
+  while(band < maxBand && (1u << band) <= tolerance)
+    band++;
+  return band;
+}
+
+inline float lodTolerance(unsigned int band)
+{
+  return band == 0 ? 0.0f : static_cast<float>(1u << (band - 1));
+}
+
+/**
+ * @brief show the simplified shape of the way on the canvas items
+ */
+void lod_apply(const map_item_t *item, map_item_t *bg, float tolerance)
+{
+  const way_lod_t * const lod = item->lod.get();
+  const std::vector<lpos_t> &shown = tolerance > 0.0f ? lod->simplified(tolerance) : lod->points;
+  item->item->set_shape(shown);
+  if(bg != nullptr)
+    bg->item->set_shape(shown);
+}
+
 class draw_selected_way_functor {
   node_t *last;
   const float arrow_width;
@@ -321,6 +445,29 @@ static void map_object_select(map_t *map, const object_t &object)
   }
 }
 
+void map_t::select_object(const object_t &object)
+{
+  item_deselect();
+
+  // scroll first, the object may only get a canvas item once it is close to
+  // the visible area
+  switch(object.type) {
+  case object_t::NODE:
+    scroll_to_if_offscreen(static_cast<node_t *>(object)->lpos);
+    break;
+  case object_t::WAY: {
+    const way_t * const way = static_cast<way_t *>(object);
+    if(!way->node_chain.empty())
+      scroll_to_if_offscreen(way->node_chain.front()->lpos);
+    break;
+  }
+  default:
+    break;
+  }
+
+  map_object_select(this, object);
+}
+
 void map_t::item_deselect() {
 
   /* save tags for "last" function in info dialog */
@@ -345,63 +492,135 @@ void map_t::item_deselect() {
   selected.object.type = object_t::ILLEGAL;
 }
 
-static void
-map_node_new(map_t *map, node_t *node, float radius, int width, color_t fill, color_t border)
+/**
+ * @brief collects the canvas items of the objects to draw
+ *
+ * The items are created group by group once flush() is called, which is a
+ * lot faster than creating them one by one.
+ */
+class map_draw_batch {
+  map_t * const map;
+  const float tolerance;    ///< the simplification of long ways at the current zoom
+
+  std::array<std::vector<canvas_poly_t>, CANVAS_GROUPS> polys;
+  std::array<std::vector<way_t *>, CANVAS_GROUPS> polyOwners;
+  std::array<std::vector<canvas_circle_t>, CANVAS_GROUPS> circles;
+  std::array<std::vector<object_t>, CANVAS_GROUPS> circleOwners;
+
+  void attach(canvas_group_t group, way_t *way, const canvas_poly_t &poly, canvas_item_t *item);
+  void attach(const object_t &obj, canvas_item_t *item);
+public:
+  explicit map_draw_batch(map_t *m)
+    : map(m), tolerance(lodTolerance(lodBandForZoom(m->appdata.project->map_state.zoom))) {}
+
+  /**
+   * @brief queue a polyline or polygon for the given way
+   * @returns the new entry so the points can be filled in
+   *
+   * Items in CANVAS_GROUP_WAYS_OL are the background of the way.
+   */
+  canvas_poly_t &add(canvas_group_t group, way_t *way, bool polygon, float width, color_t color,
+                     color_t fill = color_t::transparent())
+  {
+    polyOwners[group].push_back(way);
+    polys[group].push_back(canvas_poly_t(polygon, width, color, fill));
+    return polys[group].back();
+  }
+
+  void add(canvas_group_t group, const object_t &obj, const canvas_circle_t &circle)
+  {
+    circleOwners[group].push_back(obj);
+    circles[group].push_back(circle);
+  }
+
+  /**
+   * @brief add an item that can't be batched
+   */
+  inline void add(const object_t &obj, canvas_item_t *item)
+  { attach(obj, item); }
+
+  void flush();
+};
+
+void map_draw_batch::attach(canvas_group_t group, way_t *way, const canvas_poly_t &poly, canvas_item_t *item)
 {
-  map_item_t *map_item = new map_item_t(object_t(node));
+  map_item_t *map_item = new map_item_t(object_t(way), item);
 
-  style_t::IconCache::const_iterator it;
+  map->canvas->set_item_zoom_max(item, way->zoom_max / (2 * map->appdata.project->map_state.detail));
 
-  const float detail = map->appdata.project->map_state.detail;
-  if(!map->style->icon.enable ||
-     (it = map->style->node_icons.find(node->id)) == map->style->node_icons.end())
-    map_item->item = map->canvas->circle_new(CANVAS_GROUP_NODES, node->lpos,
-       radius, width, fill, border);
-  else
-    map_item->item = map->canvas->image_new(CANVAS_GROUP_NODES, it->second, node->lpos,
-                                            detail * map->style->icon.scale);
+  /* a ways outline itself is never dashed */
+  if (group != CANVAS_GROUP_WAYS_OL && way->draw.dash_length_on > 0)
+    item->set_dashed(poly.width, way->draw.dash_length_on, way->draw.dash_length_off);
 
-  map_item->item->set_zoom_max(node->zoom_max / (2 * detail));
+  item->set_user_data(map_item);
 
-  /* attach map_item to nodes map_item_chain */
-  if(node->map_item != nullptr)
-    delete node->map_item->item;
-  node->map_item = map_item;
+  if(group == CANVAS_GROUP_WAYS_OL) {
+    map_bg_modifier::add(map, way, map_item);
+    return;
+  }
+
+  way->map_item = map_item;
 
-  map_item->item->set_user_data(map_item);
+  if(poly.points.size() >= way_lod_t::MinPoints) {
+    map_item->lod.reset(new way_lod_t(poly.points));
+    // the background group is created first, so it is already known
+    if(tolerance > 0.0f)
+      lod_apply(map_item, map_bg_modifier::get(map, way), tolerance);
+  }
 }
 
-static map_item_t *map_way_new(map_t *map, canvas_group_t group,
-                               way_t *way, const std::vector<lpos_t> &points, float width,
-                               color_t color, color_t fill_color)
+void map_draw_batch::attach(const object_t &obj, canvas_item_t *item)
 {
-  map_item_t *map_item = new map_item_t(object_t(way));
+  map_item_t *map_item = new map_item_t(obj, item);
 
-  if(way->draw.flags & OSM_DRAW_FLAG_AREA) {
-    if(!map->style->area.color.is_transparent())
-      map_item->item = map->canvas->polygon_new(group, points, width, color, fill_color);
-    else
-      map_item->item = map->canvas->polyline_new(group, points, width, color);
-  } else {
-    map_item->item = map->canvas->polyline_new(group, points, width, color);
+  if(obj.type == object_t::NODE) {
+    const node_t * const node = static_cast<node_t *>(obj);
+    map->canvas->set_item_zoom_max(item, node->zoom_max / (2 * map->appdata.project->map_state.detail));
   }
+  // TODO: decide: do we need canvas_item_t::set_zoom_max() for ways with a single node too?
 
-  map_item->item->set_zoom_max(way->zoom_max / (2 * map->appdata.project->map_state.detail));
+  static_cast<visible_item_t *>(static_cast<base_object_t *>(obj))->map_item = map_item;
 
-  /* a ways outline itself is never dashed */
-  if (group != CANVAS_GROUP_WAYS_OL && way->draw.dash_length_on > 0)
-    map_item->item->set_dashed(width, way->draw.dash_length_on, way->draw.dash_length_off);
+  item->set_user_data(map_item);
+}
 
-  map_item->item->set_user_data(map_item);
+void map_draw_batch::flush()
+{
+  std::vector<canvas_item_t *> items;
+  std::vector<canvas_item_circle *> citems;
+
+  for(unsigned int g = 0; g < CANVAS_GROUPS; g++) {
+    const canvas_group_t group = static_cast<canvas_group_t>(g);
+
+    if(!polys[g].empty()) {
+      items.clear();
+      map->canvas->poly_batch_new(group, polys[g], items);
+      assert_cmpnum(items.size(), polys[g].size());
+      for(size_t i = 0; i < items.size(); i++)
+        attach(group, polyOwners[g][i], polys[g][i], items[i]);
+      polys[g].clear();
+      polyOwners[g].clear();
+    }
 
-  return map_item;
+    if(!circles[g].empty()) {
+      citems.clear();
+      map->canvas->circle_batch_new(group, circles[g], citems);
+      assert_cmpnum(citems.size(), circles[g].size());
+      for(size_t i = 0; i < citems.size(); i++)
+        attach(circleOwners[g][i], citems[i]);
+      circles[g].clear();
+      circleOwners[g].clear();
+    }
+  }
 }
 
 class map_way_draw_functor {
   map_t * const map;
+  map_draw_batch &batch;
   const style_t * const style;
 public:
-  explicit inline map_way_draw_functor(map_t *m, const style_t *s = nullptr) : map(m), style(s) {}
+  explicit inline map_way_draw_functor(map_t *m, map_draw_batch &b, const style_t *s = nullptr)
+    : map(m), batch(b), style(s) {}
   void operator()(way_t *way);
   inline void operator()(std::pair<item_id_t, way_t *> pair) {
     style->colorize(pair.second);
@@ -418,54 +637,55 @@ void map_way_draw_functor::operator()(way_t *way)
   if(unlikely(map->appdata.project->osm->wayIsHidden(way)))
     return;
 
-  /* attach map_item to ways map_item_chain */
+  /* remove the old items, the new ones are attached once they are created */
   if(way->map_item != nullptr) {
     delete way->map_item->item;
-    // no need to reset map_item, it will immediately be overwritten
+    way->map_item = nullptr;
     map_bg_modifier::remove(map, way);
   }
 
   /* allocate space for nodes */
   /* a way needs at least 2 points to be drawn */
-  const std::vector<lpos_t> &points = points_from_node_chain(way);
+  std::vector<lpos_t> points = points_from_node_chain(way);
   if(unlikely(points.empty())) {
     /* draw a single dot where this single node is */
-    way->map_item = new map_item_t(object_t(way));
-
     assert(!way->node_chain.empty());
-    way->map_item->item = map->canvas->circle_new(CANVAS_GROUP_WAYS, way->node_chain.front()->lpos,
-                                             map->style->node.radius, 0,
-                                             map->style->node.color, 0);
-
-    // TODO: decide: do we need canvas_item_t::set_zoom_max() here too?
-
-    way->map_item->item->set_user_data(way->map_item);
+    batch.add(CANVAS_GROUP_WAYS, object_t(way),
+              canvas_circle_t(way->node_chain.front()->lpos, map->style->node.radius, 0,
+                              map->style->node.color, 0));
   } else {
     /* draw way */
     const float detail = map->appdata.project->map_state.detail;
     const float width = way->draw.width * detail;
     color_t areacol = color_t::transparent();
     canvas_group_t gr;
+    bool polygon = false;
 
     if(way->draw.flags & OSM_DRAW_FLAG_AREA) {
       gr = CANVAS_GROUP_POLYGONS;
       areacol = way->draw.area.color;
+      polygon = !map->style->area.color.is_transparent();
     } else if(way->draw.flags & OSM_DRAW_FLAG_BG) {
       gr = CANVAS_GROUP_WAYS_INT;
-      map_bg_modifier::add(map, way, map_way_new(map, CANVAS_GROUP_WAYS_OL, way, points,
-                                                 way->draw.bg.width * detail,
-                                                 way->draw.bg.color, color_t::transparent()));
+      batch.add(CANVAS_GROUP_WAYS_OL, way, false, way->draw.bg.width * detail,
+                way->draw.bg.color).points = points;
     } else {
       gr = CANVAS_GROUP_WAYS;
     }
 
-    way->map_item = map_way_new(map, gr, way, points, width, way->draw.color, areacol);
+    batch.add(gr, way, polygon, width, way->draw.color, areacol).points.swap(points);
   }
 }
 
 void map_t::draw(way_t *way) {
-  map_way_draw_functor m(this);
+  map_draw_batch batch(this);
+  map_way_draw_functor m(this, batch);
   m(way);
+  batch.flush();
+
+  // the way may have been changed, so the bounding box is updated
+  if(cull.enabled && way != action.way.get())
+    way_grid.update(way);
 }
 
 /**
@@ -479,12 +699,14 @@ void map_t::drawColorized(way_t* way)
 
 class map_node_draw_functor {
   map_t * const map;
+  map_draw_batch &batch;
   const float border_width;
   const float radius;
   const style_t * const style;
 public:
-  explicit inline map_node_draw_functor(map_t *m, const style_t *s = nullptr)
+  explicit inline map_node_draw_functor(map_t *m, map_draw_batch &b, const style_t *s = nullptr)
   : map(m)
+  , batch(b)
   , border_width(map->style->node.border_radius * map->appdata.project->map_state.detail)
   , radius(map->style->node.radius * map->appdata.project->map_state.detail)
   , style(s)
@@ -518,12 +740,27 @@ void map_node_draw_functor::operator()(node_t *node)
     return;
   }
 
-  map_node_new(map, node, radius, width, fill, col);
+  /* remove the old item, the new one is attached once it is created */
+  if(node->map_item != nullptr) {
+    delete node->map_item->item;
+    node->map_item = nullptr;
+  }
+
+  style_t::IconCache::const_iterator it;
+  if(!map->style->icon.enable ||
+     (it = map->style->node_icons.find(node->id)) == map->style->node_icons.end())
+    batch.add(CANVAS_GROUP_NODES, object_t(node), canvas_circle_t(node->lpos, radius, width, fill, col));
+  else
+    batch.add(object_t(node),
+              map->canvas->image_new(CANVAS_GROUP_NODES, it->second, node->lpos,
+                                     map->appdata.project->map_state.detail * map->style->icon.scale));
 }
 
 void map_t::draw(node_t *node) {
-  map_node_draw_functor m(this);
+  map_draw_batch batch(this);
+  map_node_draw_functor m(this, batch);
   m(node);
+  batch.flush();
 }
 
 template<typename T>
@@ -712,6 +949,12 @@ void map_t::set_zoom(double zoom, bool update_scroll_offsets) {
       item_deselect();
   }
 
+  const unsigned int band = lodBandForZoom(state.zoom);
+  if(band != lod_band) {
+    lod_band = band;
+    lod_update();
+  }
+
   if(update_scroll_offsets) {
     state.scroll_offset = canvas->scroll_get();
 
@@ -731,6 +974,38 @@ void map_t::set_zoom(double zoom, bool update_scroll_offsets) {
   }
 }
 
+namespace {
+
+class lod_update_functor {
+  const std::unordered_map<visible_item_t *, map_item_t *> &background_items;
+  const float tolerance;
+public:
+  inline lod_update_functor(const std::unordered_map<visible_item_t *, map_item_t *> &bg, float t)
+    : background_items(bg), tolerance(t) {}
+
+  void operator()(std::pair<item_id_t, way_t *> pair) const
+  {
+    way_t * const way = pair.second;
+    if(way->map_item == nullptr || !way->map_item->lod)
+      return;
+
+    const std::unordered_map<visible_item_t *, map_item_t *>::const_iterator it = background_items.find(way);
+    lod_apply(way->map_item, it == background_items.end() ? nullptr : it->second, tolerance);
+  }
+};
+
+} // namespace
+
+void map_t::lod_update()
+{
+  if(unlikely(!appdata.project || !appdata.project->osm))
+    return;
+
+  osm_t::ref osm = appdata.project->osm;
+  std::for_each(osm->ways.begin(), osm->ways.end(),
+                lod_update_functor(background_items, lodTolerance(lod_band)));
+}
+
 static bool distance_above(const map_t *map, const osm2go_platform::screenpos &p, int limit) {
   /* add offsets generated by mouse within map and map scrolling */
   osm2go_platform::screenpos s = p - map->pen_down.at;
@@ -804,25 +1079,15 @@ static void map_handle_click(map_t *map)
 }
 
 class hl_nodes {
-  const node_t * const cur_node;
   const lpos_t pos;
   map_t * const map;
   node_t *& res_node;
 public:
-  hl_nodes(const node_t *c, lpos_t p, map_t *m, node_t *&rnode)
-    : cur_node(c), pos(p), map(m), res_node(rnode) {}
-  void operator()(const std::pair<item_id_t, node_t *> &p);
+  hl_nodes(lpos_t p, map_t *m, node_t *&rnode)
+    : pos(p), map(m), res_node(rnode) {}
   void operator()(node_t *node);
 };
 
-void hl_nodes::operator()(const std::pair<item_id_t, node_t *> &p)
-{
-  node_t * const node = p.second;
-
-  if(node != cur_node && !node->isDeleted())
-    operator()(node);
-}
-
 void hl_nodes::operator()(node_t* node)
 {
   int nx = abs(pos.x - node->lpos.x);
@@ -855,11 +1120,16 @@ void map_t::touchnode_update(lpos_t pos) {
     break;
   }
 
-  /* check if we are close to one of the other nodes */
+  /* check if we are close to one of the other nodes, the one with the */
+  /* highest id wins */
   node_t *rnode = nullptr;
-  hl_nodes fc(cur_node, pos, this, rnode);
-  std::map<item_id_t, node_t *> &nodes = appdata.project->osm->nodes;
-  std::for_each(nodes.begin(), nodes.end(), fc);
+  const std::vector<node_t *> &nodes = appdata.project->osm->nodes_near(pos, style->node.radius);
+  for(std::vector<node_t *>::const_reverse_iterator it = nodes.rbegin(); it != nodes.rend(); it++) {
+    if(*it != cur_node) {
+      rnode = *it;
+      break;
+    }
+  }
 
   if(rnode != nullptr) {
     touchnode.reset(canvas->circle_new(CANVAS_GROUP_DRAW, rnode->lpos,
@@ -872,7 +1142,7 @@ void map_t::touchnode_update(lpos_t pos) {
   /* need to be searched */
   else if(!touchnode && action.way && action.way->node_chain.size() > 1) {
     const node_chain_t &chain = action.way->node_chain;
-    std::for_each(chain.begin(), std::prev(chain.end()), fc);
+    std::for_each(chain.begin(), std::prev(chain.end()), hl_nodes(pos, this, rnode));
   }
 }
 
@@ -933,7 +1203,10 @@ void map_t::button_release(const osm2go_platform::screenpos &p)
     if(!pen_down.drag)
       pen_down.drag = distance_above(this, p, MAP_DRAG_LIMIT);
 
-    if(!pen_down.drag) {
+    if(!pen_down.drag && unlikely(drawing)) {
+      // nothing can be selected until all objects are drawn
+      printf("left button released after click, ignored while drawing\n");
+    } else if(!pen_down.drag) {
       printf("left button released after click\n");
 
       object_t old_sel = selected.object;
@@ -1096,12 +1369,16 @@ map_t::map_t(appdata_t &a, canvas_t *c)
   , canvas(c)
   , touchnode_node(nullptr)
   , bg_offset(0, 0)
+  , lod_band(0)
   , style(appdata.style)
   , elements_drawn(0)
+  , drawing(false)
+  , cull_threshold(50000)
 {
   action.type = MAP_ACTION_IDLE;
   action.extending = nullptr;
   action.ends_on = nullptr;
+  cull_reset();
 }
 
 map_t::~map_t()
@@ -1114,7 +1391,7 @@ map_t::~map_t()
   appdata.map = nullptr;
 }
 
-void map_t::init() {
+bool map_t::init() {
   const bounds_t &bounds = appdata.project->osm->bounds;
 
   /* update canvas background color */
@@ -1125,12 +1402,14 @@ void map_t::init() {
 
   map_state_t &state = appdata.project->map_state;
   set_zoom(state.zoom, false);
-  paint();
 
+  // scroll first so the objects at the saved position can be drawn first
   printf("restore scroll position %f/%f\n",
          state.scroll_offset.x(), state.scroll_offset.y());
 
   state.scroll_offset = canvas->scroll_to(state.scroll_offset);
+
+  return paint_progressive();
 }
 
 void map_t::clear(clearLayers layers) {
@@ -1161,6 +1440,7 @@ void map_t::clear(clearLayers layers) {
   // only clear the map, the items are deleted through the canvas
   background_items.clear();
   map_free_map_item_chains(appdata);
+  cull_reset();
 
   /* remove a possibly existing highlight */
   item_deselect();
@@ -1168,21 +1448,429 @@ void map_t::clear(clearLayers layers) {
   canvas->erase(group_mask);
 }
 
+namespace {
+
+// the objects in the visible area are drawn as one batch, the others are
+// handled in batches of this size with pending events handled in between
+const size_t paint_batch_size = 2000;
+
+/**
+ * @brief an object queued for drawing by its distance to the visible area
+ */
+struct paint_item_t {
+  inline paint_item_t(int64_t d, const object_t &o) : distance(d), obj(o) {}
+  int64_t distance; ///< squared distance to the visible area, 0 if inside
+  object_t obj;
+
+  inline bool operator<(const paint_item_t &other) const
+  { return distance < other.distance; }
+};
+
+class paint_queue_functor {
+  std::vector<paint_item_t> &queue;
+  const lpos_t min, max;
+
+  int64_t distance(lpos_t bmin, lpos_t bmax) const
+  {
+    const int64_t dx = std::max(0, std::max(bmin.x - max.x, min.x - bmax.x));
+    const int64_t dy = std::max(0, std::max(bmin.y - max.y, min.y - bmax.y));
+    return dx * dx + dy * dy;
+  }
+
+public:
+  inline paint_queue_functor(std::vector<paint_item_t> &q, lpos_t vmin, lpos_t vmax)
+    : queue(q), min(vmin), max(vmax) {}
+
+  void operator()(std::pair<item_id_t, way_t *> pair);
+  void operator()(std::pair<item_id_t, node_t *> pair)
+  {
+    const node_t * const node = pair.second;
+    if(!node->isDeleted())
+      queue.push_back(paint_item_t(distance(node->lpos, node->lpos), object_t(pair.second)));
+  }
+};
+
+void paint_queue_functor::operator()(std::pair<item_id_t, way_t *> pair)
+{
+  const way_t * const way = pair.second;
+  if(way->isDeleted() || way->node_chain.empty())
+    return;
+
+  lpos_t bmin = way->node_chain.front()->lpos;
+  lpos_t bmax = bmin;
+  const node_chain_t::const_iterator itEnd = way->node_chain.end();
+  for(node_chain_t::const_iterator it = std::next(way->node_chain.begin()); it != itEnd; it++) {
+    const lpos_t &p = (*it)->lpos;
+    bmin.x = std::min(bmin.x, p.x);
+    bmin.y = std::min(bmin.y, p.y);
+    bmax.x = std::max(bmax.x, p.x);
+    bmax.y = std::max(bmax.y, p.y);
+  }
+
+  queue.push_back(paint_item_t(distance(bmin, bmax), object_t(pair.second)));
+}
+
+/**
+ * @brief add the bounding boxes of the ways to the grid
+ */
+class way_grid_functor {
+  way_grid_t &grid;
+public:
+  explicit inline way_grid_functor(way_grid_t &g) : grid(g) {}
+  inline void operator()(std::pair<item_id_t, way_t *> pair)
+  {
+    grid.update(pair.second);
+  }
+};
+
+/**
+ * @brief collect the objects that have no canvas items yet
+ */
+class undrawn_functor {
+  std::vector<object_t> &objects;
+public:
+  explicit inline undrawn_functor(std::vector<object_t> &o) : objects(o) {}
+  template<typename T>
+  inline void operator()(std::pair<item_id_t, T *> pair)
+  {
+    if(pair.second->map_item == nullptr)
+      objects.push_back(object_t(pair.second));
+  }
+};
+
+} // namespace
+
+bool map_t::paint_yield(const osm_t *posm)
+{
+  osm2go_platform::process_events();
+  // the map is destroyed together with the main window
+  if(unlikely(appdata_t::window == nullptr))
+    return false;
+  // the objects are gone if another project was opened in the meantime
+  if(unlikely(!appdata.project || appdata.project->osm.get() != posm)) {
+    drawing = false;
+    return false;
+  }
+
+  return true;
+}
+
+bool map_t::paint_culled_progressive()
+{
+  osm_t::ref osm = appdata.project->osm;
+  const osm_t * const posm = osm.get();
+
+  printf("drawing only the objects near the visible area, visible ones first ...\n");
+
+  cull_reset();
+  std::for_each(osm->ways.begin(), osm->ways.end(), way_grid_functor(way_grid));
+
+  printf("drawing frisket...\n");
+  map_frisket_draw(this, osm->bounds);
+
+  lpos_t vmin, vmax;
+  canvas->visible_area(vmin, vmax);
+
+  drawing = true;
+
+  // only the objects in the visible area are styled before they are drawn
+  map_draw_batch batch(this);
+  map_way_draw_functor wd(this, batch);
+  const std::vector<way_t *> &ways = way_grid.find(vmin, vmax);
+  const std::vector<way_t *>::const_iterator wEnd = ways.end();
+  for(std::vector<way_t *>::const_iterator it = ways.begin(); it != wEnd; it++) {
+    style->colorize(*it);
+    wd(*it);
+  }
+
+  map_node_draw_functor nd(this, batch);
+  const std::vector<node_t *> &nodes = osm->nodes_in_area(vmin, vmax);
+  const std::vector<node_t *>::const_iterator nEnd = nodes.end();
+  for(std::vector<node_t *>::const_iterator it = nodes.begin(); it != nEnd; it++) {
+    style->colorize(*it);
+    nd(*it);
+  }
+  batch.flush();
+
+  if(unlikely(!paint_yield(posm)))
+    return false;
+
+  // all other objects only get their style, they are drawn by cull_update()
+  // once the map comes close to them
+  std::vector<object_t> rest;
+  rest.reserve(osm->ways.size() + osm->nodes.size());
+  undrawn_functor uf(rest);
+  std::for_each(osm->ways.begin(), osm->ways.end(), uf);
+  std::for_each(osm->nodes.begin(), osm->nodes.end(), uf);
+
+  const std::vector<object_t>::const_iterator itEnd = rest.end();
+  std::vector<object_t>::const_iterator it = rest.begin();
+  while(it != itEnd) {
+    const std::vector<object_t>::const_iterator batchEnd = it + std::min(paint_batch_size,
+                                                                         static_cast<size_t>(itEnd - it));
+    for(; it != batchEnd; it++) {
+      if(it->type == object_t::WAY)
+        style->colorize(static_cast<way_t *>(*it));
+      else
+        style->colorize(static_cast<node_t *>(*it));
+    }
+
+    if(unlikely(!paint_yield(posm)))
+      return false;
+  }
+
+  // draw the surroundings of the area the map shows now
+  cull.enabled = true;
+  cull_update();
+
+  drawing = false;
+
+  return true;
+}
+
+bool map_t::paint_progressive()
+{
+  osm_t::ref osm = appdata.project->osm;
+  const osm_t * const posm = osm.get();
+
+  assert(canvas != nullptr);
+
+  if(osm->nodes.size() + osm->ways.size() > cull_threshold)
+    return paint_culled_progressive();
+
+  printf("drawing frisket...\n");
+  map_frisket_draw(this, osm->bounds);
+
+  lpos_t vmin, vmax;
+  canvas->visible_area(vmin, vmax);
+
+  std::vector<paint_item_t> queue;
+  queue.reserve(osm->ways.size() + osm->nodes.size());
+  paint_queue_functor fc(queue, vmin, vmax);
+  std::for_each(osm->ways.begin(), osm->ways.end(), fc);
+  std::for_each(osm->nodes.begin(), osm->nodes.end(), fc);
+  // keep the id order for objects with the same distance
+  std::stable_sort(queue.begin(), queue.end());
+
+  printf("drawing %zu objects, visible ones first ...\n", queue.size());
+
+  map_draw_batch batch(this);
+  map_way_draw_functor wd(this, batch);
+  map_node_draw_functor nd(this, batch);
+  drawing = true;
+
+  const std::vector<paint_item_t>::const_iterator itEnd = queue.end();
+  std::vector<paint_item_t>::const_iterator it = queue.begin();
+  while(it != itEnd) {
+    std::vector<paint_item_t>::const_iterator batchEnd;
+    if(it->distance == 0)
+      batchEnd = std::upper_bound(it, itEnd, *it);
+    else
+      batchEnd = it + std::min(paint_batch_size, static_cast<size_t>(itEnd - it));
+
+    for(; it != batchEnd; it++) {
+      if(it->obj.type == object_t::WAY) {
+        way_t * const way = static_cast<way_t *>(it->obj);
+        style->colorize(way);
+        wd(way);
+      } else {
+        node_t * const node = static_cast<node_t *>(it->obj);
+        style->colorize(node);
+        nd(node);
+      }
+    }
+    batch.flush();
+
+    if(unlikely(!paint_yield(posm)))
+      return false;
+  }
+
+  drawing = false;
+
+  return true;
+}
+
 void map_t::paint() {
   osm_t::ref osm = appdata.project->osm;
 
   assert(canvas != nullptr);
 
+  if(osm->nodes.size() + osm->ways.size() > cull_threshold) {
+    paint_culled();
+    return;
+  }
+  cull_reset();
+
+  map_draw_batch batch(this);
+
   printf("drawing ways ...\n");
-  std::for_each(osm->ways.begin(), osm->ways.end(), map_way_draw_functor(this, style.get()));
+  std::for_each(osm->ways.begin(), osm->ways.end(), map_way_draw_functor(this, batch, style.get()));
 
   printf("drawing single nodes ...\n");
-  std::for_each(osm->nodes.begin(), osm->nodes.end(), map_node_draw_functor(this, style.get()));
+  std::for_each(osm->nodes.begin(), osm->nodes.end(), map_node_draw_functor(this, batch, style.get()));
+
+  batch.flush();
 
   printf("drawing frisket...\n");
   map_frisket_draw(this, osm->bounds);
 }
 
+namespace {
+
+/**
+ * @brief recalculate the style of all objects and remove their canvas items
+ *
+ * The bounding boxes of all ways are added to the grid.
+ */
+class cull_prepare_functor {
+  map_t * const map;
+  const style_t * const style;
+  way_grid_t &grid;
+public:
+  inline cull_prepare_functor(map_t *m, const style_t *s, way_grid_t &g)
+    : map(m), style(s), grid(g) {}
+
+  void operator()(std::pair<item_id_t, way_t *> pair)
+  {
+    way_t * const way = pair.second;
+    style->colorize(way);
+    way->item_chain_destroy(map);
+    grid.update(way);
+  }
+  void operator()(std::pair<item_id_t, node_t *> pair)
+  {
+    style->colorize(pair.second);
+    pair.second->item_chain_destroy(map);
+  }
+};
+
+inline visible_item_t *visibleObject(const object_t &obj)
+{
+  if(obj.type == object_t::NODE || obj.type == object_t::WAY)
+    return static_cast<visible_item_t *>(static_cast<base_object_t *>(obj));
+  return nullptr;
+}
+
+inline bool inArea(lpos_t pos, lpos_t min, lpos_t max)
+{
+  return pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y;
+}
+
+} // namespace
+
+void map_t::paint_culled()
+{
+  osm_t::ref osm = appdata.project->osm;
+
+  printf("drawing only the objects near the visible area ...\n");
+
+  cull_reset();
+  cull_prepare_functor fc(this, style.get(), way_grid);
+  std::for_each(osm->ways.begin(), osm->ways.end(), fc);
+  std::for_each(osm->nodes.begin(), osm->nodes.end(), fc);
+  cull.enabled = true;
+
+  cull_update();
+
+  printf("drawing frisket...\n");
+  map_frisket_draw(this, osm->bounds);
+}
+
+void map_t::cull_reset()
+{
+  cull.enabled = false;
+  // min > max makes these empty
+  cull.drawn_min = cull.keep_min = lpos_t(1, 1);
+  cull.drawn_max = cull.keep_max = lpos_t(0, 0);
+  way_grid.clear();
+}
+
+void map_t::way_deleted(const way_t *way)
+{
+  way_grid.erase(way);
+}
+
+void map_t::viewport_changed()
+{
+  if(!cull.enabled || !appdata.project || !appdata.project->osm)
+    return;
+
+  lpos_t vmin, vmax;
+  canvas->visible_area(vmin, vmax);
+
+  // nothing to do as long as the visible area is covered, unless the map
+  // was zoomed in far enough that most of the items are unneeded
+  if(inArea(vmin, cull.drawn_min, cull.drawn_max) && inArea(vmax, cull.drawn_min, cull.drawn_max) &&
+     cull.drawn_max.x - cull.drawn_min.x <= 4 * (vmax.x - vmin.x + 1))
+    return;
+
+  cull_update();
+}
+
+void map_t::cull_update()
+{
+  osm_t::ref osm = appdata.project->osm;
+
+  lpos_t vmin, vmax;
+  canvas->visible_area(vmin, vmax);
+
+  // everything within half a screen of the visible area is drawn, items more
+  // than one and a half screens away are removed
+  const int min_margin = 100;
+  const int mx = std::max((vmax.x - vmin.x) / 2, min_margin);
+  const int my = std::max((vmax.y - vmin.y) / 2, min_margin);
+  const lpos_t drawn_min(vmin.x - mx, vmin.y - my);
+  const lpos_t drawn_max(vmax.x + mx, vmax.y + my);
+  const lpos_t keep_min(vmin.x - 3 * mx, vmin.y - 3 * my);
+  const lpos_t keep_max(vmax.x + 3 * mx, vmax.y + 3 * my);
+
+  // the objects currently worked on keep their items
+  const visible_item_t * const busy[] = {
+    visibleObject(selected.object),
+    pen_down.on_item != nullptr ? visibleObject(pen_down.on_item->object) : nullptr,
+    action.extending,
+    action.ends_on,
+    touchnode_node
+  };
+  const visible_item_t * const * const busyEnd = busy + sizeof(busy) / sizeof(busy[0]);
+
+  const std::vector<way_t *> &keptWays = way_grid.find(keep_min, keep_max);
+  const std::unordered_set<way_t *> kept(keptWays.begin(), keptWays.end());
+  const std::vector<way_t *> &oldWays = way_grid.find(cull.keep_min, cull.keep_max);
+  const std::vector<way_t *>::const_iterator owEnd = oldWays.end();
+  for(std::vector<way_t *>::const_iterator it = oldWays.begin(); it != owEnd; it++)
+    if(kept.find(*it) == kept.end() && std::find(busy, busyEnd, *it) == busyEnd)
+      (*it)->item_chain_destroy(this);
+
+  const std::vector<node_t *> &oldNodes = osm->nodes_in_area(cull.keep_min, cull.keep_max);
+  const std::vector<node_t *>::const_iterator onEnd = oldNodes.end();
+  for(std::vector<node_t *>::const_iterator it = oldNodes.begin(); it != onEnd; it++)
+    if(!inArea((*it)->lpos, keep_min, keep_max) && std::find(busy, busyEnd, *it) == busyEnd)
+      (*it)->item_chain_destroy(this);
+
+  map_draw_batch batch(this);
+  map_way_draw_functor wd(this, batch);
+  const std::vector<way_t *> &ways = way_grid.find(drawn_min, drawn_max);
+  const std::vector<way_t *>::const_iterator wEnd = ways.end();
+  for(std::vector<way_t *>::const_iterator it = ways.begin(); it != wEnd; it++)
+    if((*it)->map_item == nullptr)
+      wd(*it);
+
+  map_node_draw_functor nd(this, batch);
+  const std::vector<node_t *> &nodes = osm->nodes_in_area(drawn_min, drawn_max);
+  const std::vector<node_t *>::const_iterator nEnd = nodes.end();
+  for(std::vector<node_t *>::const_iterator it = nodes.begin(); it != nEnd; it++)
+    if((*it)->map_item == nullptr)
+      nd(*it);
+
+  batch.flush();
+
+  cull.drawn_min = drawn_min;
+  cull.drawn_max = drawn_max;
+  cull.keep_min = keep_min;
+  cull.keep_max = keep_max;
+}
+
 /* called from several icons like e.g. "node_add" */
 void map_t::set_action(map_action_t act) {
   printf("map action set to %d\n", act);
@@ -1388,16 +2076,13 @@ struct out_of_bounds {
 
 } // namespace
 
-void map_t::track_draw_seg(track_seg_t &seg) {
+void map_t::track_collect_seg(const track_seg_t &seg, std::vector<canvas_poly_t> &pieces) {
   const bounds_t &bounds = appdata.project->osm->bounds;
 
   /* a track_seg needs at least 2 points to be drawn */
   if (seg.track_points.empty())
     return;
 
-  /* nothing should have been drawn by now ... */
-  assert(seg.item_chain.empty());
-
   const std::vector<track_point_t>::const_iterator itEnd = seg.track_points.end();
   std::vector<track_point_t>::const_iterator it = seg.track_points.begin();
   while(it != itEnd) {
@@ -1433,15 +2118,25 @@ void map_t::track_draw_seg(track_seg_t &seg) {
 
     /* allocate space for nodes */
     printf("visible are %u\n", visible);
-    std::vector<lpos_t> points = canvas_points_init(bounds, it, visible);
+    pieces.push_back(canvas_poly_t(false, style->track.width, style->track.color));
+    pieces.back().points = canvas_points_init(bounds, it, visible);
     it = tmp;
-
-    canvas_item_t *item = canvas->polyline_new(CANVAS_GROUP_TRACK, points,
-                                               style->track.width, style->track.color);
-    seg.item_chain.push_back(item);
   }
 }
 
+void map_t::track_draw_seg(track_seg_t &seg) {
+  /* nothing should have been drawn by now ... */
+  assert(seg.item_chain.empty());
+
+  std::vector<canvas_poly_t> pieces;
+  track_collect_seg(seg, pieces);
+  if(pieces.empty())
+    return;
+
+  canvas->poly_batch_new(CANVAS_GROUP_TRACK, pieces, seg.item_chain);
+}
+
+
 /* update the last visible fragment of this segment since a */
 /* gps position may have been added */
 void map_t::track_update_seg(track_seg_t &seg) {
@@ -1513,14 +2208,6 @@ void map_t::track_update_seg(track_seg_t &seg) {
   }
 }
 
-class map_track_seg_draw_functor {
-  map_t * const map;
-public:
-  explicit inline map_track_seg_draw_functor(map_t *m) : map(m) {}
-  void operator()(track_seg_t &seg) {
-    map->track_draw_seg(seg);
-  }
-};
 
 void map_t::track_draw(TrackVisibility visibility, track_t &track) {
   if(unlikely(track.segments.empty()))
@@ -1533,10 +2220,30 @@ void map_t::track_draw(TrackVisibility visibility, track_t &track) {
   canvas->erase(1 << CANVAS_GROUP_TRACK);
 
   switch(visibility) {
-  case DrawAll:
-    std::for_each(track.segments.begin(), track.segments.end(),
-                  map_track_seg_draw_functor(this));
+  case DrawAll: {
+    // all segments are created in one go, then distributed to their segments
+    std::vector<canvas_poly_t> pieces;
+    std::vector<size_t> counts;
+    counts.reserve(track.segments.size());
+    const std::vector<track_seg_t>::iterator itEnd = track.segments.end();
+    for(std::vector<track_seg_t>::iterator it = track.segments.begin(); it != itEnd; it++) {
+      assert(it->item_chain.empty());
+      const size_t before = pieces.size();
+      track_collect_seg(*it, pieces);
+      counts.push_back(pieces.size() - before);
+    }
+
+    std::vector<canvas_item_t *> items;
+    canvas->poly_batch_new(CANVAS_GROUP_TRACK, pieces, items);
+
+    std::vector<canvas_item_t *>::const_iterator item = items.begin();
+    std::vector<size_t>::const_iterator cnt = counts.begin();
+    for(std::vector<track_seg_t>::iterator it = track.segments.begin(); it != itEnd; it++, cnt++) {
+      it->item_chain.assign(item, item + *cnt);
+      item += *cnt;
+    }
     break;
+  }
   case DrawCurrent:
     if(track.active)
       track_draw_seg(track.segments.back());
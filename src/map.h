@@ -16,6 +16,7 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <osm2go_i18n.h>
 #include <osm2go_platform.h>
@@ -55,17 +56,57 @@ struct appdata_t;
 class canvas_t;
 struct canvas_item_circle;
 struct canvas_item_t;
+struct canvas_poly_t;
 class style_t;
 struct track_seg_t;
 struct track_t;
 
+/**
+ * @brief the data needed to draw a way with less detail when zoomed out
+ *
+ * The Douglas-Peucker algorithm is run once when the way is drawn. Instead of
+ * removing the points closer than a fixed tolerance it records for every
+ * point the largest tolerance at which it is still kept, so the shape for any
+ * tolerance is only a filter over the points.
+ */
+struct way_lod_t {
+  explicit way_lod_t(const std::vector<lpos_t> &p);
+
+  enum { MinPoints = 8 };             ///< ways with less points are never simplified
+
+  const std::vector<lpos_t> points;   ///< the full resolution shape
+  std::vector<float> importance;      ///< the largest tolerance at which the point is kept
+
+  /**
+   * @brief get the points that have at least the given distance to the simplified shape
+   *
+   * The first and last point are always included.
+   */
+  std::vector<lpos_t> simplified(float tolerance) const;
+};
+
 struct map_item_t {
   map_item_t(object_t o = object_t(), canvas_item_t *i = nullptr)
     : object(o), item(i) {}
   map_item_t(const map_item_t &) O2G_DELETED_FUNCTION;
 
+  /**
+   * @brief refer to another object
+   *
+   * The canvas item and the simplified shapes belong to the previous object
+   * and are dropped.
+   */
+  map_item_t &operator=(const object_t &o)
+  {
+    object = o;
+    item = nullptr;
+    lod.reset();
+    return *this;
+  }
+
   object_t object;
   canvas_item_t *item;
+  std::unique_ptr<way_lod_t> lod;   ///< the simplified shapes of long ways
 };
 
 class map_t {
@@ -113,6 +154,53 @@ private:
     way_t *extending, *ends_on;   // ways touched by first and last node
   } action;
 
+  /**
+   * @brief state of the viewport culling
+   *
+   * For large projects only the objects near the visible area get canvas
+   * items, the others are drawn once the map is moved close to them.
+   */
+  struct {
+    bool enabled;
+    lpos_t drawn_min, drawn_max;  ///< all objects in this area have canvas items
+    lpos_t keep_min, keep_max;    ///< canvas items outside this area are removed
+  } cull;
+  way_grid_t way_grid;            ///< bounding boxes of the ways while culling is enabled
+
+  unsigned int lod_band;          ///< the level of detail the ways are currently drawn with
+
+  /**
+   * @brief show all ways in the level of detail of lod_band
+   */
+  void lod_update();
+
+  void cull_reset();
+  void cull_update();
+  /**
+   * @brief draw the objects near the visible area and index all ways
+   */
+  void paint_culled();
+  /**
+   * @brief draw the visible area of a large project first
+   * @returns false if the main window was closed or another project was opened while drawing
+   *
+   * The other objects are styled in batches, they are drawn by cull_update()
+   * once all of them are done.
+   */
+  bool paint_culled_progressive();
+  /**
+   * @brief handle pending events between two drawing batches
+   * @returns if drawing may continue
+   */
+  bool paint_yield(const osm_t *posm);
+
+  /**
+   * @brief collect the visible pieces of the track segment
+   * @param seg the segment to draw
+   * @param pieces the lines to create are appended here
+   */
+  void track_collect_seg(const track_seg_t &seg, std::vector<canvas_poly_t> &pieces);
+
 public:
   /* variables required for pen/mouse handling */
   struct _pd {
@@ -128,13 +216,46 @@ public:
   std::unique_ptr<style_t> &style;
 
   size_t elements_drawn;	///< number of elements drawn in last segment
+  bool drawing;                 ///< paint_progressive() is running, clicks are ignored
+  size_t cull_threshold;        ///< object count above which only the objects near the visible area are drawn
 
   osm_t::TagMap last_node_tags;           // used to "repeat" tagging
   osm_t::TagMap last_way_tags;
 
   virtual void set_autosave(bool enable) = 0;
-  void init();
+  /**
+   * @brief set up the canvas for the current project and draw it
+   * @returns false if the main window was closed or another project was opened while drawing
+   *
+   * @see paint_progressive
+   */
+  bool init();
   void paint();
+
+  /**
+   * @brief draw all objects, starting with those in the visible area
+   * @returns false if the main window was closed or another project was opened while drawing
+   *
+   * The objects in the visible area are drawn first, the others follow in
+   * batches ordered by their distance to it. Pending events are handled after
+   * every batch so the map can already be moved, but objects can't be selected
+   * until everything is drawn.
+   *
+   * For projects above cull_threshold only the visible area is drawn first,
+   * the surroundings follow once all objects have their style.
+   */
+  bool paint_progressive();
+
+  /**
+   * @brief update the canvas items after the visible area has changed
+   *
+   * This needs to be called by the platform code whenever the map is
+   * scrolled, zoomed, or resized. If culling is active objects that came
+   * close to the visible area are drawn and those far away are removed from
+   * the canvas. Otherwise nothing happens.
+   */
+  void viewport_changed();
+
   void clear(clearLayers layers);
   void item_deselect();
   void highlight_refresh();
@@ -143,7 +264,15 @@ public:
   template<typename T> void redraw_item(T *obj);
   void draw(way_t *way);
   void drawColorized(way_t *way);
+  /**
+   * @brief forget about the way, it is deleted and may be freed afterwards
+   */
+  void way_deleted(const way_t *way);
   void select_way(way_t *way);
+  /**
+   * @brief select the given object and scroll it into view
+   */
+  void select_object(const object_t &object);
   void set_action(map_action_t act);
   bool item_is_selected_way(const map_item_t *map_item) const;
   bool item_is_selected_node(const map_item_t *map_item) const;
@@ -364,22 +364,13 @@ void map_t::way_cut(lpos_t pos) {
 }
 
 struct redraw_way {
-  node_t * const node;
   map_t * const map;
-  unsigned int &cnt;
-  redraw_way(node_t *n, map_t *m, unsigned int &c) : node(n), map(m), cnt(c) {}
-  void operator()(const std::pair<item_id_t, way_t *> &p);
+  explicit redraw_way(map_t *m) : map(m) {}
+  void operator()(way_t *way);
 };
 
-void redraw_way::operator()(const std::pair<item_id_t, way_t *> &p)
+void redraw_way::operator()(way_t *way)
 {
-  way_t * const way = p.second;
-  if(!cnt || !way->contains_node(node))
-    return;
-
-  // limit the real work to the number of ways this node is actually part of
-  cnt--;
-
   printf("  node is part of way #" ITEM_ID_FORMAT ", redraw!\n", way->id);
 
   /* draw current way */
@@ -394,7 +385,7 @@ void map_t::node_move(map_item_t *map_item, const osm2go_platform::screenpos &p)
   node_t *node = static_cast<node_t *>(map_item->object);
 
   printf("released dragged node #" ITEM_ID_FORMAT ", was at %d %d (%f %f)\n",
-         node->id, node->lpos.x, node->lpos.y, node->pos.lat, node->pos.lon);
+         node->id, node->lpos.x, node->lpos.y, node->pos.toPos().lat, node->pos.toPos().lon);
 
   /* check if it was dropped onto another node */
   bool joined_with_touchnode = false;
@@ -460,25 +451,20 @@ void map_t::node_move(map_item_t *map_item, const osm2go_platform::screenpos &p)
       return;
     }
 
-    /* convert screen position to lat/lon */
-    node->pos = pos.toPos(osm->bounds);
-
-    /* convert pos back to lpos to see rounding errors */
-    node->lpos = node->pos.toLpos(osm->bounds);
+    /* convert screen position to lat/lon, this also converts pos */
+    /* back to lpos to see rounding errors */
+    osm->node_move(node, pos.toPos(osm->bounds));
 
     printf("  now at %d %d (%f %f)\n",
-	   node->lpos.x, node->lpos.y, node->pos.lat, node->pos.lon);
+	   node->lpos.x, node->lpos.y, node->pos.toPos().lat, node->pos.toPos().lon);
   }
 
   /* now update the visual representation of the node */
   draw(node);
 
   /* visually update ways, node is part of */
-  if(node->ways > 0) {
-    unsigned int wcnt = node->ways;
-    redraw_way fc(node, this, wcnt);
-    std::for_each(osm->ways.begin(), osm->ways.end(), fc);
-  }
+  const way_chain_t &nways = osm->node_ways(node);
+  std::for_each(nways.begin(), nways.end(), redraw_way(this));
 
   highlight_refresh();
 }
@@ -11,6 +11,8 @@
 #include <cstring>
 #include <strings.h>
 
+#include <osm2go_annotations.h>
+
 double xml_get_prop_float(xmlNode *node, const char *prop) {
   xmlString str(xmlGetProp(node, BAD_CAST prop));
   return xml_parse_float(str);
@@ -58,3 +60,133 @@ void remove_trailing_zeroes(char *str)
   if(p == delim)
     *p = '\0';
 }
+
+namespace {
+
+/**
+ * @brief get the value of a decimal digit
+ * @returns the value, or something above 9 if c is no digit
+ */
+inline unsigned int digit(char c)
+{
+  return static_cast<unsigned int>(static_cast<unsigned char>(c)) - '0';
+}
+
+/**
+ * @brief parse a fixed number of digits
+ * @param str the digits
+ * @param bad set to a non-zero value if one of the characters is no digit
+ */
+template<unsigned int N>
+inline unsigned int digits(const char *str, unsigned int &bad)
+{
+  unsigned int ret = 0;
+  for(unsigned int i = 0; i < N; i++) {
+    const unsigned int d = digit(str[i]);
+    bad |= d > 9;
+    ret = ret * 10 + d;
+  }
+  return ret;
+}
+
+/**
+ * @brief the number of days since 1970-01-01 of the given date
+ *
+ * This is the days_from_civil() algorithm from Howard Hinnant.
+ */
+int64_t days_from_civil(int y, unsigned int m, unsigned int d)
+{
+  y -= m <= 2 ? 1 : 0;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned int yoe = static_cast<unsigned int>(y - era * 400);
+  const unsigned int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return static_cast<int64_t>(era) * 146097 + doe - 719468;
+}
+
+} // namespace
+
+bool parse_float_int(const char *str, unsigned int decimals, int32_t &val)
+{
+  const bool negative = *str == '-';
+  if(negative)
+    str++;
+
+  // 10 digits can't overflow, larger values are caught by the range check below
+  uint64_t v = 0;
+  unsigned int intDigits = 0;
+  for(unsigned int d; (d = digit(*str)) <= 9 && intDigits <= 10; str++, intDigits++)
+    v = v * 10 + d;
+
+  unsigned int decDigits = 0;
+  if(*str == '.') {
+    str++;
+    for(unsigned int d; (d = digit(*str)) <= 9; str++, decDigits++) {
+      // more precision than can be represented, let the caller round it
+      if(unlikely(decDigits == decimals))
+        return false;
+      v = v * 10 + d;
+    }
+  }
+
+  if(unlikely(intDigits + decDigits == 0 || intDigits > 10 || *str == 'e' || *str == 'E'))
+    return false;
+
+  for(; decDigits < decimals; decDigits++)
+    v *= 10;
+
+  if(unlikely(v > static_cast<uint64_t>(INT32_MAX)))
+    return false;
+
+  val = negative ? -static_cast<int32_t>(v) : static_cast<int32_t>(v);
+  return true;
+}
+
+bool parse_int64(const char *str, int64_t &val)
+{
+  const bool negative = *str == '-';
+  if(negative)
+    str++;
+
+  const uint64_t limit = static_cast<uint64_t>(INT64_MAX);
+  uint64_t v = 0;
+  unsigned int digits = 0;
+  for(unsigned int d; (d = digit(*str)) <= 9; str++, digits++) {
+    if(unlikely(v > (limit - d) / 10))
+      return false;
+    v = v * 10 + d;
+  }
+
+  if(unlikely(digits == 0 || (*str != '\0' && *str != '"' && *str != '\'')))
+    return false;
+
+  val = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+  return true;
+}
+
+bool parse_iso8601_utc(const char *str, time_t &t)
+{
+  // YYYY-MM-DDTHH:MM:SSZ
+  // 01234567890123456789
+  if(unlikely(strnlen(str, 20) < 20))
+    return false;
+
+  unsigned int bad = 0;
+  const unsigned int year = digits<4>(str, bad);
+  const unsigned int month = digits<2>(str + 5, bad);
+  const unsigned int day = digits<2>(str + 8, bad);
+  const unsigned int hour = digits<2>(str + 11, bad);
+  const unsigned int minute = digits<2>(str + 14, bad);
+  const unsigned int second = digits<2>(str + 17, bad);
+
+  bad |= (str[4] != '-') | (str[7] != '-') | (str[10] != 'T') |
+         (str[13] != ':') | (str[16] != ':') | (str[19] != 'Z');
+  bad |= (month - 1 > 11) | (day - 1 > 30) | (hour > 23) | (minute > 59) | (second > 60);
+
+  if(unlikely(bad != 0))
+    return false;
+
+  t = static_cast<time_t>(days_from_civil(year, month, day) * 86400 +
+                          hour * 3600 + minute * 60 + second);
+  return true;
+}
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <ctime>
 #include <libxml/tree.h>
 #include <memory>
 
@@ -87,3 +89,40 @@ void format_float(T val, unsigned int decimals, char *str)
  * delimiter it will also be removed.
  */
 void remove_trailing_zeroes(char *str);
+
+/**
+ * @brief parse a decimal number to an integer representation
+ * @param str the string to parse
+ * @param decimals the number of decimals the result is shifted by
+ * @param val returns the value multiplied by 10^decimals
+ * @returns if the string could be parsed exactly
+ *
+ * This is the counterpart of format_float_int(). Only the plain format
+ * "[-]digits[.digits]" is accepted, with at most decimals digits behind the
+ * separator. Parsing stops at the first character not matching this. A number
+ * in any other format, or one that does not fit into val, is rejected, the
+ * caller should pass it to osm2go_platform::string_to_double() then.
+ */
+bool parse_float_int(const char *str, unsigned int decimals, int32_t &val);
+
+/**
+ * @brief parse a decimal integer
+ * @param str the string to parse, it must not be nullptr
+ * @param val returns the parsed value
+ * @returns if the string is a number that fits into val
+ *
+ * This accepts an optional '-' followed by digits. The number must end at the
+ * end of the string or at a quote character, so the raw attribute values of
+ * the XML scanner can be passed. It is a replacement for strtoll() for the ids
+ * and versions in OSM data, without the handling of locales, bases, and
+ * whitespace.
+ */
+bool parse_int64(const char *str, int64_t &val);
+
+/**
+ * @brief parse a timestamp in the format used by OSM
+ * @param str the string to parse, it must not be nullptr
+ * @param t returns the seconds since the epoch
+ * @returns if the string has the format "YYYY-MM-DDTHH:MM:SSZ"
+ */
+bool parse_iso8601_utc(const char *str, time_t &t);
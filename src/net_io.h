@@ -7,11 +7,29 @@
 #pragma once
 
 #include <curl/curl.h>
+#include <memory>
 #include <string>
 
 #include <osm2go_i18n.h>
 #include <osm2go_platform.h>
 
+/**
+ * @brief receives the data of a download while it arrives
+ *
+ * write() may be called from a different thread than the one that started
+ * the download. It may also still be called after the download function has
+ * returned because the user cancelled the request, so the object is shared.
+ */
+class net_io_sink {
+public:
+  virtual ~net_io_sink() {}
+
+  /**
+   * @brief process the next piece of the raw (i.e. possibly compressed) data
+   */
+  virtual void write(const char *data, size_t len) = 0;
+};
+
 /**
  * @brief download from the given URL to file
  * @param parent widget for status messages
@@ -19,19 +37,22 @@
  * @param filename output filename
  * @param title window title string for the download window
  * @param compress if gzip compression of the data should be enabled
+ * @param sink gets all data that is written to the file
  *
  * @returns if the request was successful
  */
 bool net_io_download_file(osm2go_platform::Widget *parent,
                           const std::string &url, const std::string &filename,
-                          const std::string &title, bool compress = false);
+                          const std::string &title, bool compress = false,
+                          const std::shared_ptr<net_io_sink> &sink = std::shared_ptr<net_io_sink>());
 
 /**
  * @overload
  */
 bool net_io_download_file(osm2go_platform::Widget *parent,
                           const std::string &url, const std::string &filename,
-                          trstring::native_type_arg title, bool compress = false);
+                          trstring::native_type_arg title, bool compress = false,
+                          const std::shared_ptr<net_io_sink> &sink = std::shared_ptr<net_io_sink>());
 
 /**
  * @brief download from the given URL to memory
@@ -20,6 +20,13 @@ void relation_membership_dialog(osm2go_platform::Widget *parent, const presets_i
 
 void relation_list(osm2go_platform::Widget *parent, map_t *map, osm_t::ref osm, presets_items *presets);
 
+/**
+ * @brief show a dialog to find all objects with a given tag
+ *
+ * The object the user picks is selected on the map.
+ */
+void tag_search_dialog(osm2go_platform::Widget *parent, map_t *map, osm_t::ref osm);
+
 /**
  * @returns if the dialog was accepted by the user
  */
@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Rolf Eike Beer <eike@sf-mail.de>
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <osm2go_annotations.h>
+
+/**
+ * @brief a map from object ids to object pointers with the interface of std::map
+ *
+ * The objects are stored in 2 sorted vectors instead of a tree, so lookups
+ * are a binary search in contiguous memory and iteration is a linear walk.
+ *
+ * Objects downloaded from the server have positive ids and usually arrive in
+ * ascending order, so they are simply appended to the first vector. Newly
+ * created objects get negative ids, each one lower than the previous one.
+ * These are kept in reverse order in the second vector, so adding them is
+ * an append, too. Iteration still happens in ascending id order like with
+ * std::map, i.e. all new objects come first.
+ *
+ * Unlike std::map all iterators and references are invalidated by inserting
+ * or erasing elements.
+ */
+template<typename T>
+class object_map {
+public:
+  typedef int64_t key_type;
+  typedef T *mapped_type;
+  typedef std::pair<key_type, T *> value_type;
+  typedef std::size_t size_type;
+
+private:
+  typedef std::vector<value_type> storage_type;
+  storage_type positive; ///< objects with ids >= 0 in ascending order
+  storage_type negative; ///< objects with ids < 0 in descending order
+
+  struct key_less {
+    inline bool operator()(const value_type &v, key_type k) const noexcept
+    { return v.first < k; }
+  };
+  struct key_greater {
+    inline bool operator()(const value_type &v, key_type k) const noexcept
+    { return v.first > k; }
+  };
+
+  inline const value_type &at_index(size_type idx) const
+  {
+    if(idx < negative.size())
+      return negative[negative.size() - 1 - idx];
+    return positive[idx - negative.size()];
+  }
+  inline value_type &at_index(size_type idx)
+  {
+    return const_cast<value_type &>(static_cast<const object_map *>(this)->at_index(idx));
+  }
+
+  /**
+   * @brief find the index where the given key is or would be inserted
+   * @param exists set to if the key is present
+   */
+  size_type lookup(key_type key, bool &exists) const
+  {
+    if(key < 0) {
+      const typename storage_type::const_iterator it = std::lower_bound(negative.begin(), negative.end(), key, key_greater());
+      exists = it != negative.end() && it->first == key;
+      // the iteration index counts from the end of the vector
+      return negative.end() - it - (exists ? 1 : 0);
+    } else {
+      const typename storage_type::const_iterator it = std::lower_bound(positive.begin(), positive.end(), key, key_less());
+      exists = it != positive.end() && it->first == key;
+      return negative.size() + (it - positive.begin());
+    }
+  }
+
+  template<typename Map, typename Value>
+  class iterator_base {
+    friend class object_map;
+    template<typename M, typename V> friend class iterator_base;
+
+    Map *map;
+    size_type idx;
+
+    inline iterator_base(Map *m, size_type i) : map(m), idx(i) {}
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef typename object_map::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value *pointer;
+    typedef Value &reference;
+
+    inline iterator_base() : map(nullptr), idx(0) {}
+    // allows conversion from iterator to const_iterator
+    template<typename M, typename V>
+    inline iterator_base(const iterator_base<M, V> &other) : map(other.map), idx(other.idx) {}
+
+    inline reference operator*() const
+    { return map->at_index(idx); }
+    inline pointer operator->() const
+    { return &map->at_index(idx); }
+
+    inline iterator_base &operator++()
+    { idx++; return *this; }
+    inline iterator_base operator++(int)
+    { iterator_base ret = *this; idx++; return ret; }
+    inline iterator_base &operator--()
+    { idx--; return *this; }
+    inline iterator_base operator--(int)
+    { iterator_base ret = *this; idx--; return ret; }
+
+    template<typename M, typename V>
+    inline bool operator==(const iterator_base<M, V> &other) const
+    { return idx == other.idx; }
+    template<typename M, typename V>
+    inline bool operator!=(const iterator_base<M, V> &other) const
+    { return idx != other.idx; }
+  };
+
+public:
+  typedef iterator_base<object_map, value_type> iterator;
+  typedef iterator_base<const object_map, const value_type> const_iterator;
+
+  inline iterator begin()
+  { return iterator(this, 0); }
+  inline iterator end()
+  { return iterator(this, size()); }
+  inline const_iterator begin() const
+  { return const_iterator(this, 0); }
+  inline const_iterator end() const
+  { return const_iterator(this, size()); }
+
+  inline size_type size() const noexcept
+  { return positive.size() + negative.size(); }
+  inline bool empty() const noexcept
+  { return positive.empty() && negative.empty(); }
+
+  void clear()
+  {
+    positive.clear();
+    negative.clear();
+  }
+
+  /**
+   * @brief reserve space for the given number of downloaded objects
+   */
+  inline void reserve(size_type n)
+  { positive.reserve(n); }
+
+  iterator find(key_type key)
+  {
+    bool exists;
+    size_type idx = lookup(key, exists);
+    return exists ? iterator(this, idx) : end();
+  }
+
+  const_iterator find(key_type key) const
+  {
+    bool exists;
+    size_type idx = lookup(key, exists);
+    return exists ? const_iterator(this, idx) : end();
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value)
+  {
+    storage_type &vec = value.first < 0 ? negative : positive;
+    // fast path: objects are added in the order of their storage
+    if(likely(vec.empty() || (value.first < 0 ? vec.back().first > value.first : vec.back().first < value.first))) {
+      vec.push_back(value);
+      return std::make_pair(iterator(this, value.first < 0 ? 0 : size() - 1), true);
+    }
+
+    bool exists;
+    size_type idx = lookup(value.first, exists);
+    if(exists)
+      return std::make_pair(iterator(this, idx), false);
+
+    if(value.first < 0)
+      negative.insert(negative.end() - idx, value);
+    else
+      positive.insert(positive.begin() + (idx - negative.size()), value);
+
+    return std::make_pair(iterator(this, idx), true);
+  }
+
+  mapped_type &operator[](key_type key)
+  {
+    return insert(value_type(key, nullptr)).first->second;
+  }
+
+  size_type erase(key_type key)
+  {
+    bool exists;
+    size_type idx = lookup(key, exists);
+    if(!exists)
+      return 0;
+
+    if(key < 0)
+      negative.erase(negative.end() - 1 - idx);
+    else
+      positive.erase(positive.begin() + (idx - negative.size()));
+
+    return 1;
+  }
+};
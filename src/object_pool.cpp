@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Rolf Eike Beer <eike@sf-mail.de>
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "object_pool.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "osm2go_annotations.h"
+
+namespace {
+
+constexpr std::size_t align(std::size_t size)
+{
+  return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+// the header is padded so the objects behind it are properly aligned
+const std::size_t slabHeader = align(2 * sizeof(void *));
+
+typedef std::unique_lock<std::mutex> pool_lock;
+
+} // namespace
+
+object_pool::object_pool(std::size_t size)
+  : stride(align(size < sizeof(free_t) ? sizeof(free_t) : size))
+  , slabObjects((SlabSize - slabHeader) / stride)
+  , slabs(nullptr)
+  , freeList(nullptr)
+  , slabUsed(slabObjects)
+  , live(0)
+  , owned(true)
+{
+  assert_cmpnum_op(slabObjects, >, 0);
+}
+
+object_pool::~object_pool()
+{
+  releaseSlabs();
+}
+
+object_pool *object_pool::create(std::size_t size)
+{
+  return new object_pool(size);
+}
+
+void object_pool::disown()
+{
+  pool_lock lock(mutex);
+  owned = false;
+  if(live != 0)
+    return;
+  lock.unlock();
+
+  delete this;
+}
+
+void *object_pool::allocate()
+{
+  pool_lock lock(mutex);
+
+  if(freeList != nullptr) {
+    free_t *ret = freeList;
+    freeList = ret->next;
+    live++;
+    return ret;
+  }
+
+  if(unlikely(slabUsed == slabObjects)) {
+    void *mem;
+    if(unlikely(posix_memalign(&mem, SlabSize, SlabSize) != 0))
+      throw std::bad_alloc();
+    slab_t *slab = static_cast<slab_t *>(mem);
+    slab->owner = this;
+    slab->next = slabs;
+    slabs = slab;
+    slabUsed = 0;
+  }
+
+  void *ret = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(slabs) + slabHeader + stride * slabUsed);
+  slabUsed++;
+  live++;
+
+  return ret;
+}
+
+void object_pool::release(void *p)
+{
+  if(unlikely(p == nullptr))
+    return;
+
+  // slabs are aligned to their size, so the start of the slab can be calculated
+  const slab_t *slab = reinterpret_cast<const slab_t *>(reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(SlabSize - 1));
+  slab->owner->releaseObject(p);
+}
+
+void object_pool::releaseObject(void *p)
+{
+  pool_lock lock(mutex);
+
+  assert(live > 0);
+
+  // the last object is gone, so nothing in the slabs is used anymore
+  if(--live == 0) {
+    releaseSlabs();
+    if(!owned) {
+      lock.unlock();
+      delete this;
+    }
+    return;
+  }
+
+  free_t *f = static_cast<free_t *>(p);
+  f->next = freeList;
+  freeList = f;
+}
+
+void object_pool::releaseSlabs()
+{
+  while(slabs != nullptr) {
+    slab_t *next = slabs->next;
+    free(slabs);
+    slabs = next;
+  }
+  freeList = nullptr;
+  slabUsed = slabObjects;
+}
+
+std::size_t object_pool::slabCount() const noexcept
+{
+  std::size_t ret = 0;
+  for(const slab_t *s = slabs; s != nullptr; s = s->next)
+    ret++;
+  return ret;
+}
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Rolf Eike Beer <eike@sf-mail.de>
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+#include <osm2go_cpp.h>
+
+/**
+ * @brief a slab allocator for objects of one fixed size
+ *
+ * Memory is requested from the system in slabs holding a larger number of
+ * objects, which are then handed out in order. Released objects are kept in
+ * a free list and are reused first. Once the last object is released all
+ * slabs are given back at once.
+ *
+ * Every slab knows the pool it belongs to, so objects can be released without
+ * knowing where they were allocated from. A pool is only created with
+ * create() and is destroyed once its owner called disown() and the last
+ * object is released, so objects may outlive the owner of the pool.
+ *
+ * All operations are serialized by a mutex, so objects may be created and
+ * released from different threads.
+ */
+class object_pool {
+  struct slab_t {
+    object_pool *owner;
+    slab_t *next;
+  };
+  struct free_t {
+    free_t *next;
+  };
+
+  enum {
+    SlabSize = 64 * 1024 ///< the size of one slab in bytes, slabs are aligned to this
+  };
+
+  const std::size_t stride;     ///< the object size padded for alignment
+  const std::size_t slabObjects; ///< number of objects in one slab
+  slab_t *slabs;                ///< the most recently allocated slab, linked to the older ones
+  free_t *freeList;
+  std::size_t slabUsed;         ///< number of objects handed out from the current slab
+  std::size_t live;             ///< number of objects currently in use
+  bool owned;                   ///< if the owner still holds a reference to this pool
+  std::mutex mutex;
+
+  explicit object_pool(std::size_t size);
+  ~object_pool();
+
+  object_pool(const object_pool &) O2G_DELETED_FUNCTION;
+  object_pool &operator=(const object_pool &) O2G_DELETED_FUNCTION;
+
+  void releaseSlabs();
+  void releaseObject(void *p);
+
+public:
+  /**
+   * @brief create a new pool for objects of the given size
+   */
+  static object_pool *create(std::size_t size);
+
+  /**
+   * @brief give up the reference of the creator
+   *
+   * The pool is destroyed immediately if no object is alive anymore,
+   * otherwise once the last object is released.
+   */
+  void disown();
+
+  /**
+   * @brief allocate memory for one object
+   */
+  void *allocate();
+
+  /**
+   * @brief release the memory of an object allocated from any pool
+   */
+  static void release(void *p);
+
+  /**
+   * @brief the number of objects currently allocated from this pool
+   */
+  inline std::size_t size() const noexcept
+  { return live; }
+
+  /**
+   * @brief the number of slabs currently held by this pool
+   */
+  std::size_t slabCount() const noexcept;
+};
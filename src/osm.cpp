@@ -15,6 +15,7 @@
 #include "cache_set.h"
 #include "map.h"
 #include "misc.h"
+#include "object_pool.h"
 #include "osm_objects.h"
 #include "pos.h"
 
@@ -26,6 +27,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <limits>
 #include <numeric>
 #include <optional>
 #include <string>
@@ -39,6 +41,15 @@
 
 cache_set value_cache;
 
+namespace {
+
+inline bool objectCompare(const base_object_t *a, const base_object_t *b)
+{
+  return a->id < b->id;
+}
+
+} // namespace
+
 bool object_t::operator==(const object_t &other) const noexcept
 {
   // the base types must be identical
@@ -164,6 +175,7 @@ void relation_object_replacer::operator()(relation_t *r)
     osm->mark_dirty(r);
 
     it->object = replace;
+    osm->addMemberRef(replace, r);
 
     // check if this member now is the same as the next or previous one
     if((it != itBegin && *std::prev(it) == *it) || (std::next(it) != itEnd && *it == *std::next(it))) {
@@ -187,12 +199,11 @@ public:
                                        std::vector<relation_t *> &firstRels,
                                        std::vector<relation_t *> &secondRels)
     : arels(firstRels), brels(secondRels), a(first), b(second) {}
-  void operator()(const std::pair<item_id_t, relation_t *> &p);
+  void operator()(relation_t *rel);
 };
 
-void relation_membership_functor::operator()(const std::pair<item_id_t, relation_t *>& p)
+void relation_membership_functor::operator()(relation_t *rel)
 {
-  relation_t * const rel = p.second;
   const std::vector<member_t>::const_iterator itEnd = rel->members.end();
   bool aFound = false, bFound = false;
   for(std::vector<member_t>::const_iterator it = rel->members.begin();
@@ -219,7 +230,15 @@ bool osm_t::checkObjectPersistence(const object_t &first, const object_t &second
 
   std::vector<relation_t *> removeRels, keepRels;
 
-  std::for_each(relations.begin(), relations.end(), relation_membership_functor(remove, keep, removeRels, keepRels));
+  // only the relations containing any of both objects need to be checked
+  std::vector<relation_t *> candidates = object_relations(remove);
+  const std::vector<relation_t *> &krels = object_relations(keep);
+  const size_t rcnt = candidates.size();
+  candidates.insert(candidates.end(), krels.begin(), krels.end());
+  std::inplace_merge(candidates.begin(), std::next(candidates.begin(), rcnt), candidates.end(), objectCompare);
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  std::for_each(candidates.begin(), candidates.end(), relation_membership_functor(remove, keep, removeRels, keepRels));
   const base_object_t * const keepObj = static_cast<base_object_t *>(keep);
   const base_object_t * const removeObj = static_cast<base_object_t *>(remove);
 
@@ -263,8 +282,8 @@ class find_way_ends {
   const node_t * const node;
 public:
   explicit find_way_ends(const node_t *n) : node(n) {}
-  bool operator()(const std::pair<item_id_t, way_t *> &p) const {
-    return p.second->ends_with_node(node);
+  bool operator()(const way_t *w) const {
+    return w->ends_with_node(node);
   }
 };
 
@@ -280,8 +299,8 @@ osm_t::mergeResult<node_t> osm_t::mergeNodes(node_t *first, node_t *second, std:
   mark_dirty(remove);
 
   /* use "second" position as that was the target */
-  keep->lpos = second->lpos;
   keep->pos = second->pos;
+  nodeGrid.move(keep, second->lpos);
 
 #if O2G_COMPILER_IS_GNU && ((__GNUC__ * 100 + __GNUC_MINOR__) < 403)
   mergeways.assign(nullptr);
@@ -290,20 +309,20 @@ osm_t::mergeResult<node_t> osm_t::mergeNodes(node_t *first, node_t *second, std:
 #endif
   bool mayMerge = keep->ways == 1 && remove->ways == 1; // if there could be mergeable ways
 
-  const std::map<item_id_t, way_t *>::iterator witEnd = ways.end();
-  const std::map<item_id_t, way_t *>::iterator witBegin = ways.begin();
-  std::map<item_id_t, way_t *>::iterator wit;
   if(mayMerge) {
     // only ways ending in that node are considered
-    wit = std::find_if(witBegin, witEnd, find_way_ends(keep));
-    if(wit != witEnd)
-      mergeways[0] = wit->second;
+    const way_chain_t &kways = node_ways(keep);
+    const way_chain_t::const_iterator wit = std::find_if(kways.begin(), kways.end(), find_way_ends(keep));
+    if(wit != kways.end())
+      mergeways[0] = *wit;
     else
       mayMerge = false;
   }
 
-  for(wit = witBegin; remove->ways > 0 && wit != witEnd; wit++) {
-    way_t * const way = wit->second;
+  const way_chain_t &rways = node_ways(remove);
+  const way_chain_t::const_iterator witEnd = rways.end();
+  for(way_chain_t::const_iterator wit = rways.begin(); remove->ways > 0 && wit != witEnd; wit++) {
+    way_t * const way = *wit;
     const node_chain_t::iterator itBegin = way->node_chain.begin();
     node_chain_t::iterator it = itBegin;
     node_chain_t::iterator itEnd = way->node_chain.end();
@@ -331,6 +350,7 @@ osm_t::mergeResult<node_t> osm_t::mergeNodes(node_t *first, node_t *second, std:
         // no need to check this one again
         it++;
         keep->ways++;
+        addNodeWayRef(keep, way);
       }
 
       /* and adjust way references of remove */
@@ -346,6 +366,7 @@ osm_t::mergeResult<node_t> osm_t::mergeNodes(node_t *first, node_t *second, std:
 
   /* transfer tags from "remove" to "keep" */
   bool conflict = keep->tags.merge(remove->tags);
+  addTagRefs(object_t(keep));
 
   /* remove must not have any references to ways anymore */
   assert_cmpnum(remove->ways, 0);
@@ -406,15 +427,17 @@ bool tag_list_t::merge(tag_list_t &other)
     return false;
 
   if(empty()) {
-    contents.swap(other.contents);
+    swap(other);
     return false;
   }
 
   bool conflict = false;
+  // the current contents may be shared with other objects, so build a new list
+  std::vector<tag_t> ntags = contents->tags;
 
   /* ---------- transfer tags from way[1] to way[0] ----------- */
-  const std::vector<tag_t>::const_iterator itEnd = other.contents->end();
-  for(std::vector<tag_t>::const_iterator srcIt = std::cbegin(*other.contents); srcIt != itEnd; srcIt++) {
+  const std::vector<tag_t>::const_iterator itEnd = other.contents->tags.end();
+  for(std::vector<tag_t>::const_iterator srcIt = std::cbegin(other.contents->tags); srcIt != itEnd; srcIt++) {
     const tag_t &src = *srcIt;
     /* don't copy discardable tags or tags that already
      * exist in identical form */
@@ -422,11 +445,16 @@ bool tag_list_t::merge(tag_list_t &other)
       /* check if same key but with different value is present */
       if(!conflict)
         conflict = contains(tag_match_functor(src, false));
-      contents->push_back(src);
+      ntags.push_back(src);
     }
   }
 
-  other.contents.reset();
+  other.clear();
+#if __cplusplus >= 201103L
+  replace(std::move(ntags));
+#else
+  replace(ntags);
+#endif
 
   return conflict;
 }
@@ -458,7 +486,7 @@ public:
  */
 template<typename T>
 static std::optional<bool> tag_list_compare_base(const tag_list_t &list,
-                                                 const std::unique_ptr<std::vector<tag_t> > &contents,
+                                                 const tag_set_t *contents,
                                                  const T &other, unsigned int &t1discardables)
 {
   if(list.empty() && other.empty())
@@ -475,9 +503,13 @@ static std::optional<bool> tag_list_compare_base(const tag_list_t &list,
     return (other.size() != t2discardables);
 
   /* first check list length, otherwise deleted tags are hard to detect */
-  std::vector<tag_t>::size_type ocnt = contents->size();
-  const std::vector<tag_t>::const_iterator t1End = contents->end();
-  t1discardables = std::count_if(std::cbegin(*contents), t1End, check_discardable_tag());
+  std::vector<tag_t>::size_type ocnt = contents->tags.size();
+  if(contents->discardables) {
+    const std::vector<tag_t>::const_iterator t1End = contents->tags.end();
+    t1discardables = std::count_if(std::cbegin(contents->tags), t1End, check_discardable_tag());
+  } else {
+    t1discardables = 0;
+  }
 
   // the result can't become negative here as it was checked before that contents is not empty
   if (other.size() - t2discardables != ocnt - t1discardables)
@@ -495,8 +527,8 @@ bool tag_list_t::operator!=(const std::vector<tag_t> &t2) const {
   const std::vector<tag_t>::const_iterator t2End = t2.end();
   const std::vector<tag_t>::const_iterator t2start = t2.begin();
 
-  std::vector<tag_t>::const_iterator t1it = contents->begin();
-  const std::vector<tag_t>::const_iterator t1End = contents->end();
+  std::vector<tag_t>::const_iterator t1it = contents->tags.begin();
+  const std::vector<tag_t>::const_iterator t1End = contents->tags.end();
 
   for (; t1it != t1End; t1it++) {
     if (t1discardables && t1it->is_discardable()) {
@@ -525,8 +557,8 @@ bool tag_list_t::operator!=(const osm_t::TagMap &t2) const {
   if(r)
     return *r;
 
-  std::vector<tag_t>::const_iterator t1it = contents->begin();
-  const std::vector<tag_t>::const_iterator t1End = contents->end();
+  std::vector<tag_t>::const_iterator t1it = contents->tags.begin();
+  const std::vector<tag_t>::const_iterator t1End = contents->tags.end();
 
   for (; t1it != t1End; t1it++) {
     if (t1discardables && t1it->is_discardable()) {
@@ -570,8 +602,8 @@ bool tag_list_t::hasTagCollisions() const
   if(empty())
     return false;
 
-  const std::vector<tag_t>::const_iterator itEnd = contents->end();
-  for(std::vector<tag_t>::const_iterator it = contents->begin();
+  const std::vector<tag_t>::const_iterator itEnd = contents->tags.end();
+  for(std::vector<tag_t>::const_iterator it = contents->tags.begin();
       std::next(it) != itEnd; it++) {
     if (std::any_of(std::next(it), itEnd, collision_functor(*it)))
       return true;
@@ -600,9 +632,63 @@ void osm_t::wipe(node_t *node)
   /* there must not be anything left in this chain */
   assert_null(node->map_item);
 
+  nodeGrid.erase(node);
+  nodeWays.erase(node);
   wipeImpl(node);
 }
 
+void osm_t::node_move(node_t *node, const pos_t &pos)
+{
+  node->pos = pos;
+  nodeGrid.move(node, pos.toLpos(bounds));
+}
+
+namespace {
+
+class node_near_functor {
+  const lpos_t pos;
+  const float radius;
+public:
+  inline node_near_functor(lpos_t p, float r) : pos(p), radius(r) {}
+  bool operator()(const node_t *node) const;
+};
+
+bool node_near_functor::operator()(const node_t *node) const
+{
+  if(node->isDeleted())
+    return true;
+
+  int nx = abs(pos.x - node->lpos.x);
+  int ny = abs(pos.y - node->lpos.y);
+
+  return !(nx < radius && ny < radius && (nx*nx + ny*ny) < radius * radius);
+}
+
+inline bool node_is_deleted(const node_t *node)
+{
+  return node->isDeleted();
+}
+
+} // namespace
+
+std::vector<node_t *> osm_t::nodes_near(lpos_t pos, float radius) const
+{
+  std::vector<node_t *> ret = nodeGrid.find(pos, static_cast<int>(ceilf(radius)));
+
+  ret.erase(std::remove_if(ret.begin(), ret.end(), node_near_functor(pos, radius)), ret.end());
+
+  return ret;
+}
+
+std::vector<node_t *> osm_t::nodes_in_area(lpos_t min, lpos_t max) const
+{
+  std::vector<node_t *> ret = nodeGrid.find(min, max);
+
+  ret.erase(std::remove_if(ret.begin(), ret.end(), node_is_deleted), ret.end());
+
+  return ret;
+}
+
 /* ------------------- way handling ------------------- */
 static void osm_unref_node(node_t* node)
 {
@@ -673,6 +759,7 @@ void relation_t::generate_member_xml(xmlNodePtr xml_node) const
 
 void osm_t::wipe(relation_t *relation)
 {
+  memberStates.erase(relation);
   wipeImpl(relation);
 }
 
@@ -795,7 +882,7 @@ xmlChar *osm_generate_xml_changeset(const std::string &comment,
 
 template<typename T> void osm_t::attachObject(T *obj)
 {
-  std::map<item_id_t, T *> &map = objects<T>();
+  object_map<T> &map = objects<T>();
 #ifndef NDEBUG
   // the variables are needed to avoid the need for "typename" because these are templates in templates
   item_id_t id = obj->id;
@@ -808,7 +895,7 @@ template<typename T> void osm_t::attachObject(T *obj)
   } else {
     // map is sorted, so use one less the first id in the container if it is negative,
     // or -1 if it is positive
-    const typename std::map<item_id_t, T *>::const_iterator it = map.begin();
+    const typename object_map<T>::const_iterator it = map.begin();
     if(it->first >= 0)
       obj->id = -1;
     else
@@ -820,92 +907,181 @@ template<typename T> void osm_t::attachObject(T *obj)
 
 node_t *osm_t::node_new(const lpos_t lpos) {
   /* convert screen position back to ll */
-  return new node_t(base_attributes(), lpos, lpos.toPos(bounds));
+  return new(pools.nodes) node_t(base_attributes(), lpos, lpos.toPos(bounds));
 }
 
 node_t *osm_t::node_new(const pos_t &pos, const base_attributes &attr)
 {
   /* convert ll position to screen */
-  return new node_t(attr, pos.toLpos(bounds), pos);
+  return new(pools.nodes) node_t(attr, pos.toLpos(bounds), pos);
 }
 
 void osm_t::attach(node_t *node) {
   attachObject(node);
+  nodeGrid.insert(node);
+  addTagRefs(object_t(node));
 }
 
 way_t *osm_t::attach(way_t *way)
 {
   attachObject(way);
+  addNodeWayRefs(way);
+  addTagRefs(object_t(way));
   return way;
 }
 
 namespace {
 
-template<typename T ENABLE_IF_CONVERTIBLE(T *, base_object_t *)> bool
-unmarkedDirty(T *obj, const base_object_t *orig, osm_t *osm)
+node_t *
+cloneSharingRefs(node_t &o, const osm_t::pools_t &pools)
 {
-  if (*obj == *static_cast<const T *>(orig)) {
-    osm->unmark_dirty(obj);
-    return true;
-  }
+  return new(pools.nodes) node_t(o);
+}
 
-  return false;
+way_t *
+cloneSharingRefs(way_t &o, const osm_t::pools_t &pools)
+{
+  node_chain_t nodes;
+  nodes.swap(o.node_chain);
+  way_t *ret = new(pools.ways) way_t(o);
+  o.node_chain.swap(nodes);
+  ret->flags = OSM_FLAG_SHARED;
+  return ret;
+}
+
+relation_t *
+cloneSharingRefs(relation_t &o, const osm_t::pools_t &pools)
+{
+  std::vector<member_t> members;
+  members.swap(o.members);
+  relation_t *ret = new(pools.relations) relation_t(o);
+  o.members.swap(members);
+  ret->flags = OSM_FLAG_SHARED;
+  return ret;
+}
+
+inline void
+copySharedRefs(way_t *orig, const way_t &obj)
+{
+  orig->node_chain = obj.node_chain;
+}
+
+inline void
+copySharedRefs(relation_t *orig, const relation_t &obj)
+{
+  orig->members = obj.members;
+}
+
+inline void
+hashCombine(std::size_t &seed, std::size_t v)
+{
+  seed ^= v + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+std::size_t
+sharedRefsHash(const node_t &)
+{
+  return 0;
+}
+
+std::size_t
+sharedRefsHash(const way_t &way)
+{
+  std::size_t ret = way.node_chain.size();
+  const node_chain_t::const_iterator itEnd = way.node_chain.end();
+  for (node_chain_t::const_iterator it = way.node_chain.begin(); it != itEnd; it++)
+    hashCombine(ret, std::hash<const node_t *>()(*it));
+  return ret;
+}
+
+std::size_t
+sharedRefsHash(const relation_t &relation)
+{
+  std::size_t ret = relation.members.size();
+  const std::vector<member_t>::const_iterator itEnd = relation.members.end();
+  for (std::vector<member_t>::const_iterator it = relation.members.begin(); it != itEnd; it++) {
+    hashCombine(ret, std::hash<item_id_t>()(it->object.get_id()));
+    hashCombine(ret, it->object.type);
+    hashCombine(ret, std::hash<const char *>()(it->role));
+  }
+  return ret;
 }
 
 } // namespace
 
-void
-osm_t::updateTags(object_t o, const TagMap &ntags)
+template<typename T>
+bool osm_t::isUnmodified(const T &obj, const T &orig) const
+{
+  if (orig.flags & OSM_FLAG_SHARED) {
+    // The shared parts should have been copied by mark_dirty() before they
+    // were changed, but be conservative if someone modified them directly.
+    const std::unordered_map<const base_object_t *, std::size_t>::const_iterator it = sharedRefsHashes.find(&orig);
+    return it != sharedRefsHashes.end() && it->second == sharedRefsHash(obj) &&
+           static_cast<const base_attributes &>(obj) == orig && obj.tags == orig.tags;
+  }
+
+  return obj == orig;
+}
+
+template<typename T>
+void osm_t::markTagsDirty(T *obj)
 {
-  // when no tags have changed at this point nothing has to be updated
-  if (static_cast<base_object_t *>(o)->tags == ntags)
+  if (obj->flags != 0 || obj->isNew())
     return;
 
-  const base_object_t * const origobj = originalObject(o);
-  bool tagsUpdated = false;
+  std::unordered_map<item_id_t, const T *> &orig = originalObjects<T>();
 
-  if (origobj != nullptr) {
-    static_cast<base_object_t *>(o)->tags.replace(ntags);
-    tagsUpdated = true;
+  assert(orig.find(obj->id) == orig.end());
 
-    // reset the objects to being unmodified if possible
-    switch (o.type) {
-    case object_t::NODE:
-      if (unmarkedDirty(static_cast<node_t *>(o), origobj, this))
-        return;
-      break;
-    case object_t::WAY:
-      if (unmarkedDirty(static_cast<way_t *>(o), origobj, this))
-        return;
-      break;
-    case object_t::RELATION:
-      if (unmarkedDirty(static_cast<relation_t *>(o), origobj, this))
-        return;
-      break;
-    default:
-      assert_unreachable();
-    }
-  }
+  T *n = cloneSharingRefs(*obj, pools);
+  cleanupOriginalObject(n);
+  orig[obj->id] = n;
+  if (n->flags & OSM_FLAG_SHARED)
+    sharedRefsHashes[n] = sharedRefsHash(*obj);
 
-  // only mark dirty if this will actually change something
-  if (static_cast<base_object_t *>(o)->tags != ntags) {
-    switch (o.type) {
-    case object_t::NODE:
-      mark_dirty(static_cast<node_t *>(o));
-      break;
-    case object_t::WAY:
-      mark_dirty(static_cast<way_t *>(o));
-      break;
-    case object_t::RELATION:
-      mark_dirty(static_cast<relation_t *>(o));
-      break;
-    default:
-      assert_unreachable();
-    }
+  obj->flags |= OSM_FLAG_DIRTY;
+}
+
+template<typename T>
+void osm_t::updateObjectTags(T *obj, const TagMap &ntags)
+{
+  const T * const origobj = findSharedOriginalById<T>(obj->id);
+
+  if (origobj == nullptr) {
+    markTagsDirty(obj);
+    obj->tags.replace(ntags);
+    addTagRefs(object_t(obj));
+    return;
   }
 
-  if (!tagsUpdated)
-    static_cast<base_object_t *>(o)->tags.replace(ntags);
+  obj->tags.replace(ntags);
+  addTagRefs(object_t(obj));
+
+  // reset the objects to being unmodified if possible
+  if (isUnmodified(*obj, *origobj))
+    unmark_dirty(obj);
+}
+
+void
+osm_t::updateTags(object_t o, const TagMap &ntags)
+{
+  // when no tags have changed at this point nothing has to be updated
+  if (static_cast<base_object_t *>(o)->tags == ntags)
+    return;
+
+  switch (o.type) {
+  case object_t::NODE:
+    updateObjectTags(static_cast<node_t *>(o), ntags);
+    break;
+  case object_t::WAY:
+    updateObjectTags(static_cast<way_t *>(o), ntags);
+    break;
+  case object_t::RELATION:
+    updateObjectTags(static_cast<relation_t *>(o), ntags);
+    break;
+  default:
+    assert_unreachable();
+  }
 }
 
 namespace {
@@ -917,12 +1093,11 @@ class node_chain_delete_functor {
 public:
   inline node_chain_delete_functor(osm_t *o, const node_t *n, way_chain_t &w)
     : osm(o), node(n), way_chain(w) {}
-  void operator()(std::pair<item_id_t, way_t *> p);
+  void operator()(way_t *way);
 };
 
-void node_chain_delete_functor::operator()(std::pair<item_id_t, way_t *> p)
+void node_chain_delete_functor::operator()(way_t *way)
 {
-  way_t * const way = p.second;
   node_chain_t &chain = way->node_chain;
   bool modified = false;
 
@@ -974,27 +1149,27 @@ void node_deleted_from_ways::operator()(way_t *way)
 }
 
 node_t *
-cloneForDeletion(node_t &o)
+cloneForDeletion(node_t &o, const osm_t::pools_t &pools)
 {
-  return new node_t(o);
+  return new(pools.nodes) node_t(o);
 }
 
 way_t *
-cloneForDeletion(way_t &o)
+cloneForDeletion(way_t &o, const osm_t::pools_t &pools)
 {
   node_chain_t nodes;
   nodes.swap(o.node_chain);
-  way_t *ret = new way_t(o);
+  way_t *ret = new(pools.ways) way_t(o);
   ret->node_chain.swap(nodes);
   return ret;
 }
 
 relation_t *
-cloneForDeletion(relation_t &o)
+cloneForDeletion(relation_t &o, const osm_t::pools_t &pools)
 {
   std::vector<member_t> members;
   members.swap(o.members);
-  relation_t *ret = new relation_t(o);
+  relation_t *ret = new(pools.relations) relation_t(o);
   ret->members.swap(members);
   return ret;
 }
@@ -1029,7 +1204,7 @@ void osm_t::markDeleted(T &obj)
 
     tag_list_t tags;
     tags.swap(obj.tags);
-    T *n = cloneForDeletion(obj);
+    T *n = cloneForDeletion(obj, pools);
     n->tags.swap(tags);
     cleanupOriginalObject(n);
     orig[obj.id] = n;
@@ -1043,10 +1218,10 @@ osm_t::node_delete(node_t *node, NodeDeleteFlags flags, map_t *map)
 {
   way_chain_t way_chain;
 
-  // no need to iterate all ways if we already know in advance that none references this node
-  if (node->ways > 0 && flags != NodeDeleteKeepRefs) {
+  if (flags != NodeDeleteKeepRefs) {
     /* first remove node from all ways using it */
-    std::for_each(ways.begin(), ways.end(),
+    const way_chain_t &nways = node_ways(node);
+    std::for_each(nways.begin(), nways.end(),
                   node_chain_delete_functor(this, node, way_chain));
   }
 
@@ -1067,12 +1242,11 @@ class remove_member_functor {
   const object_t obj;
 public:
   explicit inline remove_member_functor(osm_t *o, object_t ob) : osm(o), obj(ob) {}
-  void operator()(std::pair<item_id_t, relation_t *> pair);
+  void operator()(relation_t *relation);
 };
 
-void remove_member_functor::operator()(std::pair<item_id_t, relation_t *> pair)
+void remove_member_functor::operator()(relation_t *relation)
 {
-  relation_t * const relation = pair.second;
   std::vector<member_t>::iterator itEnd = relation->members.end();
   std::vector<member_t>::iterator it = relation->members.begin();
 
@@ -1091,13 +1265,15 @@ void remove_member_functor::operator()(std::pair<item_id_t, relation_t *> pair)
 void osm_t::remove_from_relations(object_t obj) {
   printf("removing %s #" ITEM_ID_FORMAT " from all relations:\n", static_cast<base_object_t *>(obj)->apiString(), obj.get_id());
 
-  std::for_each(relations.begin(), relations.end(),
-                remove_member_functor(this, obj));
+  const std::vector<relation_t *> &rels = object_relations(obj);
+  std::for_each(rels.begin(), rels.end(), remove_member_functor(this, obj));
 }
 
 relation_t *osm_t::attach(relation_t *relation)
 {
   attachObject(relation);
+  addMemberRefs(relation);
+  addTagRefs(object_t(relation));
   return relation;
 }
 
@@ -1142,6 +1318,8 @@ void osm_t::way_delete(way_t *way, map_t *map, void (*unref)(node_t *))
 
   /* remove it visually from the screen */
   way->item_chain_destroy(map);
+  if(map != nullptr)
+    map->way_deleted(way);
 
   /* delete all nodes that aren't in other use now */
   node_chain_t &chain = way->node_chain;
@@ -1155,8 +1333,16 @@ void osm_t::way_delete(way_t *way, map_t *map, void (*unref)(node_t *))
 
   if(!way->isNew()) {
     // this is already in the original list, so no need to keep the vector around
-    if (way->flags & OSM_FLAG_DIRTY)
+    if (way->flags & OSM_FLAG_DIRTY) {
+      way_t * const orig = const_cast<way_t *>(findSharedOriginalById<way_t>(way->id));
+      if (orig != nullptr && (orig->flags & OSM_FLAG_SHARED)) {
+        // the original still uses the same nodes, just hand them over
+        orig->node_chain.swap(chain);
+        orig->flags &= ~OSM_FLAG_SHARED;
+        sharedRefsHashes.erase(orig);
+      }
       chain.clear();
+    }
   }
 
   markDeleted(*way);
@@ -1176,9 +1362,11 @@ void osm_t::relation_delete(relation_t *relation) {
 
 class reverse_direction_sensitive_tags_functor {
   unsigned int &n_tags_altered;
+  std::vector<tag_t> &ntags;
 public:
-  explicit inline reverse_direction_sensitive_tags_functor(unsigned int &c) : n_tags_altered(c) {}
-  void operator()(tag_t &etag);
+  inline reverse_direction_sensitive_tags_functor(unsigned int &c, std::vector<tag_t> &t)
+    : n_tags_altered(c), ntags(t) {}
+  void operator()(const tag_t &otag);
 };
 
 #if __cplusplus >= 201703L
@@ -1200,7 +1388,7 @@ static rtable_type rtable_init()
   return rtable;
 }
 
-void reverse_direction_sensitive_tags_functor::operator()(tag_t &etag)
+void reverse_direction_sensitive_tags_functor::operator()(const tag_t &otag)
 {
   static const char *oneway = value_cache.insert("oneway");
   static const char *sidewalk = value_cache.insert("sidewalk");
@@ -1209,6 +1397,9 @@ void reverse_direction_sensitive_tags_functor::operator()(tag_t &etag)
   static const char *left = value_cache.insert("left");
   static const char *right = value_cache.insert("right");
 
+  ntags.push_back(otag);
+  tag_t &etag = ntags.back();
+
   if (etag.key_compare(oneway)) {
     // oneway={yes/true/1/-1} is unusual.
     // Favour "yes" and "-1".
@@ -1264,15 +1455,14 @@ class reverse_roles {
   unsigned int &n_roles_flipped;
 public:
   inline reverse_roles(osm_t::ref o, way_t *w, unsigned int &n) : osm(o), way(w), n_roles_flipped(n) {}
-  void operator()(const std::pair<item_id_t, relation_t *> &pair);
+  void operator()(relation_t *relation);
 };
 
-void reverse_roles::operator()(const std::pair<item_id_t, relation_t *> &pair)
+void reverse_roles::operator()(relation_t *relation)
 {
   static const char *DS_ROUTE_FORWARD = value_cache.insert("forward");
   static const char *DS_ROUTE_REVERSE = value_cache.insert("backward");
 
-  relation_t * const relation = pair.second;
   const char *type = relation->tags.get_value("type");
 
   // Route relations; https://wiki.openstreetmap.org/wiki/Relation:route
@@ -1309,12 +1499,22 @@ way_t::reverse(osm_t::ref osm)
   std::pair<unsigned int, unsigned int> ret = std::make_pair<unsigned int, unsigned int>(0, 0);
 
   osm->mark_dirty(this);
-  tags.for_each(reverse_direction_sensitive_tags_functor(ret.first));
+  // the tags may be shared with other objects, so the changed ones go to a new list
+  std::vector<tag_t> ntags;
+  tags.for_each(reverse_direction_sensitive_tags_functor(ret.first, ntags));
+  if(ret.first > 0) {
+#if __cplusplus >= 201103L
+    tags.replace(std::move(ntags));
+#else
+    tags.replace(ntags);
+#endif
+    osm->addTagRefs(object_t(this));
+  }
 
   std::reverse(node_chain.begin(), node_chain.end());
 
-  reverse_roles context(osm, this, ret.second);
-  std::for_each(osm->relations.begin(), osm->relations.end(), context);
+  const std::vector<relation_t *> &rels = osm->object_relations(object_t(this));
+  std::for_each(rels.begin(), rels.end(), reverse_roles(osm, this, ret.second));
 
   return ret;
 }
@@ -1380,12 +1580,11 @@ class relation_transfer {
   const way_t * const src;
 public:
   inline relation_transfer(osm_t::ref o, way_t *d, const way_t *s) : osm(o), dst(d), src(s) {}
-  void operator()(const std::pair<item_id_t, relation_t *> &pair) const;
+  void operator()(relation_t *relation) const;
 };
 
-void relation_transfer::operator()(const std::pair<item_id_t, relation_t *> &pair) const
+void relation_transfer::operator()(relation_t *relation) const
 {
-  relation_t * const relation = pair.second;
   /* walk member chain. save role of way if its being found. */
   const object_t osrc(const_cast<way_t *>(src));
   find_member_object_functor fc(osrc);
@@ -1397,6 +1596,7 @@ void relation_transfer::operator()(const std::pair<item_id_t, relation_t *> &pai
     return;
 
   osm->mark_dirty(relation);
+  osm->addMemberRef(object_t(dst), relation);
 
   for(; it != itEnd; it = std::find_if(std::next(it), itEnd, fc)) {
     printf("way #" ITEM_ID_FORMAT " is part of relation #" ITEM_ID_FORMAT " at position %zu, adding way #" ITEM_ID_FORMAT "\n",
@@ -1486,15 +1686,18 @@ way_t *way_t::split(osm_t::ref osm, node_chain_t::iterator cut_at, bool cut_at_n
   // keep the history with the longer way
   // this must be before the relation transfer, as that needs to know the
   // contained nodes to determine proper ordering in the relations
-  if(node_chain.size() < neww->node_chain.size())
+  if(node_chain.size() < neww->node_chain.size()) {
     node_chain.swap(neww->node_chain);
+    osm->addNodeWayRefs(this);
+  }
 
   // now move the way itself into the main data structure
   // do it before transferring the relation membership to get meaningful ids in debug output
   way_t *ret = osm->attach(neww.release());
 
   /* ---- transfer relation membership from way to new ----- */
-  std::for_each(osm->relations.begin(), osm->relations.end(), relation_transfer(osm, ret, this));
+  const std::vector<relation_t *> &rels = osm->object_relations(object_t(this));
+  std::for_each(rels.begin(), rels.end(), relation_transfer(osm, ret, this));
 
   return ret;
 }
@@ -1513,11 +1716,22 @@ osm_t::TagMap tag_list_t::asMap() const
   osm_t::TagMap new_tags;
 
   if(!empty())
-    std::for_each(contents->begin(), contents->end(), tag_map_functor(new_tags));
+    std::for_each(contents->tags.begin(), contents->tags.end(), tag_map_functor(new_tags));
 
   return new_tags;
 }
 
+void tag_list_t::share(const tag_list_t &other)
+{
+  assert(!contents);
+
+  if(other.empty())
+    return;
+
+  contents = other.contents;
+  contents->refcount++;
+}
+
 void tag_list_t::copy(const tag_list_t &other)
 {
   assert(!contents);
@@ -1525,10 +1739,22 @@ void tag_list_t::copy(const tag_list_t &other)
   if(other.empty())
     return;
 
-  contents.reset(new std::vector<tag_t>());
-  contents->reserve(other.contents->size());
+  // nothing to filter out, so simply share the contents
+  if(!other.contents->discardables) {
+    contents = other.contents;
+    contents->refcount++;
+    return;
+  }
 
-  std::remove_copy_if(other.contents->begin(), other.contents->end(), std::back_inserter(*contents), tag_t::isDiscardable);
+  std::vector<tag_t> ntags;
+  ntags.reserve(other.contents->tags.size());
+
+  std::remove_copy_if(other.contents->tags.begin(), other.contents->tags.end(), std::back_inserter(ntags), tag_t::isDiscardable);
+#if __cplusplus >= 201103L
+  replace(std::move(ntags));
+#else
+  replace(ntags);
+#endif
 }
 
 member_t::member_t(object_t::type_t t) noexcept
@@ -1557,8 +1783,8 @@ bool member_t::operator==(const member_t &other) const noexcept
 
 template<typename T> T *osm_t::object_by_id(item_id_t id) const
 {
-  const std::map<item_id_t, T *> &map = objects<T>();
-  const typename std::map<item_id_t, T *>::const_iterator it = map.find(id);
+  const object_map<T> &map = objects<T>();
+  const typename object_map<T>::const_iterator it = map.find(id);
   if(it != map.end())
     return it->second;
 
@@ -1569,7 +1795,7 @@ template node_t *osm_t::object_by_id(item_id_t id) const;
 template way_t *osm_t::object_by_id(item_id_t id) const;
 template relation_t *osm_t::object_by_id(item_id_t id) const;
 
-template<typename T> const T *osm_t::findOriginalById(item_id_t id) const
+template<typename T> const T *osm_t::findSharedOriginalById(item_id_t id) const
 {
   const std::unordered_map<item_id_t, const T *> &map = originalObjects<T>();
   const typename std::unordered_map<item_id_t, const T *>::const_iterator it = map.find(id);
@@ -1579,8 +1805,56 @@ template<typename T> const T *osm_t::findOriginalById(item_id_t id) const
   return nullptr;
 }
 
+template<typename T> const T *osm_t::findOriginalById(item_id_t id) const
+{
+  const T * const orig = findSharedOriginalById<T>(id);
+
+  // only complete objects are handed out
+  if(orig != nullptr && unlikely(orig->flags & OSM_FLAG_SHARED))
+    const_cast<osm_t *>(this)->unshareOriginal(object_by_id<T>(id));
+
+  return orig;
+}
+
+void osm_t::unshareOriginal(way_t *way)
+{
+  way_t * const orig = const_cast<way_t *>(findSharedOriginalById<way_t>(way->id));
+  if(orig != nullptr && (orig->flags & OSM_FLAG_SHARED)) {
+    copySharedRefs(orig, *way);
+    orig->flags &= ~OSM_FLAG_SHARED;
+    sharedRefsHashes.erase(orig);
+  }
+}
+
+void osm_t::unshareOriginal(relation_t *relation)
+{
+  relation_t * const orig = const_cast<relation_t *>(findSharedOriginalById<relation_t>(relation->id));
+  if(orig != nullptr && (orig->flags & OSM_FLAG_SHARED)) {
+    copySharedRefs(orig, *relation);
+    orig->flags &= ~OSM_FLAG_SHARED;
+    sharedRefsHashes.erase(orig);
+  }
+}
+
+osm_t::pools_t::pools_t()
+  : nodes(object_pool::create(sizeof(node_t)))
+  , ways(object_pool::create(sizeof(way_t)))
+  , relations(object_pool::create(sizeof(relation_t)))
+{
+}
+
+osm_t::pools_t::~pools_t()
+{
+  nodes->disown();
+  ways->disown();
+  relations->disown();
+}
+
 osm_t::osm_t()
   : uploadPolicy(Upload_Normal)
+  , tagIndexValid(false)
+  , tagIndexEntries(0)
+  , tagIndexLimit(0)
 {
   bounds.ll = pos_area(pos_t(NAN, NAN), pos_t(NAN, NAN));
 }
@@ -1617,13 +1891,13 @@ namespace {
 template<typename T ENABLE_IF_CONVERTIBLE(T *, base_object_t *)>
 class object_counter {
   osm_t::dirty_t::counter<T> &dirty;
-  const std::map<item_id_t, T *> &map;
+  const object_map<T> &map;
 public:
-  explicit inline object_counter(osm_t::dirty_t::counter<T> &d, const std::map<item_id_t, T *> &m) : dirty(d), map(m) {}
+  explicit inline object_counter(osm_t::dirty_t::counter<T> &d, const object_map<T> &m) : dirty(d), map(m) {}
   void operator()(std::pair<item_id_t, const T *> pair)
   {
     const T * const origObj = pair.second;
-    const typename std::map<item_id_t, T *>::const_iterator mit = map.find(origObj->id);
+    const typename object_map<T>::const_iterator mit = map.find(origObj->id);
     assert(mit != map.end());
     T * const obj = mit->second;
 
@@ -1636,20 +1910,15 @@ public:
   }
 };
 
-inline bool objectCompare(const base_object_t *a, const base_object_t *b)
-{
-  return a->id < b->id;
-}
-
 } // namespace
 
 template<typename T>
 osm_t::dirty_t::counter<T>::counter(const osm_t &osm)
   : total(osm.objects<T>().size())
 {
-  const std::map<item_id_t, T *> &map = osm.objects<T>();
-  typename std::map<item_id_t, T *>::const_iterator it = map.begin();
-  typename std::map<item_id_t, T *>::const_iterator itEnd = map.end();
+  const object_map<T> &map = osm.objects<T>();
+  typename object_map<T>::const_iterator it = map.begin();
+  typename object_map<T>::const_iterator itEnd = map.end();
 
   while (it != itEnd && it->second->isNew()) {
     added.push_back(it->second);
@@ -1666,7 +1935,7 @@ osm_t::dirty_t::counter<T>::counter(const osm_t &osm)
 namespace {
 
 template<typename T>
-inline void object_insert(std::map<item_id_t, T *> &map, T *o)
+inline void object_insert(object_map<T> &map, T *o)
 {
   bool b = map.insert(std::make_pair(o->id, o)).second;
   assert(b); (void)b;
@@ -1677,16 +1946,596 @@ inline void object_insert(std::map<item_id_t, T *> &map, T *o)
 void osm_t::insert(node_t *node)
 {
   object_insert(nodes, node);
+  nodeGrid.insert(node);
+  addTagRefs(object_t(node));
 }
 
 void osm_t::insert(way_t *way)
 {
   object_insert(ways, way);
+  addNodeWayRefs(way);
+  addTagRefs(object_t(way));
 }
 
 void osm_t::insert(relation_t *relation)
 {
   object_insert(relations, relation);
+  addMemberRefs(relation);
+  addTagRefs(object_t(relation));
+}
+
+void node_grid_t::insert(node_t *node)
+{
+  cells[cellKey(node->lpos)].push_back(node);
+}
+
+bool node_grid_t::eraseFromCell(const std::unordered_map<uint64_t, std::vector<node_t *> >::iterator cit, const node_t *node)
+{
+  std::vector<node_t *> &cell = cit->second;
+  const std::vector<node_t *>::iterator it = std::find(cell.begin(), cell.end(), node);
+  if(it == cell.end())
+    return false;
+
+  // order inside the cell does not matter
+  *it = cell.back();
+  cell.pop_back();
+  if(cell.empty())
+    cells.erase(cit);
+
+  return true;
+}
+
+bool node_grid_t::erase(node_t *node, lpos_t pos)
+{
+  typedef std::unordered_map<uint64_t, std::vector<node_t *> >::iterator CellIt;
+  const CellIt cit = cells.find(cellKey(pos));
+  if(likely(cit != cells.end() && eraseFromCell(cit, node)))
+    return true;
+
+  // lpos was changed without going through osm_t::node_move(), so the node
+  // is stored at some other place, look in all cells
+  const CellIt citEnd = cells.end();
+  for(CellIt it = cells.begin(); it != citEnd; it++) {
+    if(it != cit && eraseFromCell(it, node)) {
+      printf("node " ITEM_ID_FORMAT " was not found at its position in the node grid\n", node->id);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void node_grid_t::erase(node_t *node)
+{
+  erase(node, node->lpos);
+}
+
+void node_grid_t::move(node_t *node, lpos_t pos)
+{
+  const bool known = erase(node, node->lpos);
+  node->lpos = pos;
+  if(known)
+    insert(node);
+}
+
+std::vector<node_t *> node_grid_t::find(lpos_t pos, int radius) const
+{
+  std::vector<node_t *> ret;
+
+  const int xmin = cellCoord(pos.x - radius);
+  const int xmax = cellCoord(pos.x + radius);
+  const int ymin = cellCoord(pos.y - radius);
+  const int ymax = cellCoord(pos.y + radius);
+  const std::unordered_map<uint64_t, std::vector<node_t *> >::const_iterator itEnd = cells.end();
+
+  for(int cx = xmin; cx <= xmax; cx++) {
+    for(int cy = ymin; cy <= ymax; cy++) {
+      const std::unordered_map<uint64_t, std::vector<node_t *> >::const_iterator it = cells.find(cellKey(cx, cy));
+      if(it != itEnd)
+        ret.insert(ret.end(), it->second.begin(), it->second.end());
+    }
+  }
+
+  std::sort(ret.begin(), ret.end(), objectCompare);
+
+  return ret;
+}
+
+namespace {
+
+class node_area_functor {
+  std::vector<node_t *> &ret;
+  const lpos_t min, max;
+public:
+  inline node_area_functor(std::vector<node_t *> &r, lpos_t mn, lpos_t mx)
+    : ret(r), min(mn), max(mx) {}
+
+  void operator()(int, int, const std::vector<node_t *> &cell)
+  {
+    const std::vector<node_t *>::const_iterator itEnd = cell.end();
+    for(std::vector<node_t *>::const_iterator it = cell.begin(); it != itEnd; it++) {
+      const lpos_t pos = (*it)->lpos;
+      if(pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y)
+        ret.push_back(*it);
+    }
+  }
+};
+
+} // namespace
+
+std::vector<node_t *> node_grid_t::find(lpos_t min, lpos_t max) const
+{
+  std::vector<node_t *> ret;
+
+  node_area_functor fc(ret, min, max);
+  forCells(cells, min, max, fc);
+
+  return ret;
+}
+
+/**
+ * @brief collect the entries of the cells intersecting the search area
+ *
+ * A way is stored in every cell its bounding box touches. To report it only
+ * once it is only taken from the cell that contains the upper left corner of
+ * the intersection of its bounding box and the search area.
+ */
+class way_grid_t::find_functor {
+  std::vector<way_t *> &ret;
+  const lpos_t min, max;
+public:
+  inline find_functor(std::vector<way_t *> &r, lpos_t mn, lpos_t mx)
+    : ret(r), min(mn), max(mx) {}
+
+  inline bool intersects(const entry_t &entry) const
+  {
+    return entry.min.x <= max.x && entry.max.x >= min.x &&
+           entry.min.y <= max.y && entry.max.y >= min.y;
+  }
+
+  void operator()(int cx, int cy, const std::vector<entry_t> &cell)
+  {
+    const std::vector<entry_t>::const_iterator itEnd = cell.end();
+    for(std::vector<entry_t>::const_iterator it = cell.begin(); it != itEnd; it++)
+      if(intersects(*it) &&
+         cellCoord(std::max(it->min.x, min.x)) == cx && cellCoord(std::max(it->min.y, min.y)) == cy)
+        ret.push_back(it->way);
+  }
+};
+
+void way_grid_t::update(way_t *way)
+{
+  erase(way);
+
+  if(unlikely(way->isDeleted() || way->node_chain.empty()))
+    return;
+
+  lpos_t bmin = way->node_chain.front()->lpos;
+  lpos_t bmax = bmin;
+  const node_chain_t::const_iterator itEnd = way->node_chain.end();
+  for(node_chain_t::const_iterator it = std::next(way->node_chain.begin()); it != itEnd; it++) {
+    const lpos_t &p = (*it)->lpos;
+    bmin.x = std::min(bmin.x, p.x);
+    bmin.y = std::min(bmin.y, p.y);
+    bmax.x = std::max(bmax.x, p.x);
+    bmax.y = std::max(bmax.y, p.y);
+  }
+
+  boxes[way] = std::make_pair(bmin, bmax);
+  const entry_t entry(way, bmin, bmax);
+
+  const int xmin = cellCoord(bmin.x);
+  const int xmax = cellCoord(bmax.x);
+  const int ymin = cellCoord(bmin.y);
+  const int ymax = cellCoord(bmax.y);
+  if((xmax - xmin + 1) * (ymax - ymin + 1) > MaxCells) {
+    large.push_back(entry);
+    return;
+  }
+
+  for(int cx = xmin; cx <= xmax; cx++)
+    for(int cy = ymin; cy <= ymax; cy++)
+      cells[cellKey(cx, cy)].push_back(entry);
+}
+
+namespace {
+
+template<typename T>
+bool remove_entry(std::vector<T> &entries, const way_t *way)
+{
+  typename std::vector<T>::iterator it = entries.begin();
+  const typename std::vector<T>::iterator itEnd = entries.end();
+  while(it != itEnd && it->way != way)
+    it++;
+  if(it == itEnd)
+    return false;
+
+  // order does not matter
+  *it = entries.back();
+  entries.pop_back();
+  return true;
+}
+
+} // namespace
+
+void way_grid_t::erase(const way_t *way)
+{
+  const std::unordered_map<const way_t *, std::pair<lpos_t, lpos_t> >::iterator bit = boxes.find(way);
+  if(bit == boxes.end())
+    return;
+
+  const lpos_t bmin = bit->second.first;
+  const lpos_t bmax = bit->second.second;
+  boxes.erase(bit);
+
+  const int xmin = cellCoord(bmin.x);
+  const int xmax = cellCoord(bmax.x);
+  const int ymin = cellCoord(bmin.y);
+  const int ymax = cellCoord(bmax.y);
+  if((xmax - xmin + 1) * (ymax - ymin + 1) > MaxCells) {
+    remove_entry(large, way);
+    return;
+  }
+
+  for(int cx = xmin; cx <= xmax; cx++) {
+    for(int cy = ymin; cy <= ymax; cy++) {
+      const CellMap::iterator cit = cells.find(cellKey(cx, cy));
+      if(cit == cells.end())
+        continue;
+      remove_entry(cit->second, way);
+      if(cit->second.empty())
+        cells.erase(cit);
+    }
+  }
+}
+
+std::vector<way_t *> way_grid_t::find(lpos_t min, lpos_t max) const
+{
+  std::vector<way_t *> ret;
+
+  find_functor fc(ret, min, max);
+  forCells(cells, min, max, fc);
+
+  const std::vector<entry_t>::const_iterator itEnd = large.end();
+  for(std::vector<entry_t>::const_iterator it = large.begin(); it != itEnd; it++)
+    if(fc.intersects(*it))
+      ret.push_back(it->way);
+
+  return ret;
+}
+
+void osm_t::addNodeWayRef(const node_t *node, const way_t *way)
+{
+  std::vector<item_id_t> &ids = nodeWays[node];
+  if(std::find(ids.begin(), ids.end(), way->id) == ids.end())
+    ids.push_back(way->id);
+}
+
+void osm_t::addNodeWayRefs(const way_t *way)
+{
+  const node_chain_t::const_iterator itEnd = way->node_chain.end();
+  for(node_chain_t::const_iterator it = way->node_chain.begin(); it != itEnd; it++)
+    addNodeWayRef(*it, way);
+}
+
+way_chain_t osm_t::node_ways(const node_t *node)
+{
+  way_chain_t ret;
+
+  if(node->ways == 0)
+    return ret;
+
+  std::vector<item_id_t> &ids = nodeWays[node];
+  unsigned int cnt = 0;
+
+  const object_map<way_t>::const_iterator witEnd = ways.end();
+  for(std::vector<item_id_t>::const_iterator it = ids.begin(); it != ids.end(); it++) {
+    const object_map<way_t>::const_iterator wit = ways.find(*it);
+    if(wit == witEnd)
+      continue;
+    const node_chain_t &chain = wit->second->node_chain;
+    const unsigned int c = std::count(chain.begin(), chain.end(), node);
+    if(c == 0)
+      continue;
+    cnt += c;
+    ret.push_back(wit->second);
+  }
+
+  if(unlikely(cnt != node->ways)) {
+    // the node was added to a way without updating the index, e.g. by
+    // directly modifying the node chain, so rebuild the entry
+    ret.clear();
+    for(object_map<way_t>::const_iterator wit = ways.begin(); wit != witEnd; wit++)
+      if(wit->second->contains_node(node))
+        ret.push_back(wit->second);
+  } else {
+    std::sort(ret.begin(), ret.end(), objectCompare);
+  }
+
+  // drop outdated entries
+  if(ret.size() != ids.size()) {
+    ids.resize(ret.size());
+    for(size_t i = 0; i < ret.size(); i++)
+      ids[i] = ret[i]->id;
+  }
+
+  return ret;
+}
+
+/* real objects are identified by their address as their id changes on upload, */
+/* references only by their id */
+size_t osm_t::member_key_hash::operator()(const object_t &obj) const noexcept
+{
+  if(obj.is_real())
+    return std::hash<const void *>()(static_cast<base_object_t *>(obj)) ^ obj.type;
+  return std::hash<item_id_t>()(obj.get_id()) ^ obj.type;
+}
+
+bool osm_t::member_key_equal::operator()(const object_t &a, const object_t &b) const noexcept
+{
+  if(a.type != b.type)
+    return false;
+  if(a.is_real())
+    return static_cast<base_object_t *>(a) == static_cast<base_object_t *>(b);
+  return a.get_id() == b.get_id();
+}
+
+void osm_t::addMemberRef(const object_t &obj, const relation_t *relation)
+{
+  indexMemberRef(obj, relation);
+}
+
+void osm_t::addMemberRefs(const relation_t *relation)
+{
+  indexMemberRefs(relation);
+}
+
+void osm_t::indexMemberRef(const object_t &obj, const relation_t *relation) const
+{
+  std::vector<item_id_t> &ids = memberRelations[obj];
+  if(std::find(ids.begin(), ids.end(), relation->id) == ids.end())
+    ids.push_back(relation->id);
+}
+
+void osm_t::indexMemberRefs(const relation_t *relation) const
+{
+  const std::vector<member_t>::const_iterator itEnd = relation->members.end();
+  for(std::vector<member_t>::const_iterator it = relation->members.begin(); it != itEnd; it++)
+    indexMemberRef(it->object, relation);
+
+  member_state_t &state = memberStates[relation];
+  state.first = relation->members.size();
+  state.second = relation->members.empty() ? object_t() : relation->members.back().object;
+}
+
+void osm_t::syncMemberRefs() const
+{
+  const member_key_equal equal;
+  const object_map<relation_t>::const_iterator itEnd = relations.end();
+  for(object_map<relation_t>::const_iterator it = relations.begin(); it != itEnd; it++) {
+    const relation_t * const relation = it->second;
+    const std::unordered_map<const relation_t *, member_state_t>::const_iterator sit = memberStates.find(relation);
+    if(likely(sit != memberStates.end() && sit->second.first == relation->members.size() &&
+              (relation->members.empty() || equal(sit->second.second, relation->members.back().object))))
+      continue;
+
+    // the members were changed without updating the index, e.g. by directly
+    // modifying the member list, so add the relation for all of them again
+    indexMemberRefs(relation);
+  }
+}
+
+void osm_t::collectMemberRelations(const object_t &key, const object_t &obj, std::vector<relation_t *> &rels) const
+{
+  const std::unordered_map<object_t, std::vector<item_id_t>, member_key_hash, member_key_equal>::const_iterator mit =
+      memberRelations.find(key);
+  if(mit == memberRelations.end())
+    return;
+
+  const object_map<relation_t>::const_iterator ritEnd = relations.end();
+  const std::vector<item_id_t>::const_iterator itEnd = mit->second.end();
+  for(std::vector<item_id_t>::const_iterator it = mit->second.begin(); it != itEnd; it++) {
+    const object_map<relation_t>::const_iterator rit = relations.find(*it);
+    // the relation may have been removed, or the object is no member anymore
+    if(rit != ritEnd && rit->second->find_member_object(obj) != rit->second->members.end())
+      rels.push_back(rit->second);
+  }
+}
+
+std::vector<relation_t *> osm_t::object_relations(const object_t &obj) const
+{
+  std::vector<relation_t *> ret;
+
+  syncMemberRefs();
+
+  collectMemberRelations(obj, obj, ret);
+  // members may still be stored as reference if the object was not present
+  // when the relation was created
+  if(obj.is_real())
+    collectMemberRelations(object_t(static_cast<object_t::type_t>(obj.type | object_t::_REF_FLAG), obj.get_id()), obj, ret);
+
+  std::sort(ret.begin(), ret.end(), objectCompare);
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+
+  return ret;
+}
+
+size_t osm_t::tag_key_hash::operator()(const tag_key_t &key) const noexcept
+{
+  return std::hash<const char *>()(key.first) * 31 + std::hash<const char *>()(key.second);
+}
+
+namespace {
+
+struct tag_ref_functor {
+  osm_t * const osm;
+  const object_t &obj;
+  inline tag_ref_functor(osm_t *o, const object_t &ob) : osm(o), obj(ob) {}
+  inline void operator()(const tag_t &tag)
+  {
+    osm->addTagRef(obj, tag);
+  }
+};
+
+class tag_pointer_match {
+  const char * const key;
+  const char * const value;
+public:
+  inline tag_pointer_match(const char *k, const char *v) : key(k), value(v) {}
+  inline bool operator()(const tag_t &tag) const
+  {
+    return tag.key_compare(key) && tag.value_compare(value);
+  }
+};
+
+template<typename T>
+struct tag_index_functor {
+  osm_t * const osm;
+  explicit inline tag_index_functor(osm_t *o) : osm(o) {}
+  inline void operator()(const std::pair<item_id_t, T *> &pair)
+  {
+    if(!pair.second->isDeleted() && !pair.second->tags.empty())
+      osm->addTagRefs(object_t(pair.second));
+  }
+};
+
+inline bool objectTypeIdCompare(const object_t &a, const object_t &b)
+{
+  if(a.type != b.type)
+    return a.type < b.type;
+  return a.get_id() < b.get_id();
+}
+
+} // namespace
+
+void osm_t::addTagRef(const object_t &obj, const tag_t &tag)
+{
+  // objects are stored by id as the index may outlive them
+  const object_t idref(static_cast<object_t::type_t>(obj.type | object_t::_REF_FLAG), obj.get_id());
+  std::vector<object_t> &objs = tagObjects[tag_key_t(tag.key, tag.value)];
+  // an object is usually only added once, or is the last one if its tags are modified
+  if(objs.empty() || objs.back() != idref) {
+    objs.push_back(idref);
+    tagValues[tag.key].insert(tag.value);
+    tagIndexEntries++;
+  }
+}
+
+void osm_t::addTagRefs(const object_t &obj)
+{
+  if(!tagIndexValid)
+    return;
+
+  static_cast<const base_object_t *>(obj)->tags.for_each(tag_ref_functor(this, obj));
+
+  // outdated entries of changed or deleted objects are only removed when
+  // their tag is searched for, so start over if there are too many of them
+  if(unlikely(tagIndexEntries > tagIndexLimit))
+    dropTagIndex();
+}
+
+void osm_t::buildTagIndex()
+{
+  tagIndexValid = true;
+  tagIndexLimit = std::numeric_limits<size_t>::max();
+
+  std::for_each(nodes.begin(), nodes.end(), tag_index_functor<node_t>(this));
+  std::for_each(ways.begin(), ways.end(), tag_index_functor<way_t>(this));
+  std::for_each(relations.begin(), relations.end(), tag_index_functor<relation_t>(this));
+
+  tagIndexLimit = 2 * tagIndexEntries + 1024;
+}
+
+void osm_t::dropTagIndex()
+{
+  printf("dropping tag index with %zu entries\n", tagIndexEntries);
+  tagIndexValid = false;
+  tagObjects.clear();
+  tagValues.clear();
+  tagIndexEntries = 0;
+}
+
+void osm_t::collectTagObjects(const tag_key_t &key, std::vector<object_t> &objs)
+{
+  const std::unordered_map<tag_key_t, std::vector<object_t>, tag_key_hash>::iterator mit = tagObjects.find(key);
+  if(mit == tagObjects.end())
+    return;
+
+  std::vector<object_t> &entries = mit->second;
+  const size_t oldSize = entries.size();
+  std::vector<object_t>::iterator keep = entries.begin();
+  const std::vector<object_t>::iterator itEnd = entries.end();
+  for(std::vector<object_t>::iterator it = entries.begin(); it != itEnd; it++) {
+    object_t obj;
+    switch(it->type) {
+    case object_t::NODE_ID:
+      obj = object_by_id<node_t>(it->get_id());
+      break;
+    case object_t::WAY_ID:
+      obj = object_by_id<way_t>(it->get_id());
+      break;
+    case object_t::RELATION_ID:
+      obj = object_by_id<relation_t>(it->get_id());
+      break;
+    default:
+      assert_unreachable();
+    }
+
+    // the object may have been removed, or the tags have changed
+    const base_object_t * const bobj = static_cast<base_object_t *>(obj);
+    if(bobj != nullptr && !bobj->isDeleted() && bobj->tags.contains(tag_pointer_match(key.first, key.second))) {
+      objs.push_back(obj);
+      *keep++ = *it;
+    }
+  }
+
+  // drop outdated entries and those that were added more than once
+  entries.erase(keep, itEnd);
+  std::sort(entries.begin(), entries.end(), objectTypeIdCompare);
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+  tagIndexEntries -= oldSize - entries.size();
+
+  if(entries.empty()) {
+    tagObjects.erase(mit);
+    const std::unordered_map<const char *, std::unordered_set<const char *> >::iterator vit = tagValues.find(key.first);
+    vit->second.erase(key.second);
+    if(vit->second.empty())
+      tagValues.erase(vit);
+  }
+}
+
+std::vector<object_t> osm_t::find_by_tag(const char *key, const char *value)
+{
+  std::vector<object_t> ret;
+
+  if(!tagIndexValid)
+    buildTagIndex();
+
+  // if the strings are not in the cache then no object uses them
+  const char *cacheKey = value_cache.getValue(key);
+  if(cacheKey == nullptr)
+    return ret;
+
+  if(value != nullptr) {
+    const char *cacheValue = value_cache.getValue(value);
+    if(cacheValue == nullptr)
+      return ret;
+    collectTagObjects(tag_key_t(cacheKey, cacheValue), ret);
+  } else {
+    const std::unordered_map<const char *, std::unordered_set<const char *> >::const_iterator vit = tagValues.find(cacheKey);
+    if(vit == tagValues.end())
+      return ret;
+    // collecting removes outdated values from the set
+    const std::vector<const char *> values(vit->second.begin(), vit->second.end());
+    const std::vector<const char *>::const_iterator itEnd = values.end();
+    for(std::vector<const char *>::const_iterator it = values.begin(); it != itEnd; it++)
+      collectTagObjects(tag_key_t(cacheKey, *it), ret);
+  }
+
+  std::sort(ret.begin(), ret.end(), objectTypeIdCompare);
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+
+  return ret;
 }
 
 const base_object_t *
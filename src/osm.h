@@ -7,6 +7,8 @@
 #pragma once
 
 #include "color.h"
+#include "grid_cells.h"
+#include "object_map.h"
 #include "pos.h"
 
 #include <algorithm>
@@ -20,6 +22,7 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <osm2go_annotations.h>
@@ -32,6 +35,9 @@
 
 #define OSM_FLAG_DIRTY    (1<<0)
 #define OSM_FLAG_DELETED  (1<<1)
+// only used for original objects: the node chain or the members have not
+// been copied as they are still the same as in the current object
+#define OSM_FLAG_SHARED   (1<<2)
 
 /* item_id_t needs to be signed as osm2go uses negative ids for items */
 /* not yet registered with the main osm database */
@@ -43,6 +49,7 @@ typedef int64_t item_id_t;
 class base_object_t;
 class map_t;
 class node_t;
+class object_pool;
 class osm_t;
 class relation_t;
 class way_t;
@@ -187,13 +194,117 @@ public:
   unsigned int version;
 };
 
+/**
+ * @brief a uniform grid over the local positions of nodes
+ *
+ * Finding the nodes close to a given position would otherwise require a scan
+ * over all nodes, which is done on every pointer motion while dragging.
+ */
+class node_grid_t : public grid_cells_t<32> {
+  std::unordered_map<uint64_t, std::vector<node_t *> > cells;
+
+  bool eraseFromCell(const std::unordered_map<uint64_t, std::vector<node_t *> >::iterator cit, const node_t *node);
+  /**
+   * @brief remove the node from the grid
+   * @param pos the position the node is expected at
+   *
+   * If the node is not found in the cell of pos all cells are searched.
+   */
+  bool erase(node_t *node, lpos_t pos);
+public:
+  void insert(node_t *node);
+  void erase(node_t *node);
+
+  /**
+   * @brief change the local position of the given node
+   * @param node the node to update
+   * @param pos the new local position
+   *
+   * node->lpos is updated. Nodes not known to the grid are only updated.
+   */
+  void move(node_t *node, lpos_t pos);
+
+  inline void clear()
+  { cells.clear(); }
+
+  /**
+   * @brief get all nodes that may be within radius of pos
+   * @param pos the center position
+   * @param radius the maximum distance in both directions
+   *
+   * The returned nodes are only candidates, the caller needs to do the exact
+   * distance check. They are sorted by id.
+   */
+  std::vector<node_t *> find(lpos_t pos, int radius) const;
+
+  /**
+   * @brief get all nodes inside the given rectangle
+   * @param min the upper left corner
+   * @param max the lower right corner, inclusive
+   *
+   * The returned nodes are in no particular order.
+   */
+  std::vector<node_t *> find(lpos_t min, lpos_t max) const;
+};
+
+/**
+ * @brief a uniform grid over the bounding boxes of ways
+ *
+ * This is used to find the ways intersecting the visible part of the map.
+ * Every way is stored in all cells its bounding box touches, ways spanning
+ * very many cells are kept in a separate list that is checked on every query.
+ *
+ * The ways are referenced directly, so their ids may change, e.g. when new
+ * ways are uploaded. Deleted ways are never stored, and a way has to be
+ * erased before it is freed.
+ */
+class way_grid_t : public grid_cells_t<256> {
+  struct entry_t {
+    inline entry_t(way_t *w, lpos_t mn, lpos_t mx) : way(w), min(mn), max(mx) {}
+    way_t *way;
+    lpos_t min, max;
+  };
+  typedef std::unordered_map<uint64_t, std::vector<entry_t> > CellMap;
+  CellMap cells;
+  std::vector<entry_t> large;   ///< ways covering more than MaxCells cells
+  std::unordered_map<const way_t *, std::pair<lpos_t, lpos_t> > boxes;
+
+  class find_functor;
+public:
+  enum { MaxCells = 64 };
+
+  /**
+   * @brief add the way or update its bounding box
+   *
+   * Deleted ways and ways without nodes are removed from the grid.
+   */
+  void update(way_t *way);
+  void erase(const way_t *way);
+
+  inline void clear()
+  { cells.clear(); large.clear(); boxes.clear(); }
+
+  inline size_t size() const
+  { return boxes.size(); }
+
+  /**
+   * @brief get all ways whose bounding box intersects the given rectangle
+   * @param min the upper left corner
+   * @param max the lower right corner, inclusive
+   *
+   * Every way is returned only once, in no particular order.
+   */
+  std::vector<way_t *> find(lpos_t min, lpos_t max) const;
+};
+
 class osm_t {
   friend class verify_osm_db;
 
-  template<typename T> inline std::map<item_id_t, T *> &objects();
-  template<typename T> inline const std::map<item_id_t, T *> &objects() const;
+  template<typename T> inline object_map<T> &objects();
+  template<typename T> inline const object_map<T> &objects() const;
   template<typename T> void attachObject(T *obj);
   template<typename T> const T *findOriginalById(item_id_t id) const;
+  template<typename T> const T *findSharedOriginalById(item_id_t id) const;
   template<typename T> inline std::unordered_map<item_id_t, const T *> &originalObjects();
   template<typename T> inline const std::unordered_map<item_id_t, const T *> &originalObjects() const;
 public:
@@ -242,14 +353,33 @@ public:
     }
   };
 
+  /**
+   * @brief the memory the objects of one osm_t are allocated from
+   *
+   * The pools are given up when the osm_t is destroyed, so the memory is
+   * returned once all objects allocated from them are freed.
+   */
+  struct pools_t {
+    pools_t();
+    ~pools_t();
+
+    object_pool * const nodes;
+    object_pool * const ways;
+    object_pool * const relations;
+
+    template<typename T> inline object_pool *get() const;
+  };
+
   explicit osm_t();
   ~osm_t();
 
+  const pools_t pools;
+
   bounds_t bounds;   // original bounds as they appear in the file
 
-  std::map<item_id_t, node_t *> nodes;
-  std::map<item_id_t, way_t *> ways;
-  std::map<item_id_t, relation_t *> relations;
+  object_map<node_t> nodes;
+  object_map<way_t> ways;
+  object_map<relation_t> relations;
   // of those objects that are modified in the above 3, this saves the original values
   struct {
     std::unordered_map<item_id_t, const node_t *> nodes;
@@ -258,6 +388,32 @@ public:
   } original;
   std::map<int, std::string> users;   ///< mapping of user id to username
   UploadPolicy uploadPolicy;
+  node_grid_t nodeGrid;   ///< spatial index of all entries in nodes
+
+  /**
+   * @brief move the node to a new position
+   * @param node the node to update
+   * @param pos the new position
+   *
+   * This updates the local position and the node grid. The node is not marked dirty.
+   */
+  void node_move(node_t *node, const pos_t &pos);
+
+  /**
+   * @brief find the nodes within the given distance of pos
+   * @param pos the center position
+   * @param radius the distance
+   *
+   * The returned nodes are sorted by id, deleted nodes are not returned.
+   */
+  std::vector<node_t *> nodes_near(lpos_t pos, float radius) const;
+
+  /**
+   * @brief find the nodes inside the given rectangle
+   *
+   * Deleted nodes are not returned, the order is unspecified.
+   */
+  std::vector<node_t *> nodes_in_area(lpos_t min, lpos_t max) const;
 
   template<typename T>
   T *object_by_id(item_id_t id) const;
@@ -313,17 +469,121 @@ public:
   void wipe(node_t *node);
   void wipe(way_t *way);
   void wipe(relation_t *relation);
+
+  /**
+   * @brief get all ways that reference the given node
+   * @returns the ways sorted by id
+   *
+   * This uses an index of the ways the node was seen in, which is verified
+   * against node_t::ways. Only if that does not match all ways are scanned.
+   */
+  way_chain_t node_ways(const node_t *node);
+
+  /**
+   * @brief record the given way in the index of all nodes it references
+   *
+   * This does not change the reference counts of the nodes.
+   *
+   * @see node_ways
+   */
+  void addNodeWayRefs(const way_t *way);
+  void addNodeWayRef(const node_t *node, const way_t *way);
+
+  /**
+   * @brief get all relations the given object is a member of
+   * @returns the relations sorted by id
+   *
+   * This uses an index of the relations the object was added to. Before it
+   * is used the size and last member of every relation are compared to the
+   * ones seen when the relation was indexed, relations that were changed
+   * without calling addMemberRef() or addMemberRefs() are indexed again.
+   * Replacing a member in the middle of the list is not detected this way.
+   */
+  std::vector<relation_t *> object_relations(const object_t &obj) const;
+
+  /**
+   * @brief record the given relation in the index of all its members
+   *
+   * @see object_relations
+   */
+  void addMemberRefs(const relation_t *relation);
+  void addMemberRef(const object_t &obj, const relation_t *relation);
+
+  /**
+   * @brief get all objects that have the given tag
+   * @param key the key of the tag
+   * @param value the value of the tag, nullptr to match any value
+   * @returns the objects sorted by type and id, deleted objects are not returned
+   *
+   * This uses an index of the tags the objects had when they were added, so
+   * all code changing the tags of objects already part of this object must
+   * call addTagRefs().
+   *
+   * The index is only created on the first call, so loading data does not
+   * have to look at the tags of every object. Entries of objects that were
+   * deleted or lost the tag are removed when the tag is searched for. If
+   * the index grows to more than twice its initial size it is dropped and
+   * created again on the next search.
+   */
+  std::vector<object_t> find_by_tag(const char *key, const char *value = nullptr);
+
+  /**
+   * @brief record the current tags of the given object in the tag index
+   *
+   * This does nothing as long as the index has not been created.
+   *
+   * @see find_by_tag
+   */
+  void addTagRefs(const object_t &obj);
+  void addTagRef(const object_t &obj, const tag_t &tag);
 private:
   template<typename T> void wipeImpl(T *obj);
 
+  struct member_key_hash {
+    size_t operator()(const object_t &obj) const noexcept;
+  };
+  struct member_key_equal {
+    bool operator()(const object_t &a, const object_t &b) const noexcept;
+  };
+  /// ids of the relations each object was added to, may contain outdated entries
+  mutable std::unordered_map<object_t, std::vector<item_id_t>, member_key_hash, member_key_equal> memberRelations;
+  /// number and last member of each relation when its members were last indexed
+  typedef std::pair<size_t, object_t> member_state_t;
+  mutable std::unordered_map<const relation_t *, member_state_t> memberStates;
+  void indexMemberRef(const object_t &obj, const relation_t *relation) const;
+  void indexMemberRefs(const relation_t *relation) const;
+  void syncMemberRefs() const;
+  void collectMemberRelations(const object_t &key, const object_t &obj, std::vector<relation_t *> &rels) const;
+
+  /// ids of the ways each node was added to, may contain outdated entries
+  std::unordered_map<const node_t *, std::vector<item_id_t> > nodeWays;
+
+  // key and value of a tag, both are pointers into the value cache
+  typedef std::pair<const char *, const char *> tag_key_t;
+  struct tag_key_hash {
+    size_t operator()(const tag_key_t &key) const noexcept;
+  };
+  /// ids of the objects each tag was added to, may contain outdated entries
+  std::unordered_map<tag_key_t, std::vector<object_t>, tag_key_hash> tagObjects;
+  /// all values that were seen for a given key
+  std::unordered_map<const char *, std::unordered_set<const char *> > tagValues;
+  bool tagIndexValid; ///< if tagObjects and tagValues are kept up to date
+  size_t tagIndexEntries; ///< number of entries in tagObjects
+  size_t tagIndexLimit;   ///< the index is dropped if it gets more entries than this
+  void buildTagIndex();
+  void dropTagIndex();
+  void collectTagObjects(const tag_key_t &key, std::vector<object_t> &objs);
+  /// hashes of the node chains or members the shared originals were created from
+  std::unordered_map<const base_object_t *, std::size_t> sharedRefsHashes;
+
 public:
   trstring unspecified_name(const object_t &obj) const;
 
 private:
   template<typename T, typename _Predicate ENABLE_IF_CONVERTIBLE(T *, base_object_t *)> inline
-  T *find_object(const std::map<item_id_t, T *> &map, _Predicate pred) const {
-    const typename std::map<item_id_t, T *>::const_iterator itEnd = map.end();
-    const typename std::map<item_id_t, T *>::const_iterator it = std::find_if(map.begin(), itEnd, pred);
+  T *find_object(const object_map<T> &map, _Predicate pred) const {
+    const typename object_map<T>::const_iterator itEnd = map.end();
+    const typename object_map<T>::const_iterator it = std::find_if(map.begin(), itEnd, pred);
     if(it != itEnd)
       return it->second;
     return nullptr;
@@ -336,11 +596,34 @@ private:
   template<typename T>
   void markDeleted(T &obj);
 
+  /**
+   * @brief mark the object dirty before only its tags are changed
+   *
+   * The original object shares the node chain or members with the current
+   * one until mark_dirty() is called before those are modified.
+   */
+  template<typename T>
+  void markTagsDirty(T *obj);
+  template<typename T>
+  void updateObjectTags(T *obj, const TagMap &ntags);
+  template<typename T>
+  bool isUnmodified(const T &obj, const T &orig) const;
+
+  inline void unshareOriginal(node_t *) {}
+  void unshareOriginal(way_t *way);
+  void unshareOriginal(relation_t *relation);
+
 public:
   template<typename T ENABLE_IF_CONVERTIBLE(T *, base_object_t *)>
   void mark_dirty(T *obj)
   {
-    // if already marked or never uploaded then don't store it in the original map
+    // the original may still share the parts that are about to be modified
+    if (obj->flags & OSM_FLAG_DIRTY) {
+      unshareOriginal(obj);
+      return;
+    }
+
+    // if deleted or never uploaded then don't store it in the original map
     if (obj->flags != 0 || obj->isNew())
       return;
 
@@ -368,6 +651,8 @@ public:
     if (it != orig.end()) {
       const T *oobj = it->second;
       orig.erase(it);
+      if (oobj->flags & OSM_FLAG_SHARED)
+        sharedRefsHashes.erase(oobj);
       delete oobj;
     }
   }
@@ -406,8 +691,8 @@ public:
    */
   template<typename _Predicate>
   way_t *find_only_way(_Predicate pred) const {
-    const typename std::map<item_id_t, way_t *>::const_iterator itEnd = ways.end();
-    const typename std::map<item_id_t, way_t *>::const_iterator it = std::find_if(ways.begin(), itEnd, pred);
+    const typename object_map<way_t>::const_iterator itEnd = ways.end();
+    const typename object_map<way_t>::const_iterator it = std::find_if(ways.begin(), itEnd, pred);
     if(it == itEnd)
       return nullptr;
     if (std::any_of(std::next(it), itEnd, pred))
@@ -459,7 +744,7 @@ public:
    */
   static void parse_tag(xmlNode* a_node, TagMap &tags);
 
-  void parse_relation_member(const xmlString &tp, const xmlString &refstr, const xmlString &role, std::vector<member_t> &members);
+  void parse_relation_member(const char *tp, const char *refstr, const char *role, std::vector<member_t> &members);
   void parse_relation_member(xmlNode *a_node, std::vector<member_t> &members);
 
   /**
@@ -471,6 +756,23 @@ public:
 
   static osm_t *parse(const std::string &path, const std::string &filename);
 
+  /**
+   * @brief load the data from a snapshot created by saveSnapshot()
+   * @param snapshot the snapshot file
+   * @param source the OSM file the snapshot was created from
+   * @returns the data or nullptr if the snapshot is missing, invalid, or does not match source
+   */
+  static osm_t *loadSnapshot(const std::string &snapshot, const std::string &source);
+
+  /**
+   * @brief write the data to a binary snapshot
+   * @param snapshot the snapshot file
+   * @param source the OSM file the data was parsed from
+   *
+   * This must be called before any changes are made to the data.
+   */
+  bool saveSnapshot(const std::string &snapshot, const std::string &source) const;
+
   /**
    * @brief check if a TagMap contains the other
    * @param sub the smaller map
@@ -548,6 +850,35 @@ public:
 
 xmlChar *osm_generate_xml_changeset(const std::string &comment, const std::string &src);
 
+/**
+ * @brief parser for OSM XML data that arrives in pieces
+ *
+ * The data, which may be gzip compressed, is scanned while it is passed in,
+ * e.g. from the thread doing a download. The objects are only created in
+ * finish(), which has to be called from the main thread.
+ */
+class osm_stream_parser {
+protected:
+  osm_stream_parser() {}
+public:
+  virtual ~osm_stream_parser() {}
+
+  static osm_stream_parser *create();
+
+  /**
+   * @brief process the next piece of data
+   *
+   * Once the data was found to be invalid everything is ignored.
+   */
+  virtual void feed(const char *data, size_t len) = 0;
+
+  /**
+   * @brief create the objects once all data has been passed in
+   * @returns the parsed data or nullptr if it was invalid
+   */
+  virtual osm_t *finish() = 0;
+};
+
 bool osm_t::wayIsHidden(const way_t *w) const
 {
   return hiddenWays.find(const_cast<way_t *>(w)) != hiddenWays.end();
@@ -563,18 +894,18 @@ bool osm_t::hasHiddenWays() const noexcept
   return !hiddenWays.empty();
 }
 
-template<> inline std::map<item_id_t, node_t *> &osm_t::objects()
+template<> inline object_map<node_t> &osm_t::objects()
 { return nodes; }
-template<> inline std::map<item_id_t, way_t *> &osm_t::objects()
+template<> inline object_map<way_t> &osm_t::objects()
 { return ways; }
-template<> inline std::map<item_id_t, relation_t *> &osm_t::objects()
+template<> inline object_map<relation_t> &osm_t::objects()
 { return relations; }
 
-template<> inline const std::map<item_id_t, node_t *> &osm_t::objects() const
+template<> inline const object_map<node_t> &osm_t::objects() const
 { return nodes; }
-template<> inline const std::map<item_id_t, way_t *> &osm_t::objects() const
+template<> inline const object_map<way_t> &osm_t::objects() const
 { return ways; }
-template<> inline const std::map<item_id_t, relation_t *> &osm_t::objects() const
+template<> inline const object_map<relation_t> &osm_t::objects() const
 { return relations; }
 
 template<> inline std::unordered_map<item_id_t, const node_t *> &osm_t::originalObjects<node_t>()
@@ -590,3 +921,10 @@ template<> inline const std::unordered_map<item_id_t, const way_t *> &osm_t::ori
 { return original.ways; }
 template<> inline const std::unordered_map<item_id_t, const relation_t *> &osm_t::originalObjects<relation_t>() const
 { return original.relations; }
+
+template<> inline object_pool *osm_t::pools_t::get<node_t>() const
+{ return nodes; }
+template<> inline object_pool *osm_t::pools_t::get<way_t>() const
+{ return ways; }
+template<> inline object_pool *osm_t::pools_t::get<relation_t>() const
+{ return relations; }
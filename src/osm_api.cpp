@@ -38,7 +38,24 @@
 #define COLOR_ERR  "red"
 #define COLOR_OK   "darkgreen"
 
-bool osm_download(osm2go_platform::Widget *parent, project_t *project)
+namespace {
+
+/**
+ * @brief scans the OSM data while it is downloaded
+ */
+class osm_download_sink : public net_io_sink {
+public:
+  osm_download_sink() : parser(osm_stream_parser::create()) {}
+
+  const std::unique_ptr<osm_stream_parser> parser;
+
+  void write(const char *data, size_t len) override
+  { parser->feed(data, len); }
+};
+
+} // namespace
+
+bool osm_download(osm2go_platform::Widget *parent, project_t *project, bool load)
 {
   printf("download osm for %s ...\n", project->name.c_str());
   settings_t::ref settings = settings_t::instance();
@@ -71,7 +88,8 @@ bool osm_download(osm2go_platform::Widget *parent, project_t *project)
   const std::string update = project->path + updatefn;
   unlinkat(project->dirfd, updatefn, 0);
 
-  if(unlikely(!net_io_download_file(parent, url, update, project->name, true)))
+  std::shared_ptr<osm_download_sink> sink(std::make_shared<osm_download_sink>());
+  if(unlikely(!net_io_download_file(parent, url, update, project->name, true, sink)))
     return false;
 
   if(unlikely(!std::filesystem::is_regular_file(update)))
@@ -118,6 +136,17 @@ bool osm_download(osm2go_platform::Widget *parent, project_t *project)
     rename(update.c_str(), fname.c_str());
   }
 
+  // The data was already scanned during the download. Hand it over if it is
+  // used immediately, otherwise keep it as snapshot, which is picked up
+  // instead of parsing the file again when the project is opened.
+  std::unique_ptr<osm_t> osm(sink->parser->finish());
+  if(unlikely(!osm))
+    printf("scanning the downloaded data failed, it will be parsed from the file\n");
+  else if(load)
+    project->downloaded.swap(osm);
+  else
+    osm->saveSnapshot(project->snapshot_file(), project->osm_file_path());
+
   return true;
 }
 
@@ -370,13 +399,31 @@ upload_object(osm_upload_context_t &context, base_object_t *obj, bool is_new)
 template<typename T>
 struct upload_objects {
   osm_upload_context_t &context;
-  std::map<item_id_t, T *> &map;
+  object_map<T> &map;
   const bool is_new;
-  upload_objects(osm_upload_context_t &co, std::map<item_id_t, T*> &m, bool n)
+  upload_objects(osm_upload_context_t &co, object_map<T> &m, bool n)
     : context(co), map(m), is_new(n) {}
   void operator()(T *obj);
 };
 
+// the lookup indexes in osm_t store the ids of the objects
+inline void reindex_object(osm_t::ref osm, node_t *node)
+{
+  osm->addTagRefs(object_t(node));
+}
+
+inline void reindex_object(osm_t::ref osm, way_t *way)
+{
+  osm->addNodeWayRefs(way);
+  osm->addTagRefs(object_t(way));
+}
+
+inline void reindex_object(osm_t::ref osm, relation_t *relation)
+{
+  osm->addMemberRefs(relation);
+  osm->addTagRefs(object_t(relation));
+}
+
 template<typename T>
 void upload_objects<T>::operator()(T *obj)
 {
@@ -386,12 +433,13 @@ void upload_objects<T>::operator()(T *obj)
   if(oldid != obj->id) {
     map.erase(oldid);
     map[obj->id] = obj;
+    reindex_object(context.osm, obj);
   }
 }
 
 template<typename T>
 static void upload_modified(osm_upload_context_t &co, trstring::native_type_arg header,
-                            std::map<item_id_t, T*> &m, const osm_t::dirty_t::counter<T> &counter)
+                            object_map<T> &m, const osm_t::dirty_t::counter<T> &counter)
 {
   if(counter.changed.empty() && counter.added.empty())
     return;
@@ -554,7 +602,7 @@ void osm_upload_context_t::upload(const osm_t::dirty_t &dirty, osm2go_platform::
   if(project->data_dirty) {
     append(_("Server data has been modified.\nDownloading updated osm data ...\n"));
 
-    bool reload_map = osm_download(parent, project.get());
+    bool reload_map = osm_download(parent, project.get(), true);
     if(likely(reload_map)) {
       append(_("Download successful!\nThe map will be reloaded.\n"));
       project->data_dirty = false;
@@ -14,7 +14,18 @@ struct appdata_t;
 struct project_t;
 class settings_t;
 
-bool osm_download(osm2go_platform::Widget *parent, project_t *project);
+/**
+ * @brief download the OSM data of the project area
+ * @param parent parent window for dialogs
+ * @param project the project to download the data for
+ * @param load if the data is loaded right afterwards
+ *
+ * The data is scanned while it arrives. If load is set the objects are
+ * kept in the project and taken by the next project_t::parse_osm(),
+ * otherwise they are only stored as snapshot for the next time the project
+ * is opened.
+ */
+bool osm_download(osm2go_platform::Widget *parent, project_t *project, bool load = false);
 void osm_upload(appdata_t &appdata);
 
 void osm_modified_info(const osm_t::dirty_t &context, osm2go_platform::Widget *parent);
@@ -329,22 +329,20 @@ enum RelationNameFlags {
 
 trstring osm_t::unspecified_name(const object_t &obj) const
 {
-  const std::map<item_id_t, relation_t *>::const_iterator itEnd = relations.end();
+  const std::vector<relation_t *> &rels = object_relations(obj);
+  const std::vector<relation_t *>::const_iterator itEnd = rels.end();
   const char *bmrole = nullptr; // the role "obj" has in the "best" relation
   int rtype = Uninitialized; // type of the best matching relation this object is member of
-  std::map<item_id_t, relation_t *>::const_iterator best = itEnd;
+  std::vector<relation_t *>::const_iterator best = itEnd;
   const char *bnameTag = nullptr;
 
-  for (std::map<item_id_t, relation_t *>::const_iterator it = relations.begin(); it != itEnd && rtype < 3; it++) {
-    // ignore all relations where obj is no member
-    const std::vector<member_t>::const_iterator mit = it->second->find_member_object(obj);
-    if (mit == it->second->members.end())
-      continue;
+  for (std::vector<relation_t *>::const_iterator it = rels.begin(); it != itEnd && rtype < 3; it++) {
+    const std::vector<member_t>::const_iterator mit = (*it)->find_member_object(obj);
 
     int nrtype = Member;
-    if(it->second->is_multipolygon())
+    if((*it)->is_multipolygon())
       nrtype |= IsMp;
-    const char *nameTag = it->second->descriptiveName();
+    const char *nameTag = (*it)->descriptiveName();
     if (nameTag != nullptr)
       nrtype |= HasName;
 
@@ -363,7 +361,7 @@ trstring osm_t::unspecified_name(const object_t &obj) const
   if (bnameTag != nullptr)
     bname = trstring("\"%1\"").arg(clean_underscores(bnameTag));
   else
-    bname = best->second->idName();
+    bname = (*best)->idName();
 
   std::string brole;
   if (bmrole != nullptr)
@@ -372,7 +370,7 @@ trstring osm_t::unspecified_name(const object_t &obj) const
   if(rtype & IsMp && !brole.empty())
     return trstring("%1: '%2' of multipolygon %3").arg(obj.type_string()).arg(brole).arg(bname);
 
-  const char *type = best->second->tags.get_value("type");
+  const char *type = (*best)->tags.get_value("type");
   std::string reltype;
   if (type != nullptr)
     reltype = clean_underscores(type);
@@ -12,6 +12,7 @@
 #include "osm_objects.h"
 
 #include "discarded.h"
+#include "object_pool.h"
 #include "osm_p.h"
 
 #include "osm2go_annotations.h"
@@ -19,6 +20,9 @@
 #include <osm2go_i18n.h>
 #include <osm2go_platform.h>
 
+#include <functional>
+#include <unordered_map>
+
 static_assert(sizeof(tag_list_t) == sizeof(tag_t *), "tag_list_t is not exactly as big as a pointer");
 
 const char *tag_t::mapToCache(const char *v)
@@ -51,28 +55,62 @@ bool tag_t::is_discardable(const char *key) noexcept
   return std::any_of(discardable_tags.begin(), discardable_tags.end(), find_discardable_key(key));
 }
 
+namespace {
+
+/**
+ * @brief all tag lists currently in use, indexed by their hash
+ *
+ * The keys and values of the tags are all backed by the value cache, so
+ * a list can be identified by the pointers alone.
+ */
+typedef std::unordered_multimap<size_t, tag_set_t *> tag_set_map;
+tag_set_map tag_sets;
+
+struct tag_hash_functor {
+  size_t &hash;
+  explicit inline tag_hash_functor(size_t &h) : hash(h) {}
+  inline void operator()(const tag_t &tag) const
+  {
+    hash = hash * 31 + std::hash<const char *>()(tag.key);
+    hash = hash * 31 + std::hash<const char *>()(tag.value);
+  }
+};
+
+inline bool tag_identical(const tag_t &a, const tag_t &b)
+{
+  return a.key == b.key && a.value == b.value;
+}
+
+} // namespace
+
 bool
 tag_list_t::operator==(const tag_list_t &other) const
 {
+  // identical lists are shared
+  if(contents == other.contents)
+    return true;
+
   if (other.empty())
     return empty();
 
   // now it is safe to dereference as the vector must exist and can't be empty
-  return operator==(*other.contents);
+  return operator==(other.contents->tags);
 }
 
 bool tag_list_t::empty() const noexcept
 {
-  return !contents || contents->empty();
+  return contents == nullptr;
 }
 
 bool tag_list_t::hasNonDiscardableTags() const noexcept
 {
   if(empty())
     return false;
+  if(!contents->discardables)
+    return true;
 
-  const std::vector<tag_t>::const_iterator itEnd = contents->end();
-  return std::any_of(std::cbegin(*contents), itEnd, tag_t::is_non_discardable);
+  const std::vector<tag_t>::const_iterator itEnd = contents->tags.end();
+  return std::any_of(std::cbegin(contents->tags), itEnd, tag_t::is_non_discardable);
 }
 
 static bool isRealTag(const tag_t &tag)
@@ -85,8 +123,8 @@ bool tag_list_t::hasRealTags() const noexcept
   if(empty())
     return false;
 
-  const std::vector<tag_t>::const_iterator itEnd = contents->end();
-  return std::any_of(std::cbegin(*contents), itEnd, isRealTag);
+  const std::vector<tag_t>::const_iterator itEnd = contents->tags.end();
+  return std::any_of(std::cbegin(contents->tags), itEnd, isRealTag);
 }
 
 const tag_t *tag_list_t::singleTag() const noexcept
@@ -94,8 +132,8 @@ const tag_t *tag_list_t::singleTag() const noexcept
   if(unlikely(empty()))
     return nullptr;
 
-  const std::vector<tag_t>::const_iterator itEnd = contents->end();
-  const std::vector<tag_t>::const_iterator it = std::find_if(std::cbegin(*contents), itEnd, isRealTag);
+  const std::vector<tag_t>::const_iterator itEnd = contents->tags.end();
+  const std::vector<tag_t>::const_iterator it = std::find_if(std::cbegin(contents->tags), itEnd, isRealTag);
   if(unlikely(it == itEnd))
     return nullptr;
   if (std::any_of(std::next(it), itEnd, isRealTag))
@@ -127,8 +165,8 @@ const char* tag_list_t::get_value(const char *key) const
   if(unlikely(cacheKey == nullptr))
     return nullptr;
 
-  const std::vector<tag_t>::const_iterator itEnd = contents->end();
-  const std::vector<tag_t>::const_iterator it = std::find_if(std::cbegin(*contents),
+  const std::vector<tag_t>::const_iterator itEnd = contents->tags.end();
+  const std::vector<tag_t>::const_iterator it = std::find_if(std::cbegin(contents->tags),
                                                              itEnd, key_match_functor(cacheKey));
   if(it != itEnd)
     return it->value;
@@ -136,6 +174,26 @@ const char* tag_list_t::get_value(const char *key) const
   return nullptr;
 }
 
+void tag_list_t::clear()
+{
+  if(contents == nullptr)
+    return;
+
+  assert(contents->refcount > 0);
+  if(--contents->refcount == 0) {
+    std::pair<tag_set_map::iterator, tag_set_map::iterator> its = tag_sets.equal_range(contents->hash);
+    for(; its.first != its.second; its.first++) {
+      if(its.first->second == contents) {
+        tag_sets.erase(its.first);
+        break;
+      }
+    }
+    delete contents;
+  }
+
+  contents = nullptr;
+}
+
 #if __cplusplus < 201103L
 // workaround for the fact that the default constructor is unavailable
 template<>
@@ -149,32 +207,58 @@ inline void shrink_to_fit(std::vector<tag_t> &v)
   tmp.swap(v);
 }
 
-void tag_list_t::replace(std::vector<tag_t> &ntags)
+void tag_list_t::intern(std::vector<tag_t> &ntags)
 #else
-void tag_list_t::replace(std::vector<tag_t> &&ntags)
+void tag_list_t::intern(std::vector<tag_t> &&ntags)
 #endif
 {
-  if(ntags.empty()) {
-    clear();
-    return;
+  assert(contents == nullptr);
+  assert(!ntags.empty());
+
+  size_t hash = ntags.size();
+  std::for_each(ntags.begin(), ntags.end(), tag_hash_functor(hash));
+
+  std::pair<tag_set_map::iterator, tag_set_map::iterator> its = tag_sets.equal_range(hash);
+  for(; its.first != its.second; its.first++) {
+    tag_set_t * const set = its.first->second;
+    if(set->tags.size() == ntags.size() &&
+       std::equal(ntags.begin(), ntags.end(), set->tags.begin(), tag_identical)) {
+      set->refcount++;
+      contents = set;
+      return;
+    }
   }
 
-  if(!contents) {
+  tag_set_t *set = new tag_set_t();
 #if __cplusplus >= 201103L
-    contents.reset(new std::vector<tag_t>(std::move(ntags)));
+  set->tags = std::move(ntags);
 #else
-    contents.reset(new std::vector<tag_t>(ntags.size(), tag_t::uncached(nullptr, nullptr)));
-    contents->swap(ntags);
+  set->tags.swap(ntags);
 #endif
-  } else {
-#if __cplusplus >= 201103L
-    *contents = std::move(ntags);
+  shrink_to_fit(set->tags);
+  set->hash = hash;
+  set->refcount = 1;
+  set->discardables = std::any_of(set->tags.begin(), set->tags.end(), tag_t::isDiscardable);
+  tag_sets.insert(tag_set_map::value_type(hash, set));
+  contents = set;
+}
+
+#if __cplusplus < 201103L
+void tag_list_t::replace(std::vector<tag_t> &ntags)
 #else
-    contents->swap(ntags);
+void tag_list_t::replace(std::vector<tag_t> &&ntags)
 #endif
-  }
+{
+  clear();
 
-  shrink_to_fit(*contents);
+  if(ntags.empty())
+    return;
+
+#if __cplusplus >= 201103L
+  intern(std::move(ntags));
+#else
+  intern(ntags);
+#endif
 }
 
 namespace {
@@ -195,13 +279,15 @@ public:
 
 void tag_list_t::replace(const osm_t::TagMap &ntags)
 {
-  clear();
-  if(ntags.empty())
-    return;
+  std::vector<tag_t> tags;
+  tags.reserve(ntags.size());
+  std::for_each(ntags.begin(), ntags.end(), tag_fill_functor(tags));
 
-  contents.reset(new std::vector<tag_t>());
-  contents->reserve(ntags.size());
-  std::for_each(ntags.begin(), ntags.end(), tag_fill_functor(*contents));
+#if __cplusplus >= 201103L
+  replace(std::move(tags));
+#else
+  replace(tags);
+#endif
 }
 
 base_object_t::base_object_t(const base_attributes &attr) noexcept
@@ -237,6 +323,101 @@ void base_object_t::osmchange_delete(xmlNodePtr parent_node, const char *changes
   xmlNewProp(obj_node, BAD_CAST "changeset", BAD_CAST changeset);
 }
 
+namespace {
+
+/**
+ * @brief the pool for objects not created by an osm_t, it is never freed
+ */
+template<typename T>
+object_pool *default_pool()
+{
+  static object_pool * const pool = object_pool::create(sizeof(T));
+  return pool;
+}
+
+// derived classes have a different size and are not served by the pools
+template<typename T>
+void *pool_allocate(std::size_t size)
+{
+  if(unlikely(size != sizeof(T)))
+    return ::operator new(size);
+  return default_pool<T>()->allocate();
+}
+
+template<typename T>
+void pool_release(void *p, std::size_t size)
+{
+  if(unlikely(size != sizeof(T)))
+    ::operator delete(p);
+  else
+    object_pool::release(p);
+}
+
+} // namespace
+
+void *node_t::operator new(std::size_t size)
+{
+  return pool_allocate<node_t>(size);
+}
+
+void *node_t::operator new(std::size_t size, object_pool *pool)
+{
+  assert_cmpnum(size, sizeof(node_t));
+  return pool->allocate();
+}
+
+void node_t::operator delete(void *p, std::size_t size)
+{
+  pool_release<node_t>(p, size);
+}
+
+void node_t::operator delete(void *p, object_pool *)
+{
+  object_pool::release(p);
+}
+
+void *way_t::operator new(std::size_t size)
+{
+  return pool_allocate<way_t>(size);
+}
+
+void *way_t::operator new(std::size_t size, object_pool *pool)
+{
+  assert_cmpnum(size, sizeof(way_t));
+  return pool->allocate();
+}
+
+void way_t::operator delete(void *p, std::size_t size)
+{
+  pool_release<way_t>(p, size);
+}
+
+void way_t::operator delete(void *p, object_pool *)
+{
+  object_pool::release(p);
+}
+
+void *relation_t::operator new(std::size_t size)
+{
+  return pool_allocate<relation_t>(size);
+}
+
+void *relation_t::operator new(std::size_t size, object_pool *pool)
+{
+  assert_cmpnum(size, sizeof(relation_t));
+  return pool->allocate();
+}
+
+void relation_t::operator delete(void *p, std::size_t size)
+{
+  pool_release<relation_t>(p, size);
+}
+
+void relation_t::operator delete(void *p, object_pool *)
+{
+  object_pool::release(p);
+}
+
 bool way_t::operator==(const way_t &other) const
 {
   if (!visible_item_t::operator==(other))
@@ -294,6 +475,7 @@ node_t *way_t::insert_node(osm_t::ref osm, unsigned int position, lpos_t coords)
 
   /* remember that this node is contained in one way */
   node->ways = 1;
+  osm->addNodeWayRef(node, this);
 
   return node;
 }
@@ -312,6 +494,7 @@ bool way_t::merge(way_t *other, osm_t *osm, map_t *map, const std::vector<relati
   osm->mark_dirty(other);
 
   const bool collision = tags.merge(other->tags);
+  osm->addTagRefs(object_t(this));
 
   /* make enough room for all nodes */
   node_chain.reserve(node_chain.size() + other->node_chain.size() - 1);
@@ -342,6 +525,8 @@ bool way_t::merge(way_t *other, osm_t *osm, map_t *map, const std::vector<relati
   std::for_each(rels.begin(), rels.end(),
                 relation_object_replacer(osm, object_t(other), object_t(this)));
 
+  osm->addNodeWayRefs(this);
+
   /* erase and free other way (now only containing the overlapping node anymore) */
   osm->way_delete(other, map);
 
@@ -419,11 +604,13 @@ void relation_t::updateMembers(std::vector<member_t> &newMembers, osm_t::ref osm
     // members have changed and it wasn't dirty before, so it must be dirty now
     osm->mark_dirty(this);
     members.swap(newMembers);
+    osm->addMemberRefs(this);
     return;
   }
 
   // the object is already marked dirty, so we can modify at will
   members.swap(newMembers);
+  osm->addMemberRefs(this);
 
   // everything back to normal
   if (*this == *orig)
@@ -78,9 +78,28 @@ public:
   }
 };
 
+/**
+ * @brief an immutable list of tags
+ *
+ * Many objects have identical tags, e.g. thousands of buildings only have
+ * building=yes. Every distinct list is stored only once and shared by all
+ * objects carrying it, see tag_list_t.
+ */
+struct tag_set_t {
+  std::vector<tag_t> tags;
+  size_t hash;
+  unsigned int refcount;
+  bool discardables;     ///< if any of the tags is discardable
+};
+
 class tag_list_t {
 public:
   inline tag_list_t() noexcept : contents(nullptr) {}
+  inline ~tag_list_t()
+  { clear(); }
+
+  tag_list_t(const tag_list_t &) O2G_DELETED_FUNCTION;
+  tag_list_t &operator=(const tag_list_t &) O2G_DELETED_FUNCTION;
 
   bool operator==(const tag_list_t &other) const;
   inline bool operator!=(const tag_list_t &other) const
@@ -114,31 +133,46 @@ public:
   bool contains(_Predicate pred) const {
     if(!contents)
       return false;
-    const std::vector<tag_t>::const_iterator itEnd = contents->end();
-    return std::any_of(std::cbegin(*contents), itEnd, pred);
+    const std::vector<tag_t>::const_iterator itEnd = contents->tags.end();
+    return std::any_of(std::cbegin(contents->tags), itEnd, pred);
   }
 
   template<typename _Predicate>
   void for_each(_Predicate pred) const {
-    if(contents)
-      std::for_each(contents->begin(), contents->end(), pred);
+    if(contents) {
+      // the contents may be shared, so they must not be modified
+      const std::vector<tag_t> &tags = contents->tags;
+      std::for_each(tags.begin(), tags.end(), pred);
+    }
   }
 
   /**
-   * @brief remove all elements and free their memory
+   * @brief remove all elements
+   *
+   * The shared list is freed if this was the last user.
    */
-  inline void clear()
-  {
-    contents.reset();
-  }
+  void clear();
 
   /**
    * @brief copy the contained tags
    */
   osm_t::TagMap asMap() const;
 
+  /**
+   * @brief take the non-discardable tags from other
+   *
+   * This list must be empty before. If other has no discardable tags both
+   * lists share the same contents afterwards.
+   */
   void copy(const tag_list_t &other);
 
+  /**
+   * @brief use the same contents as other, including discardable tags
+   *
+   * This list must be empty before.
+   */
+  void share(const tag_list_t &other);
+
   inline void swap(tag_list_t &other)
   { std::swap(contents, other.contents); }
 
@@ -181,9 +215,19 @@ public:
   bool hasTagCollisions() const;
 
 private:
-  // do not directly use a vector here as many objects do not have
-  // any tags and that would waste too much memory
-  std::unique_ptr<std::vector<tag_t> > contents;
+  /**
+   * @brief set the contents to the shared list equal to ntags
+   *
+   * ntags must not be empty, the previous contents must already be released.
+   */
+#if __cplusplus < 201103L
+  void intern(std::vector<tag_t> &ntags);
+#else
+  void intern(std::vector<tag_t> &&ntags);
+#endif
+
+  // nullptr if there are no tags, as many objects do not have any
+  tag_set_t *contents;
 };
 
 class base_object_t : public base_attributes {
@@ -265,11 +309,18 @@ public:
 
 class node_t : public visible_item_t {
 public:
-  node_t(const base_attributes &attr, const lpos_t lp = lpos_t(), const pos_t &p = pos_t()) noexcept
+  node_t(const base_attributes &attr, const lpos_t lp = lpos_t(0, 0), const pos_fixed_t p = pos_fixed_t()) noexcept
     : visible_item_t(attr) , ways(0) , pos(p) , lpos(lp) {}
 
   virtual ~node_t() {}
 
+  // objects are allocated from a slab pool, see object_pool, the one of the
+  // osm_t creating them or a shared one for all other objects
+  static void *operator new(std::size_t size);
+  static void *operator new(std::size_t size, object_pool *pool);
+  static void operator delete(void *p, std::size_t size);
+  static void operator delete(void *p, object_pool *pool);
+
   inline bool operator==(const node_t &other) const
   {
     // the other members are only about visual representation and can be ignored
@@ -280,8 +331,8 @@ public:
   { return !operator==(other); }
 
   unsigned int ways;
-  pos_t pos;
-  lpos_t lpos;
+  pos_fixed_t pos;
+  lpos_t lpos;  ///< change with osm_t::node_move() for attached nodes, the node grid is sorted by it
 
   const char *apiString() const noexcept override {
     return api_string();
@@ -307,6 +358,11 @@ public:
     memset(&draw, 0, sizeof(draw));
   }
   virtual ~way_t() {}
+
+  static void *operator new(std::size_t size);
+  static void *operator new(std::size_t size, object_pool *pool);
+  static void operator delete(void *p, std::size_t size);
+  static void operator delete(void *p, object_pool *pool);
   bool operator==(const way_t &other) const;
   inline bool operator!=(const way_t &other) const
   { return !operator==(other); }
@@ -424,6 +480,11 @@ public:
   explicit relation_t(const base_attributes &attr = base_attributes())
     : base_object_t(attr) {}
   virtual ~relation_t() {}
+
+  static void *operator new(std::size_t size);
+  static void *operator new(std::size_t size, object_pool *pool);
+  static void operator delete(void *p, std::size_t size);
+  static void operator delete(void *p, object_pool *pool);
   inline bool operator==(const relation_t &other) const
   {
     return base_object_t::operator==(other) &&
@@ -13,20 +13,31 @@
 
 #include "osm_objects.h"
 #include "misc.h"
+#include "net_io.h"
 #include "pos.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cinttypes>
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <string>
 #include <strings.h>
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#endif
 
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include <libxml/xmlreader.h>
+#include <zlib.h>
 
 #include "osm2go_annotations.h"
 #include <osm2go_cpp.h>
@@ -94,6 +105,11 @@ osm_user_insert(std::map<int, std::string> &users, const char *name, int uid)
 time_t __attribute__((nonnull(1)))
 convert_iso8601(const char *str)
 {
+  time_t ret;
+  if(likely(parse_iso8601_utc(str, ret)))
+    return ret;
+
+  // time zone offsets or fractions of seconds, not used by the API
   struct tm ctime;
   memset(&ctime, 0, sizeof(ctime));
   strptime(str, "%FT%T%z", &ctime);
@@ -103,6 +119,29 @@ convert_iso8601(const char *str)
   return timegm(&ctime) - gmtoff;
 }
 
+/**
+ * @brief parse the id and version of an object
+ * @param id the value of the id attribute
+ * @param version the value of the version attribute, nullptr if it is missing
+ * @param attrs the values are stored here
+ * @returns if both values are valid
+ *
+ * Only new objects have no version, all others can't be uploaded without it.
+ */
+bool
+parse_id_version(const char *id, const char *version, base_attributes &attrs)
+{
+  if(unlikely(id == nullptr || !parse_int64(id, attrs.id)))
+    return false;
+
+  int64_t v = 0;
+  if(version != nullptr && unlikely(!parse_int64(version, v) || v < 0 || v > UINT_MAX))
+    return false;
+  attrs.version = v;
+
+  return (attrs.version == 0) == (attrs.id <= ID_ILLEGAL);
+}
+
 } // namespace
 
 /* -------------------- tag handling ----------------------- */
@@ -132,22 +171,30 @@ void osm_t::parse_tag(xmlNode *a_node, TagMap &tags)
 
 /* ------------------- way handling ------------------- */
 
-static node_t *parse_node_ref(const xmlString &prop, const osm_t *osm)
+static node_t *node_by_ref(item_id_t id, const osm_t *osm)
 {
-  node_t *node = nullptr;
+  /* search matching node */
+  node_t *node = osm->object_by_id<node_t>(id);
+  if(unlikely(node == nullptr))
+    printf("Node id " ITEM_ID_FORMAT " not found\n", id);
+  else
+    node->ways++;
 
-  if(likely(!prop.empty())) {
-    item_id_t id = strtoll(prop, nullptr, 10);
+  return node;
+}
 
-    /* search matching node */
-    node = osm->object_by_id<node_t>(id);
-    if(unlikely(node == nullptr))
-      printf("Node id " ITEM_ID_FORMAT " not found\n", id);
-    else
-      node->ways++;
+static node_t *parse_node_ref(const char *prop, const osm_t *osm)
+{
+  if(unlikely(prop == nullptr || *prop == '\0'))
+    return nullptr;
+
+  item_id_t id;
+  if(unlikely(!parse_int64(prop, id))) {
+    printf("Illegal ref '%s' for way node\n", prop);
+    return nullptr;
   }
 
-  return node;
+  return node_by_ref(id, osm);
 }
 
 node_t *osm_t::parse_way_nd(xmlNode *a_node) const {
@@ -158,13 +205,13 @@ node_t *osm_t::parse_way_nd(xmlNode *a_node) const {
 
 /* ------------------- relation handling ------------------- */
 
-void osm_t::parse_relation_member(const xmlString &tp, const xmlString &refstr, const xmlString &role, std::vector<member_t> &members)
+void osm_t::parse_relation_member(const char *tp, const char *refstr, const char *role, std::vector<member_t> &members)
 {
-  if(unlikely(tp.empty())) {
+  if(unlikely(tp == nullptr || *tp == '\0')) {
     printf("missing type for relation member\n");
     return;
   }
-  if(unlikely(refstr.empty())) {
+  if(unlikely(refstr == nullptr || *refstr == '\0')) {
     printf("missing ref for relation member\n");
     return;
   }
@@ -177,14 +224,14 @@ void osm_t::parse_relation_member(const xmlString &tp, const xmlString &refstr,
   else if(likely(strcmp(tp, relation_t::api_string()) == 0))
     type = object_t::RELATION;
   else {
-    printf("Unable to store illegal type '%s'\n", tp.get());
+    printf("Unable to store illegal type '%s'\n", tp);
     return;
   }
 
   char *endp;
   item_id_t id = strtoll(refstr, &endp, 10);
   if(unlikely(*endp != '\0')) {
-    printf("Illegal ref '%s' for relation member\n", refstr.get());
+    printf("Illegal ref '%s' for relation member\n", refstr);
     return;
   }
 
@@ -212,7 +259,7 @@ void osm_t::parse_relation_member(const xmlString &tp, const xmlString &refstr,
   if(static_cast<base_object_t *>(obj) == nullptr)
     obj = object_t(static_cast<object_t::type_t>(type | object_t::_REF_FLAG), id);
 
-  const char *rstr = role.empty() ? nullptr : static_cast<const char *>(role);
+  const char *rstr = (role == nullptr || *role == '\0') ? nullptr : role;
   members.push_back(member_t(obj, rstr));
 }
 
@@ -257,13 +304,12 @@ skip_element(xmlTextReaderPtr reader)
   }
 }
 
-/* parse bounds */
+/* calculate the screen coordinates of the bounds */
 std::optional<bounds_t>
-process_bounds(xmlTextReaderPtr reader)
+make_bounds(const pos_area &area)
 {
   bounds_t bounds;
-  if(unlikely(!bounds.init(pos_area(pos_t::fromXmlProperties(reader, "minlat", "minlon"),
-                                    pos_t::fromXmlProperties(reader, "maxlat", "maxlon"))))) {
+  if(unlikely(!bounds.init(area))) {
     fprintf(stderr, "Invalid coordinate in bounds (%f/%f/%f/%f)\n",
             bounds.ll.min.lat, bounds.ll.min.lon,
             bounds.ll.max.lat, bounds.ll.max.lon);
@@ -271,9 +317,6 @@ process_bounds(xmlTextReaderPtr reader)
     return std::optional<bounds_t>();
   }
 
-  /* skip everything below */
-  skip_element(reader);
-
   bounds.min = bounds.ll.min.toLpos();
   bounds.min.x -= bounds.center.x;
   bounds.min.y -= bounds.center.y;
@@ -289,6 +332,20 @@ process_bounds(xmlTextReaderPtr reader)
   return bounds;
 }
 
+/* parse bounds */
+std::optional<bounds_t>
+process_bounds(xmlTextReaderPtr reader)
+{
+  std::optional<bounds_t> bounds = make_bounds(pos_area(pos_t::fromXmlProperties(reader, "minlat", "minlon"),
+                                                        pos_t::fromXmlProperties(reader, "maxlat", "maxlon")));
+
+  /* skip everything below */
+  if(likely(bounds))
+    skip_element(reader);
+
+  return bounds;
+}
+
 void
 process_tag(xmlTextReaderPtr reader, std::vector<tag_t> &tags)
 {
@@ -301,18 +358,24 @@ process_tag(xmlTextReaderPtr reader, std::vector<tag_t> &tags)
     printf("incomplete tag key/value %s/%s\n", k.get(), v.get());
 }
 
-base_attributes
-process_base_attributes(xmlTextReaderPtr reader, osm_t::ref osm)
+/**
+ * @brief parse the attributes common to all objects
+ * @returns if the id and version are valid
+ *
+ * If the attributes are invalid the element is skipped.
+ */
+bool
+process_base_attributes(xmlTextReaderPtr reader, osm_t::ref osm, base_attributes &ret)
 {
-  base_attributes ret;
   xmlString prop(xmlTextReaderGetAttribute(reader, BAD_CAST "id"));
-  if(likely(prop))
-    ret.id = strtoll(prop, nullptr, 10);
-
   /* new in api 0.6: */
-  prop.reset(xmlTextReaderGetAttribute(reader, BAD_CAST "version"));
-  if(likely(prop))
-    ret.version = strtoul(prop, nullptr, 10);
+  xmlString version(xmlTextReaderGetAttribute(reader, BAD_CAST "version"));
+  if(unlikely(!parse_id_version(prop, version, ret))) {
+    printf("WARNING: skipping %s with invalid id '%s' or version '%s'\n",
+           reinterpret_cast<const char *>(xmlTextReaderConstName(reader)), prop.get(), version.get());
+    skip_element(reader);
+    return false;
+  }
 
   prop.reset(xmlTextReaderGetAttribute(reader, BAD_CAST "user"));
   if(likely(prop)) {
@@ -333,7 +396,7 @@ process_base_attributes(xmlTextReaderPtr reader, osm_t::ref osm)
   if(likely(prop))
     ret.time = convert_iso8601(prop);
 
-  return ret;
+  return true;
 }
 
 void
@@ -341,7 +404,9 @@ process_node(xmlTextReaderPtr reader, osm_t::ref osm)
 {
   const pos_t pos = pos_t::fromXmlProperties(reader);
 
-  base_attributes ba = process_base_attributes(reader, osm);
+  base_attributes ba;
+  if(unlikely(!process_base_attributes(reader, osm, ba)))
+    return;
 
   node_t *node = osm->node_new(pos, ba);
   assert_cmpnum(node->flags, 0);
@@ -385,9 +450,11 @@ process_nd(xmlTextReaderPtr reader, osm_t::ref osm)
 void
 process_way(xmlTextReaderPtr reader, osm_t::ref osm)
 {
-  base_attributes ba = process_base_attributes(reader, osm);
+  base_attributes ba;
+  if(unlikely(!process_base_attributes(reader, osm, ba)))
+    return;
 
-  way_t *way = new way_t(ba);
+  way_t *way = new(osm->pools.ways) way_t(ba);
   assert_cmpnum(way->flags, 0);
 
   osm->insert(way);
@@ -410,8 +477,10 @@ process_way(xmlTextReaderPtr reader, osm_t::ref osm)
       const char *subname = reinterpret_cast<const char *>(xmlTextReaderConstName(reader));
       if(strcmp(subname, "nd") == 0) {
         node_t *n = process_nd(reader, osm);
-        if(likely(n != nullptr))
+        if(likely(n != nullptr)) {
           way->node_chain.push_back(n);
+          osm->addNodeWayRef(n, way);
+        }
       } else if(likely(strcmp(subname, "tag") == 0)) {
         process_tag(reader, tags);
       }
@@ -436,9 +505,11 @@ process_member(xmlTextReaderPtr reader, osm_t::ref osm, std::vector<member_t> &m
 void
 process_relation(xmlTextReaderPtr reader, osm_t::ref osm)
 {
-  base_attributes ba = process_base_attributes(reader, osm);
+  base_attributes ba;
+  if(unlikely(!process_base_attributes(reader, osm, ba)))
+    return;
 
-  relation_t *relation = new relation_t(ba);
+  relation_t *relation = new(osm->pools.relations) relation_t(ba);
   assert_cmpnum(relation->flags, 0);
 
   osm->insert(relation);
@@ -471,6 +542,7 @@ process_relation(xmlTextReaderPtr reader, osm_t::ref osm)
     ret = xmlTextReaderRead(reader);
   }
   relation->tags.replace(std::move(tags));
+  osm->addMemberRefs(relation);
 }
 
 osm_t::UploadPolicy
@@ -564,52 +636,2127 @@ process_osm(xmlTextReaderPtr reader)
   return nullptr;
 }
 
-struct relation_ref_functor {
-  osm_t::ref osm;
-  explicit inline relation_ref_functor(osm_t::ref o) : osm(o) {}
-  void operator()(std::pair<item_id_t, relation_t *> p) {
-    std::for_each(p.second->members.begin(), p.second->members.end(), *this);
+/* ----------------------- memory mapped scanner ------------------- */
+
+/**
+ * @brief decode the raw value of an attribute
+ * @param s the start of the value inside the buffer
+ * @param len the length of the raw value
+ * @param out where to store the decoded value
+ * @returns if the value was valid
+ *
+ * This resolves the predefined and numeric character references and
+ * normalizes whitespace the same way libxml does.
+ */
+bool
+decode_attribute(const char *s, size_t len, std::string &out)
+{
+  out.clear();
+  const char * const e = s + len;
+  const char *run = s;
+
+  for(; s < e; s++) {
+    switch(*s) {
+    case '&':
+    case '<':
+    case '\t':
+    case '\n':
+    case '\r':
+      break;
+    default:
+      continue;
+    }
+
+    out.append(run, s - run);
+    run = s + 1;
+
+    switch(*s) {
+    case '<':
+      return false;
+    case '\r':
+      // a line break is normalized to a single newline before it becomes a space
+      if(s + 1 < e && s[1] == '\n')
+        continue;
+      out += ' ';
+      break;
+    case '&': {
+      const char *semi = static_cast<const char *>(memchr(s, ';', e - s));
+      if(unlikely(semi == nullptr))
+        return false;
+      const std::string entity(s + 1, semi);
+      if(entity == "lt")
+        out += '<';
+      else if(entity == "gt")
+        out += '>';
+      else if(entity == "amp")
+        out += '&';
+      else if(entity == "quot")
+        out += '"';
+      else if(entity == "apos")
+        out += '\'';
+      else if(likely(entity.size() > 1 && entity[0] == '#')) {
+        char *endp;
+        const unsigned long cp = entity[1] == 'x' ?
+                                 strtoul(entity.c_str() + 2, &endp, 16) :
+                                 strtoul(entity.c_str() + 1, &endp, 10);
+        if(unlikely(*endp != '\0' || cp == 0 || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)))
+          return false;
+        // encode as UTF-8
+        if(cp < 0x80) {
+          out += static_cast<char>(cp);
+        } else if(cp < 0x800) {
+          out += static_cast<char>(0xc0 | (cp >> 6));
+          out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if(cp < 0x10000) {
+          out += static_cast<char>(0xe0 | (cp >> 12));
+          out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+          out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+          out += static_cast<char>(0xf0 | (cp >> 18));
+          out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+          out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+          out += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+      } else {
+        return false;
+      }
+      s = semi;
+      run = s + 1;
+      break;
+    }
+    default:
+      out += ' ';
+      break;
+    }
   }
-  void operator()(member_t &m) {
-    if(m.object.type != object_t::RELATION_ID)
-      return;
-    relation_t *r = osm->object_by_id<relation_t>(m.object.get_id());
-    if(r == nullptr)
-      return;
-    m.object = r;
+
+  out.append(run, e - run);
+  return true;
+}
+
+inline bool
+is_xml_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief a tokenizer for the subset of XML used in OSM API 0.6 data
+ *
+ * The libxml reader allocates a copy of every attribute that is requested.
+ * This reads the numeric attributes in place from the buffer and decodes the
+ * string attributes into reused buffers.
+ *
+ * If anything is found that is not understood the token is TOKEN_ERROR and
+ * the libxml parser should be used instead.
+ */
+class xml_tokenizer {
+public:
+  inline xml_tokenizer(const char *data, const char *dataEnd)
+    : cursor(data), end(dataEnd), name(nullptr), nameLen(0), emptyElement(false) {}
+  xml_tokenizer() O2G_DELETED_FUNCTION;
+  xml_tokenizer(const xml_tokenizer &) O2G_DELETED_FUNCTION;
+  xml_tokenizer &operator=(const xml_tokenizer &) O2G_DELETED_FUNCTION;
+#if __cplusplus >= 201103L
+  xml_tokenizer(xml_tokenizer &&) = delete;
+  xml_tokenizer &operator=(xml_tokenizer &&) = delete;
+  ~xml_tokenizer() = default;
+#endif
+
+  enum token_t {
+    TOKEN_ERROR,
+    TOKEN_START,
+    TOKEN_END,
+    TOKEN_EOF ///< only text, comments, or processing instructions until the end
+  };
+
+  const char *cursor;
+  const char * const end;
+  const char *name; ///< the name of the current element
+  size_t nameLen;
+  bool emptyElement; ///< if the current start element has no children
+
+  token_t next();
+  bool skipElement();
+  bool isName(const char *n) const;
+
+  const char *rawValue(const char *n) const;
+  const char *value(const char *n, std::string &buf) const;
+  pos_float_t coordinate(const char *n) const;
+  int uid() const;
+
+private:
+  struct attribute_t {
+    const char *name;
+    size_t nameLen;
+    const char *value; ///< the raw value, terminated by the quote character
+    size_t valueLen;
+  };
+
+  std::vector<attribute_t> attributes; ///< the attributes of the current start element
+
+  bool skipSpecial();
+  const attribute_t *attribute(const char *n) const;
+};
+
+bool
+xml_tokenizer::isName(const char *n) const
+{
+  return strncmp(name, n, nameLen) == 0 && n[nameLen] == '\0';
+}
+
+const xml_tokenizer::attribute_t *
+xml_tokenizer::attribute(const char *n) const
+{
+  const size_t len = strlen(n);
+  const std::vector<attribute_t>::const_iterator itEnd = attributes.end();
+  for(std::vector<attribute_t>::const_iterator it = attributes.begin(); it != itEnd; it++)
+    if(it->nameLen == len && memcmp(it->name, n, len) == 0)
+      return &(*it);
+
+  return nullptr;
+}
+
+/**
+ * @brief get the value of a numeric attribute
+ * @returns the raw value or nullptr if the attribute is missing or empty
+ *
+ * The value is not NUL terminated, but ends with the quote character. It
+ * must only be passed to functions that stop at the first character that
+ * can't be part of the number, like strtol() or parse_int64().
+ */
+const char *
+xml_tokenizer::rawValue(const char *n) const
+{
+  const attribute_t *attr = attribute(n);
+  if(attr == nullptr || attr->valueLen == 0)
+    return nullptr;
+
+  return attr->value;
+}
+
+/**
+ * @brief get the decoded value of a string attribute
+ * @param buf the buffer to store the value in
+ * @returns the value or nullptr if the attribute is missing or invalid
+ */
+const char *
+xml_tokenizer::value(const char *n, std::string &buf) const
+{
+  const attribute_t *attr = attribute(n);
+  if(attr == nullptr || unlikely(!decode_attribute(attr->value, attr->valueLen, buf)))
+    return nullptr;
+
+  return buf.c_str();
+}
+
+pos_float_t
+xml_tokenizer::coordinate(const char *n) const
+{
+  const attribute_t *attr = attribute(n);
+  if(attr == nullptr || attr->valueLen == 0)
+    return pos_parse_coord(nullptr);
+
+  // the fallback of pos_parse_coord() needs a NUL terminated string
+  char buf[32];
+  if(likely(attr->valueLen < sizeof(buf))) {
+    memcpy(buf, attr->value, attr->valueLen);
+    buf[attr->valueLen] = '\0';
+    return pos_parse_coord(buf);
+  }
+
+  return pos_parse_coord(std::string(attr->value, attr->valueLen).c_str());
+}
+
+int
+xml_tokenizer::uid() const
+{
+  const attribute_t *puid = attribute("uid");
+  if(unlikely(puid == nullptr))
+    return -1;
+
+  char *endp;
+  int ret = strtol(puid->value, &endp, 10);
+  if(unlikely(endp != puid->value + puid->valueLen)) {
+    printf("WARNING: cannot parse uid '%.*s'\n", static_cast<int>(puid->valueLen), puid->value);
+    ret = -1;
+  }
+
+  return ret;
+}
+
+/**
+ * @brief skip comments and processing instructions
+ * @returns false if anything else was found
+ */
+bool
+xml_tokenizer::skipSpecial()
+{
+  static const char commentEnd[] = "-->";
+  static const char piEnd[] = "?>";
+
+  assert_cmpnum(*cursor, '<');
+
+  if(end - cursor > 4 && memcmp(cursor, "<!--", 4) == 0) {
+    cursor = std::search(cursor + 4, end, commentEnd, commentEnd + 3);
+    if(unlikely(cursor == end))
+      return false;
+    cursor += 3;
+    return true;
+  } else if(end - cursor > 2 && cursor[1] == '?') {
+    const char *piStop = std::search(cursor + 2, end, piEnd, piEnd + 2);
+    if(unlikely(piStop == end))
+      return false;
+    // only UTF-8 is supported
+    static const char enc[] = "encoding";
+    const char *e = std::search(cursor + 2, piStop, enc, enc + strlen(enc));
+    if(e != piStop) {
+      e += strlen(enc);
+      while(e < piStop && (is_xml_space(*e) || *e == '=' || *e == '"' || *e == '\''))
+        e++;
+      if(piStop - e < 5 || strncasecmp(e, "UTF-8", 5) != 0)
+        return false;
+    }
+    cursor = piStop + 2;
+    return true;
+  }
+
+  // DOCTYPE, CDATA, and the like
+  return false;
+}
+
+xml_tokenizer::token_t
+xml_tokenizer::next()
+{
+  for(;;) {
+    // skip any text
+    const char *lt = static_cast<const char *>(memchr(cursor, '<', end - cursor));
+    if(lt == nullptr) {
+      cursor = end;
+      return TOKEN_EOF;
+    }
+    cursor = lt;
+    if(unlikely(end - cursor < 2))
+      return TOKEN_ERROR;
+
+    if(cursor[1] != '!' && cursor[1] != '?')
+      break;
+    if(unlikely(!skipSpecial()))
+      return TOKEN_ERROR;
+  }
+
+  const bool isEnd = cursor[1] == '/';
+  cursor += isEnd ? 2 : 1;
+
+  name = cursor;
+  while(cursor < end && !is_xml_space(*cursor) && *cursor != '/' && *cursor != '>' && *cursor != '=')
+    cursor++;
+  nameLen = cursor - name;
+  if(unlikely(nameLen == 0))
+    return TOKEN_ERROR;
+
+  if(isEnd) {
+    while(cursor < end && is_xml_space(*cursor))
+      cursor++;
+    if(unlikely(cursor == end || *cursor != '>'))
+      return TOKEN_ERROR;
+    cursor++;
+    return TOKEN_END;
+  }
+
+  attributes.clear();
+  for(;;) {
+    while(cursor < end && is_xml_space(*cursor))
+      cursor++;
+    if(unlikely(cursor == end))
+      return TOKEN_ERROR;
+
+    if(*cursor == '>') {
+      cursor++;
+      emptyElement = false;
+      return TOKEN_START;
+    } else if(*cursor == '/') {
+      if(unlikely(end - cursor < 2 || cursor[1] != '>'))
+        return TOKEN_ERROR;
+      cursor += 2;
+      emptyElement = true;
+      return TOKEN_START;
+    }
+
+    attribute_t attr;
+    attr.name = cursor;
+    while(cursor < end && !is_xml_space(*cursor) && *cursor != '=' && *cursor != '/' && *cursor != '>')
+      cursor++;
+    attr.nameLen = cursor - attr.name;
+    while(cursor < end && is_xml_space(*cursor))
+      cursor++;
+    if(unlikely(attr.nameLen == 0 || cursor == end || *cursor != '='))
+      return TOKEN_ERROR;
+    cursor++;
+    while(cursor < end && is_xml_space(*cursor))
+      cursor++;
+    if(unlikely(cursor == end || (*cursor != '"' && *cursor != '\'')))
+      return TOKEN_ERROR;
+
+    attr.value = cursor + 1;
+    const char *quote = static_cast<const char *>(memchr(attr.value, *cursor, end - attr.value));
+    if(unlikely(quote == nullptr))
+      return TOKEN_ERROR;
+    attr.valueLen = quote - attr.value;
+    attributes.push_back(attr);
+    cursor = quote + 1;
+  }
+}
+
+/* skip current element incl. everything below */
+bool
+xml_tokenizer::skipElement()
+{
+  if(emptyElement)
+    return true;
+
+  std::vector<std::pair<const char *, size_t> > open;
+  open.push_back(std::make_pair(name, nameLen));
+
+  while(!open.empty()) {
+    switch(next()) {
+    case TOKEN_START:
+      if(!emptyElement)
+        open.push_back(std::make_pair(name, nameLen));
+      break;
+    case TOKEN_END:
+      if(unlikely(open.back().second != nameLen || memcmp(open.back().first, name, nameLen) != 0))
+        return false;
+      open.pop_back();
+      break;
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief the objects read from a part of the file
+ *
+ * This holds everything needed to create the objects later, but does not
+ * access the osm_t object or the value cache, so it can be filled in a worker
+ * thread.
+ */
+struct scanned_chunk_t {
+  enum { NO_STRING = ~static_cast<size_t>(0) };
+
+  struct item_t {
+    explicit inline item_t(object_t::type_t t) : type(t) {}
+    object_t::type_t type;
+    base_attributes attrs;
+    pos_t pos;
+    size_t user; ///< offset of the user name in strings
+    int uid;
+    size_t tagCount;
+    size_t refCount; ///< the number of node references or members
+  };
+
+  struct member_ref_t {
+    size_t type, ref, role; ///< offsets in strings
+  };
+
+  inline scanned_chunk_t(const char *b, const char *e)
+    : begin(b), end(e), ok(false) {}
+
+  const char *begin; ///< first byte of the chunk in the file
+  const char *end;   ///< the byte behind the chunk
+  bool ok;
+  std::vector<item_t> objects;
+  std::vector<std::pair<size_t, size_t> > tags; ///< offsets of key and value in strings
+  std::vector<item_id_t> nodeRefs;
+  std::vector<member_ref_t> members;
+  std::string strings; ///< the strings of all attributes, each NUL terminated
+
+  size_t addString(const char *s)
+  {
+    if(s == nullptr)
+      return NO_STRING;
+    const size_t ret = strings.size();
+    strings.append(s, strlen(s) + 1);
+    return ret;
+  }
+
+  inline const char *string(size_t offset) const
+  {
+    return offset == NO_STRING ? nullptr : strings.c_str() + offset;
   }
 };
 
-osm_t *
-process_file(const std::string &filename)
+const char *
+api_string(object_t::type_t type)
 {
-  std::unique_ptr<osm_t> osm;
-  xmlTextReaderPtr reader;
+  switch(type) {
+  case object_t::NODE:
+    return node_t::api_string();
+  case object_t::WAY:
+    return way_t::api_string();
+  case object_t::RELATION:
+    return relation_t::api_string();
+  default:
+    assert_unreachable();
+  }
+}
 
-  reader = xmlReaderForFile(filename.c_str(), nullptr, XML_PARSE_NONET);
-  if (likely(reader != nullptr)) {
-    if(likely(xmlTextReaderRead(reader) == 1)) {
-      const char *name = reinterpret_cast<const char *>(xmlTextReaderConstName(reader));
-      if(likely(name && strcmp(name, "osm") == 0)) {
-        osm.reset(process_osm(reader));
-        // relations may have references to other relation, which have greater ids
-        // those are not present when the relation itself was created, but may be now
-        if(likely(osm))
-          std::for_each(osm->relations.begin(), osm->relations.end(), relation_ref_functor(osm));
-      }
-    } else
-      printf("file empty\n");
+class chunk_scanner {
+  xml_tokenizer tokenizer;
+  scanned_chunk_t &chunk;
+  std::string buf[3]; ///< buffers for decoded attribute values
+
+  bool scanObject(object_t::type_t type);
+  void scanTag(scanned_chunk_t::item_t &obj);
+
+public:
+  explicit inline chunk_scanner(scanned_chunk_t &c)
+    : tokenizer(c.begin, c.end), chunk(c) {}
+
+  void scan();
+};
+
+void
+chunk_scanner::scanTag(scanned_chunk_t::item_t &obj)
+{
+  const char *k = tokenizer.value("k", buf[0]);
+  const char *v = tokenizer.value("v", buf[1]);
 
-    xmlFreeTextReader(reader);
+  if(likely(k != nullptr && v != nullptr && *k != '\0' && *v != '\0')) {
+    const size_t ko = chunk.addString(k);
+    chunk.tags.push_back(std::make_pair(ko, chunk.addString(v)));
+    obj.tagCount++;
   } else {
-    fprintf(stderr, "Unable to open %s\n", filename.c_str());
+    printf("incomplete tag key/value %s/%s\n", k, v);
   }
-  return osm.release();
 }
 
-} // namespace
+bool
+chunk_scanner::scanObject(object_t::type_t type)
+{
+  chunk.objects.push_back(scanned_chunk_t::item_t(type));
+  scanned_chunk_t::item_t &obj = chunk.objects.back();
+
+  /* version is new in api 0.6 */
+  if(unlikely(!parse_id_version(tokenizer.rawValue("id"), tokenizer.rawValue("version"), obj.attrs))) {
+    printf("WARNING: skipping %s with invalid id or version\n", api_string(type));
+    chunk.objects.pop_back();
+    return tokenizer.skipElement();
+  }
 
-/* ----------------------- end of stream parser ------------------- */
+  obj.user = chunk.addString(tokenizer.value("user", buf[0]));
+  obj.uid = obj.user != scanned_chunk_t::NO_STRING ? tokenizer.uid() : -1;
+
+  const char *prop = tokenizer.rawValue("timestamp");
+  if(likely(prop != nullptr))
+    obj.attrs.time = convert_iso8601(prop);
+
+  if(type == object_t::NODE)
+    obj.pos = pos_t(tokenizer.coordinate("lat"), tokenizer.coordinate("lon"));
+
+  obj.tagCount = 0;
+  obj.refCount = 0;
+
+  if(tokenizer.emptyElement)
+    return true;
+
+  xml_tokenizer::token_t t;
+  while((t = tokenizer.next()) == xml_tokenizer::TOKEN_START) {
+    if(tokenizer.isName("tag")) {
+      scanTag(obj);
+    } else if(type == object_t::WAY && tokenizer.isName("nd")) {
+      prop = tokenizer.rawValue("ref");
+      item_id_t ref;
+      if(likely(prop != nullptr && parse_int64(prop, ref))) {
+        chunk.nodeRefs.push_back(ref);
+        obj.refCount++;
+      } else if(prop != nullptr) {
+        printf("Illegal ref for way node\n");
+      }
+    } else if(type == object_t::RELATION && tokenizer.isName("member")) {
+      scanned_chunk_t::member_ref_t member;
+      member.type = chunk.addString(tokenizer.value("type", buf[0]));
+      member.ref = chunk.addString(tokenizer.value("ref", buf[1]));
+      member.role = chunk.addString(tokenizer.value("role", buf[2]));
+      chunk.members.push_back(member);
+      obj.refCount++;
+    }
+    if(unlikely(!tokenizer.skipElement()))
+      return false;
+  }
+
+  return t == xml_tokenizer::TOKEN_END && tokenizer.isName(api_string(type));
+}
+
+/**
+ * @brief scan all the objects in the chunk
+ *
+ * Elements that are not known are skipped, but they are still recorded
+ * to check the order of the elements later.
+ */
+void
+chunk_scanner::scan()
+{
+  for(;;) {
+    bool elementOk;
+    switch(tokenizer.next()) {
+    case xml_tokenizer::TOKEN_EOF:
+      chunk.ok = true;
+      return;
+    case xml_tokenizer::TOKEN_START:
+      break;
+    default:
+      return;
+    }
+
+    if(tokenizer.isName(node_t::api_string())) {
+      elementOk = scanObject(object_t::NODE);
+    } else if(tokenizer.isName(way_t::api_string())) {
+      elementOk = scanObject(object_t::WAY);
+    } else if(likely(tokenizer.isName(relation_t::api_string()))) {
+      elementOk = scanObject(object_t::RELATION);
+    } else {
+      printf("something unknown found: %.*s\n", static_cast<int>(tokenizer.nameLen), tokenizer.name);
+      elementOk = tokenizer.skipElement();
+    }
+
+    if(unlikely(!elementOk))
+      return;
+  }
+}
+
+void
+scan_chunk(scanned_chunk_t *chunk)
+{
+  chunk_scanner(*chunk).scan();
+}
+
+/**
+ * @brief find the start of the next object element
+ * @param from where to start searching
+ * @param end the end of the buffer
+ *
+ * The result may be wrong, e.g. if the element name is found inside a
+ * comment. In that case scanning the chunk before fails, which makes the
+ * whole file being parsed by libxml.
+ */
+const char *
+find_object_start(const char *from, const char *end)
+{
+  while((from = static_cast<const char *>(memchr(from, '<', end - from))) != nullptr) {
+    const char *n = from + 1;
+    const size_t left = end - n;
+    if((left > 5 && memcmp(n, "node", 4) == 0 && is_xml_space(n[4])) ||
+       (left > 4 && memcmp(n, "way", 3) == 0 && is_xml_space(n[3])) ||
+       (left > 9 && memcmp(n, "relation", 8) == 0 && is_xml_space(n[8])))
+      return from;
+    from = n;
+  }
+
+  return end;
+}
+
+/**
+ * @brief create the objects from the scanned chunks
+ *
+ * This is done in a single thread as it needs to modify the osm_t object and
+ * the value cache, and to resolve the references of ways and relations which
+ * may point to objects from other chunks.
+ */
+class chunk_builder {
+  osm_t::ref osm;
+
+  /* the objects come in exactly this order, so e.g. no node can show up
+   * after the first way was seen */
+  enum blocks {
+    BLOCK_OSM = 0,
+    BLOCK_NODES,
+    BLOCK_WAYS,
+    BLOCK_RELATIONS
+  };
+  enum blocks block;
+  int num_elems;
+
+  // the tags of the last tagged object of the current chunk
+  tag_list_t lastTags;
+  size_t lastTagPos;
+  size_t lastTagCount;
+
+  base_attributes attributes(const scanned_chunk_t &chunk, const scanned_chunk_t::item_t &obj);
+  bool sameTags(const scanned_chunk_t &chunk, size_t tagPos, size_t tagCount) const;
+  void tags(const scanned_chunk_t &chunk, size_t &tagPos, const scanned_chunk_t::item_t &obj, base_object_t *o);
+
+public:
+  inline chunk_builder(osm_t::ref o, bool haveBounds)
+    : osm(o), block(haveBounds ? BLOCK_NODES : BLOCK_OSM), num_elems(0)
+    , lastTagPos(0), lastTagCount(0) {}
+
+  void build(const scanned_chunk_t &chunk);
+};
+
+base_attributes
+chunk_builder::attributes(const scanned_chunk_t &chunk, const scanned_chunk_t::item_t &obj)
+{
+  base_attributes ret = obj.attrs;
+  const char *user = chunk.string(obj.user);
+  if(likely(user != nullptr))
+    ret.user = osm_user_insert(osm->users, user, obj.uid);
+
+  return ret;
+}
+
+bool
+chunk_builder::sameTags(const scanned_chunk_t &chunk, size_t tagPos, size_t tagCount) const
+{
+  if(lastTags.empty() || tagCount != lastTagCount)
+    return false;
+
+  for(size_t i = 0; i < tagCount; i++) {
+    const std::pair<size_t, size_t> &last = chunk.tags[lastTagPos + i];
+    const std::pair<size_t, size_t> &cur = chunk.tags[tagPos + i];
+    // strings from a PBF string table have the same offset if they are equal
+    if((last.first != cur.first && strcmp(chunk.string(last.first), chunk.string(cur.first)) != 0) ||
+       (last.second != cur.second && strcmp(chunk.string(last.second), chunk.string(cur.second)) != 0))
+      return false;
+  }
+
+  return true;
+}
+
+void
+chunk_builder::tags(const scanned_chunk_t &chunk, size_t &tagPos, const scanned_chunk_t::item_t &obj, base_object_t *o)
+{
+  // most nodes are only part of ways and have no tags at all
+  if(obj.tagCount == 0)
+    return;
+
+  // runs of objects with the same tags are common, e.g. nodes that only have
+  // created_by set by the editor that uploaded them, so the previous list is
+  // reused without looking up the strings again
+  if(sameTags(chunk, tagPos, obj.tagCount)) {
+    o->tags.share(lastTags);
+    tagPos += obj.tagCount;
+    return;
+  }
+
+  lastTagPos = tagPos;
+  lastTagCount = obj.tagCount;
+
+  std::vector<tag_t> ntags;
+  ntags.reserve(obj.tagCount);
+  for(size_t i = 0; i < obj.tagCount; i++, tagPos++)
+    ntags.push_back(tag_t(chunk.string(chunk.tags[tagPos].first), chunk.string(chunk.tags[tagPos].second)));
+  o->tags.replace(std::move(ntags));
+
+  lastTags.clear();
+  lastTags.share(o->tags);
+}
+
+void
+chunk_builder::build(const scanned_chunk_t &chunk)
+{
+  size_t tagPos = 0, refPos = 0, memberPos = 0;
+  const int tick_every = 50; // Balance responsive appearance with performance.
+
+  // the positions of the previous chunk are meaningless here
+  lastTags.clear();
+
+  const std::vector<scanned_chunk_t::item_t>::const_iterator itEnd = chunk.objects.end();
+  for(std::vector<scanned_chunk_t::item_t>::const_iterator it = chunk.objects.begin(); it != itEnd; it++) {
+    const scanned_chunk_t::item_t &obj = *it;
+
+    if (num_elems++ > tick_every) {
+      num_elems = 0;
+      osm2go_platform::process_events();
+    }
+
+    if(obj.type == object_t::NODE && block == BLOCK_NODES) {
+      node_t *node = osm->node_new(obj.pos, attributes(chunk, obj));
+      assert_cmpnum(node->flags, 0);
+      osm->insert(node);
+
+      tags(chunk, tagPos, obj, node);
+    } else if(obj.type == object_t::WAY && block <= BLOCK_WAYS) {
+      block = BLOCK_WAYS;
+
+      way_t *way = new(osm->pools.ways) way_t(attributes(chunk, obj));
+      assert_cmpnum(way->flags, 0);
+      osm->insert(way);
+
+      way->node_chain.reserve(obj.refCount);
+      for(size_t i = 0; i < obj.refCount; i++, refPos++) {
+        node_t *n = node_by_ref(chunk.nodeRefs[refPos], osm.get());
+        if(likely(n != nullptr)) {
+          way->node_chain.push_back(n);
+          osm->addNodeWayRef(n, way);
+        }
+      }
+
+      tags(chunk, tagPos, obj, way);
+    } else if(likely(obj.type == object_t::RELATION && block <= BLOCK_RELATIONS)) {
+      block = BLOCK_RELATIONS;
+
+      relation_t *relation = new(osm->pools.relations) relation_t(attributes(chunk, obj));
+      assert_cmpnum(relation->flags, 0);
+      osm->insert(relation);
+
+      for(size_t i = 0; i < obj.refCount; i++, memberPos++) {
+        const scanned_chunk_t::member_ref_t &m = chunk.members[memberPos];
+        osm->parse_relation_member(chunk.string(m.type), chunk.string(m.ref),
+                                   chunk.string(m.role), relation->members);
+      }
+
+      tags(chunk, tagPos, obj, relation);
+      osm->addMemberRefs(relation);
+    } else {
+      printf("something unknown found: %s\n", api_string(obj.type));
+      tagPos += obj.tagCount;
+      if(obj.type == object_t::WAY)
+        refPos += obj.refCount;
+      else if(obj.type == object_t::RELATION)
+        memberPos += obj.refCount;
+    }
+  }
+}
+
+/**
+ * @brief create the objects of all chunks
+ * @returns false if any of the chunks could not be scanned
+ */
+bool
+build_chunks(osm_t::ref osm, bool haveBounds, const std::vector<scanned_chunk_t> &chunks)
+{
+  chunk_builder builder(osm, haveBounds);
+  const std::vector<scanned_chunk_t>::const_iterator itEnd = chunks.end();
+  for(std::vector<scanned_chunk_t>::const_iterator it = chunks.begin(); it != itEnd; it++) {
+    if(unlikely(!it->ok))
+      return false;
+    builder.build(*it);
+  }
+
+  return true;
+}
+
+/**
+ * @brief scan the start of the osm element and the bounds
+ * @param data the start of the file
+ * @param end the end of the data, must at least include the bounds
+ * @param policy the upload policy is stored here
+ * @param bounds the bounds are stored here if present
+ * @returns the start of the objects
+ * @retval nullptr the header could not be parsed
+ */
+const char *
+scan_header(const char *data, const char *end, osm_t::UploadPolicy &policy, std::optional<bounds_t> &bounds)
+{
+  xml_tokenizer tokenizer(data, end);
+  if(unlikely(tokenizer.next() != xml_tokenizer::TOKEN_START || !tokenizer.isName("osm") ||
+              tokenizer.emptyElement))
+    return nullptr;
+
+  std::string buf;
+  const char *prop = tokenizer.value("upload", buf);
+  if(unlikely(prop != nullptr))
+    policy = parseUploadPolicy(prop);
+
+  // the bounds must come first
+  const char *bodyStart = tokenizer.cursor;
+  if(tokenizer.next() == xml_tokenizer::TOKEN_START && tokenizer.isName("bounds")) {
+    bounds = make_bounds(pos_area(pos_t(tokenizer.coordinate("minlat"), tokenizer.coordinate("minlon")),
+                                  pos_t(tokenizer.coordinate("maxlat"), tokenizer.coordinate("maxlon"))));
+    if(unlikely(!bounds || !tokenizer.skipElement()))
+      return nullptr;
+    bodyStart = tokenizer.cursor;
+  }
+
+  return bodyStart;
+}
+
+/**
+ * @brief find the end of the objects
+ * @returns the start of the closing tag of the osm element
+ * @retval nullptr there is no such tag or something follows it
+ */
+const char *
+find_body_end(const char *bodyStart, const char *end)
+{
+  // the closing tag of the osm element is the last one in the file
+  static const char osmEnd[] = "</osm";
+  const char *bodyEnd = std::find_end(bodyStart, end, osmEnd, osmEnd + strlen(osmEnd));
+  if(unlikely(bodyEnd == end))
+    return nullptr;
+  xml_tokenizer tail(bodyEnd, end);
+  if(unlikely(tail.next() != xml_tokenizer::TOKEN_END || !tail.isName("osm") ||
+              tail.next() != xml_tokenizer::TOKEN_EOF))
+    return nullptr;
+
+  return bodyEnd;
+}
+
+/**
+ * @brief parse a memory mapped OSM file
+ *
+ * The contents are split into chunks at the starts of object elements, which
+ * are scanned in parallel. The objects are then created in the order they
+ * appear in the file.
+ *
+ * @returns the parsed data or nullptr if the libxml parser should be tried
+ */
+osm_t *
+scan_osm(const char *data, size_t len)
+{
+  /* alloc osm structure */
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+
+  std::optional<bounds_t> bounds;
+  const char *bodyStart = scan_header(data, data + len, osm->uploadPolicy, bounds);
+  if(unlikely(bodyStart == nullptr))
+    return nullptr;
+  if(bounds)
+    osm->bounds = *bounds;
+
+  const char *bodyEnd = find_body_end(bodyStart, data + len);
+  if(unlikely(bodyEnd == nullptr))
+    return nullptr;
+
+  // small files are not worth starting a thread
+  const size_t minChunkSize = 4 * 1024 * 1024;
+  unsigned int threads = 1;
+#if __cplusplus >= 201103L
+  threads = std::max(1u, std::min(std::thread::hardware_concurrency(), 8u));
+#endif
+  const size_t bodyLen = bodyEnd - bodyStart;
+  const size_t chunkSize = std::max(minChunkSize, bodyLen / threads + 1);
+
+  std::vector<scanned_chunk_t> chunks;
+  for(const char *start = bodyStart; start < bodyEnd; ) {
+    const char *stop = bodyEnd;
+    if(static_cast<size_t>(bodyEnd - start) > chunkSize)
+      stop = find_object_start(start + chunkSize, bodyEnd);
+    chunks.push_back(scanned_chunk_t(start, stop));
+    start = stop;
+  }
+
+#if __cplusplus >= 201103L
+  // the first chunk is scanned in this thread
+  std::vector<std::thread> workers;
+  for(size_t i = 1; i < chunks.size(); i++)
+    workers.push_back(std::thread(scan_chunk, &chunks[i]));
+  if(!chunks.empty())
+    scan_chunk(&chunks.front());
+  std::for_each(workers.begin(), workers.end(), std::mem_fn(&std::thread::join));
+#else
+  for(size_t i = 0; i < chunks.size(); i++)
+    scan_chunk(&chunks[i]);
+#endif
+
+  if(unlikely(!build_chunks(osm, static_cast<bool>(bounds), chunks)))
+    return nullptr;
+
+  return osm.release();
+}
+
+/* ------------------------- PBF reader --------------------- */
+
+/**
+ * @brief minimal reader for the protocol buffer wire format
+ *
+ * Errors are sticky: once the data was found to be invalid every further
+ * access returns 0 and ok is false.
+ */
+class pbf_reader {
+  const unsigned char *pos;
+  const unsigned char *end;
+
+public:
+  enum wire_type {
+    WIRE_VARINT = 0,
+    WIRE_FIXED64 = 1,
+    WIRE_LENGTH = 2,
+    WIRE_FIXED32 = 5
+  };
+
+  inline pbf_reader()
+    : pos(nullptr), end(nullptr), ok(true), field(0), wire(WIRE_VARINT) {}
+  inline pbf_reader(const char *b, const char *e)
+    : pos(reinterpret_cast<const unsigned char *>(b)), end(reinterpret_cast<const unsigned char *>(e))
+    , ok(true), field(0), wire(WIRE_VARINT) {}
+
+  bool ok;
+  uint32_t field; ///< the field number of the current key
+  unsigned int wire; ///< the wire type of the current key
+
+  /**
+   * @brief if there is unread data left, used to iterate over packed fields
+   */
+  inline bool more() const
+  { return ok && pos < end; }
+
+  /**
+   * @brief read the next key
+   * @returns if a field was found
+   */
+  bool next();
+
+  uint64_t varint();
+  inline int64_t svarint()
+  {
+    const uint64_t v = varint();
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+
+  /**
+   * @brief read the value of the current length delimited field
+   */
+  pbf_reader message();
+  std::string bytes()
+  {
+    const pbf_reader r = message();
+    return std::string(reinterpret_cast<const char *>(r.pos), r.end - r.pos);
+  }
+  inline const char *data() const
+  { return reinterpret_cast<const char *>(pos); }
+  inline const char *dataEnd() const
+  { return reinterpret_cast<const char *>(end); }
+
+  /**
+   * @brief read the value of the current field as varint
+   */
+  inline uint64_t value()
+  {
+    if(unlikely(wire != WIRE_VARINT))
+      ok = false;
+    return varint();
+  }
+
+  inline int64_t svalue()
+  {
+    if(unlikely(wire != WIRE_VARINT))
+      ok = false;
+    return svarint();
+  }
+
+  /**
+   * @brief skip the value of the current field
+   */
+  void skip();
+};
+
+bool
+pbf_reader::next()
+{
+  if(!more())
+    return false;
+  const uint64_t key = varint();
+  field = key >> 3;
+  wire = key & 7;
+  return ok;
+}
+
+uint64_t
+pbf_reader::varint()
+{
+  uint64_t ret = 0;
+  for(unsigned int shift = 0; likely(pos < end && shift < 64); shift += 7) {
+    const unsigned char c = *pos++;
+    ret |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if(likely(!(c & 0x80)))
+      return ret;
+  }
+  ok = false;
+  pos = end;
+  return 0;
+}
+
+pbf_reader
+pbf_reader::message()
+{
+  pbf_reader ret;
+  if(unlikely(wire != WIRE_LENGTH)) {
+    ok = false;
+    return ret;
+  }
+  const uint64_t len = varint();
+  if(unlikely(!ok || len > static_cast<uint64_t>(end - pos))) {
+    ok = false;
+    return ret;
+  }
+  ret = pbf_reader(data(), data() + len);
+  pos += len;
+  return ret;
+}
+
+void
+pbf_reader::skip()
+{
+  size_t len;
+  switch(wire) {
+  case WIRE_VARINT:
+    varint();
+    return;
+  case WIRE_LENGTH:
+    message();
+    return;
+  case WIRE_FIXED64:
+    len = 8;
+    break;
+  case WIRE_FIXED32:
+    len = 4;
+    break;
+  default:
+    ok = false;
+    return;
+  }
+  if(unlikely(len > static_cast<size_t>(end - pos)))
+    ok = false;
+  else
+    pos += len;
+}
+
+/**
+ * @brief get the uncompressed contents of a Blob message
+ * @param blob the Blob message
+ * @param buffer storage for the uncompressed data
+ * @param block set to the uncompressed data
+ */
+bool
+pbf_blob_data(pbf_reader blob, std::string &buffer, pbf_reader &block)
+{
+  pbf_reader zdata;
+  bool haveZ = false;
+  uint64_t rawSize = 0;
+
+  while(blob.next()) {
+    switch(blob.field) {
+    case 1: // raw
+      block = blob.message();
+      return blob.ok;
+    case 2: // raw_size
+      rawSize = blob.value();
+      break;
+    case 3: // zlib_data
+      zdata = blob.message();
+      haveZ = true;
+      break;
+    case 4: // lzma_data
+    case 6: // lz4_data
+    case 7: // zstd_data
+      printf("unsupported compression %u of PBF blob\n", blob.field);
+      return false;
+    default:
+      blob.skip();
+    }
+  }
+
+  // the specification limits the blob size to 32 MiB
+  if(unlikely(!blob.ok || !haveZ || rawSize > 32 * 1024 * 1024))
+    return false;
+
+  buffer.resize(rawSize);
+  uLongf len = rawSize;
+  if(unlikely(uncompress(reinterpret_cast<Bytef *>(&buffer[0]), &len,
+                         reinterpret_cast<const Bytef *>(zdata.data()),
+                         zdata.dataEnd() - zdata.data()) != Z_OK || len != rawSize))
+    return false;
+
+  block = pbf_reader(buffer.data(), buffer.data() + buffer.size());
+  return true;
+}
+
+/**
+ * @brief decodes a PrimitiveBlock into a scanned_chunk_t
+ *
+ * The chunk covers the Blob message in the file.
+ */
+class pbf_block_decoder {
+  scanned_chunk_t &chunk;
+  std::string buffer; ///< the uncompressed block
+  std::vector<size_t> stringTable; ///< offsets of the string table entries in chunk.strings
+  size_t typeStrings[3]; ///< offsets of the member type names in chunk.strings
+  int64_t granularity, dateGranularity, latOffset, lonOffset;
+
+  inline pos_t position(int64_t lat, int64_t lon) const
+  {
+    return pos_t((latOffset + granularity * lat) / 1e9, (lonOffset + granularity * lon) / 1e9);
+  }
+  inline time_t timestamp(int64_t t) const
+  { return t * dateGranularity / 1000; }
+  inline bool validString(uint64_t idx) const
+  { return idx < stringTable.size(); }
+  void setUser(scanned_chunk_t::item_t &obj, uint64_t userSid, int uid) const;
+  bool addTag(scanned_chunk_t::item_t &obj, uint64_t key, uint64_t value);
+
+  bool strings(pbf_reader table);
+  void info(pbf_reader msg, scanned_chunk_t::item_t &obj);
+  bool checkVersion(const scanned_chunk_t::item_t &obj) const;
+  bool dense(pbf_reader msg);
+  bool object(pbf_reader msg, object_t::type_t type);
+  bool group(pbf_reader msg);
+
+public:
+  explicit pbf_block_decoder(scanned_chunk_t &c)
+    : chunk(c), granularity(100), dateGranularity(1000), latOffset(0), lonOffset(0) {}
+
+  void decode();
+};
+
+void
+pbf_block_decoder::setUser(scanned_chunk_t::item_t &obj, uint64_t userSid, int uid) const
+{
+  // the empty string at index 0 means there is no user
+  if(userSid != 0 && validString(userSid)) {
+    obj.user = stringTable[userSid];
+    obj.uid = uid;
+  }
+}
+
+bool
+pbf_block_decoder::addTag(scanned_chunk_t::item_t &obj, uint64_t key, uint64_t value)
+{
+  if(unlikely(!validString(key) || !validString(value)))
+    return false;
+
+  const char *k = chunk.string(stringTable[key]);
+  const char *v = chunk.string(stringTable[value]);
+  if(likely(*k != '\0' && *v != '\0')) {
+    chunk.tags.push_back(std::make_pair(stringTable[key], stringTable[value]));
+    obj.tagCount++;
+  } else {
+    printf("incomplete tag key/value %s/%s\n", k, v);
+  }
+  return true;
+}
+
+/**
+ * @brief check that the object has a version
+ *
+ * Files written without metadata can be read, but the objects could never be
+ * uploaded.
+ */
+bool
+pbf_block_decoder::checkVersion(const scanned_chunk_t::item_t &obj) const
+{
+  if(likely((obj.attrs.version == 0) == (obj.attrs.id <= ID_ILLEGAL)))
+    return true;
+
+  printf("%s #" ITEM_ID_FORMAT " has no version information\n", api_string(obj.type), obj.attrs.id);
+  return false;
+}
+
+bool
+pbf_block_decoder::strings(pbf_reader table)
+{
+  while(table.next()) {
+    if(table.field == 1) {
+      const pbf_reader s = table.message();
+      stringTable.push_back(chunk.strings.size());
+      chunk.strings.append(s.data(), s.dataEnd() - s.data());
+      chunk.strings.push_back('\0');
+    } else {
+      table.skip();
+    }
+  }
+
+  return table.ok;
+}
+
+void
+pbf_block_decoder::info(pbf_reader msg, scanned_chunk_t::item_t &obj)
+{
+  uint64_t userSid = 0;
+  int uid = -1;
+
+  while(msg.next()) {
+    switch(msg.field) {
+    case 1:
+      obj.attrs.version = msg.value();
+      break;
+    case 2:
+      obj.attrs.time = timestamp(msg.value());
+      break;
+    case 4:
+      uid = msg.value();
+      break;
+    case 5:
+      userSid = msg.value();
+      break;
+    default:
+      msg.skip();
+    }
+  }
+
+  if(likely(msg.ok))
+    setUser(obj, userSid, uid);
+}
+
+bool
+pbf_block_decoder::dense(pbf_reader msg)
+{
+  pbf_reader ids, lats, lons, keysVals, versions, times, uids, users;
+
+  while(msg.next()) {
+    switch(msg.field) {
+    case 1:
+      ids = msg.message();
+      break;
+    case 5: {
+      pbf_reader info = msg.message();
+      while(info.next()) {
+        switch(info.field) {
+        case 1:
+          versions = info.message();
+          break;
+        case 2:
+          times = info.message();
+          break;
+        case 4:
+          uids = info.message();
+          break;
+        case 5:
+          users = info.message();
+          break;
+        default:
+          info.skip();
+        }
+      }
+      if(unlikely(!info.ok))
+        return false;
+      break;
+    }
+    case 8:
+      lats = msg.message();
+      break;
+    case 9:
+      lons = msg.message();
+      break;
+    case 10:
+      keysVals = msg.message();
+      break;
+    default:
+      msg.skip();
+    }
+  }
+  if(unlikely(!msg.ok))
+    return false;
+
+  // everything but the versions is delta coded
+  int64_t id = 0, lat = 0, lon = 0, time = 0, uid = 0, userSid = 0;
+  while(ids.more()) {
+    chunk.objects.push_back(scanned_chunk_t::item_t(object_t::NODE));
+    scanned_chunk_t::item_t &obj = chunk.objects.back();
+    obj.user = scanned_chunk_t::NO_STRING;
+    obj.uid = -1;
+    obj.tagCount = 0;
+    obj.refCount = 0;
+
+    id += ids.svarint();
+    obj.attrs.id = id;
+    lat += lats.svarint();
+    lon += lons.svarint();
+    if(unlikely(!lats.ok || !lons.ok))
+      return false;
+    obj.pos = position(lat, lon);
+
+    if(versions.more())
+      obj.attrs.version = versions.varint();
+    if(unlikely(!checkVersion(obj)))
+      return false;
+    if(times.more()) {
+      time += times.svarint();
+      obj.attrs.time = timestamp(time);
+    }
+    if(uids.more())
+      uid += uids.svarint();
+    if(users.more()) {
+      userSid += users.svarint();
+      setUser(obj, userSid, uid);
+    }
+
+    // the tags of all nodes, each list terminated by a 0 key
+    while(keysVals.more()) {
+      const uint64_t k = keysVals.varint();
+      if(k == 0)
+        break;
+      if(unlikely(!addTag(obj, k, keysVals.varint())))
+        return false;
+    }
+  }
+
+  return ids.ok && versions.ok && times.ok && uids.ok && users.ok && keysVals.ok;
+}
+
+bool
+pbf_block_decoder::object(pbf_reader msg, object_t::type_t type)
+{
+  chunk.objects.push_back(scanned_chunk_t::item_t(type));
+  scanned_chunk_t::item_t &obj = chunk.objects.back();
+  obj.user = scanned_chunk_t::NO_STRING;
+  obj.uid = -1;
+  obj.tagCount = 0;
+  obj.refCount = 0;
+
+  pbf_reader keys, vals, refs, roles, memberIds, memberTypes;
+  int64_t lat = 0, lon = 0;
+
+  while(msg.next()) {
+    switch(msg.field) {
+    case 1:
+      // only the node id is zigzag encoded
+      obj.attrs.id = type == object_t::NODE ? msg.svalue() : static_cast<int64_t>(msg.value());
+      break;
+    case 2:
+      keys = msg.message();
+      break;
+    case 3:
+      vals = msg.message();
+      break;
+    case 4:
+      info(msg.message(), obj);
+      break;
+    case 8:
+      if(type == object_t::NODE)
+        lat = msg.svalue();
+      else if(type == object_t::WAY)
+        refs = msg.message();
+      else
+        roles = msg.message();
+      break;
+    case 9:
+      if(type == object_t::NODE)
+        lon = msg.svalue();
+      else if(type == object_t::RELATION)
+        memberIds = msg.message();
+      else
+        msg.skip();
+      break;
+    case 10:
+      if(type == object_t::RELATION)
+        memberTypes = msg.message();
+      else
+        msg.skip();
+      break;
+    default:
+      msg.skip();
+    }
+  }
+  if(unlikely(!msg.ok || !checkVersion(obj)))
+    return false;
+
+  if(type == object_t::NODE)
+    obj.pos = position(lat, lon);
+
+  while(keys.more() && vals.more())
+    if(unlikely(!addTag(obj, keys.varint(), vals.varint())))
+      return false;
+
+  int64_t ref = 0;
+  while(refs.more()) {
+    ref += refs.svarint();
+    chunk.nodeRefs.push_back(ref);
+    obj.refCount++;
+  }
+
+  while(memberIds.more() && memberTypes.more() && roles.more()) {
+    ref += memberIds.svarint();
+    const uint64_t mtype = memberTypes.varint();
+    const uint64_t role = roles.varint();
+    if(unlikely(mtype > 2 || !validString(role)))
+      return false;
+
+    // the members are passed as strings just like they are found in XML files
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%" PRId64, ref);
+    scanned_chunk_t::member_ref_t member;
+    member.type = typeStrings[mtype];
+    member.ref = chunk.addString(buf);
+    member.role = stringTable[role];
+    chunk.members.push_back(member);
+    obj.refCount++;
+  }
+
+  return keys.ok && vals.ok && refs.ok && memberIds.ok && memberTypes.ok && roles.ok;
+}
+
+bool
+pbf_block_decoder::group(pbf_reader msg)
+{
+  while(msg.next()) {
+    bool ret;
+    switch(msg.field) {
+    case 1:
+      ret = object(msg.message(), object_t::NODE);
+      break;
+    case 2:
+      ret = dense(msg.message());
+      break;
+    case 3:
+      ret = object(msg.message(), object_t::WAY);
+      break;
+    case 4:
+      ret = object(msg.message(), object_t::RELATION);
+      break;
+    default:
+      // changesets
+      msg.skip();
+      ret = true;
+    }
+    if(unlikely(!ret))
+      return false;
+  }
+
+  return msg.ok;
+}
+
+void
+pbf_block_decoder::decode()
+{
+  pbf_reader block;
+  if(unlikely(!pbf_blob_data(pbf_reader(chunk.begin, chunk.end), buffer, block)))
+    return;
+
+  typeStrings[0] = chunk.addString(node_t::api_string());
+  typeStrings[1] = chunk.addString(way_t::api_string());
+  typeStrings[2] = chunk.addString(relation_t::api_string());
+
+  // the groups usually come before the granularity settings, so collect them first
+  std::vector<pbf_reader> groups;
+  while(block.next()) {
+    switch(block.field) {
+    case 1:
+      if(unlikely(!strings(block.message())))
+        return;
+      break;
+    case 2:
+      groups.push_back(block.message());
+      break;
+    case 17:
+      granularity = block.value();
+      break;
+    case 18:
+      dateGranularity = block.value();
+      break;
+    case 19:
+      latOffset = block.value();
+      break;
+    case 20:
+      lonOffset = block.value();
+      break;
+    default:
+      block.skip();
+    }
+  }
+  if(unlikely(!block.ok))
+    return;
+
+  for(std::vector<pbf_reader>::const_iterator it = groups.begin(); it != groups.end(); it++)
+    if(unlikely(!group(*it)))
+      return;
+
+  chunk.ok = true;
+}
+
+#if __cplusplus >= 201103L
+void
+decode_pbf_chunks(std::vector<scanned_chunk_t> *chunks, std::atomic<size_t> *nextChunk)
+{
+  size_t i;
+  while((i = (*nextChunk)++) < chunks->size())
+    pbf_block_decoder(chunks->at(i)).decode();
+}
+#endif
+
+/**
+ * @brief read the next BlobHeader
+ * @param pos the start of the header, is moved behind the blob
+ * @param end the end of the file
+ * @param type the type of the blob
+ * @param blob set to the Blob message
+ */
+bool
+pbf_next_blob(const char *&pos, const char *end, std::string &type, pbf_reader &blob)
+{
+  if(unlikely(end - pos < 4))
+    return false;
+  const unsigned char *l = reinterpret_cast<const unsigned char *>(pos);
+  const uint32_t headerLen = (l[0] << 24) | (l[1] << 16) | (l[2] << 8) | l[3];
+  pos += 4;
+  if(unlikely(headerLen > 64 * 1024 || headerLen > static_cast<size_t>(end - pos)))
+    return false;
+
+  pbf_reader header(pos, pos + headerLen);
+  pos += headerLen;
+  uint64_t dataSize = ~static_cast<uint64_t>(0);
+  type.clear();
+  while(header.next()) {
+    switch(header.field) {
+    case 1:
+      type = header.bytes();
+      break;
+    case 3:
+      dataSize = header.value();
+      break;
+    default:
+      header.skip();
+    }
+  }
+  if(unlikely(!header.ok || dataSize > static_cast<uint64_t>(end - pos)))
+    return false;
+
+  blob = pbf_reader(pos, pos + dataSize);
+  pos += dataSize;
+  return true;
+}
+
+/**
+ * @brief check if the data looks like an OSM PBF file
+ *
+ * The first blob of those files is always the OSMHeader.
+ */
+bool
+check_pbf(const char *data, size_t len)
+{
+  std::string type;
+  pbf_reader blob;
+  return pbf_next_blob(data, data + len, type, blob) && type == "OSMHeader";
+}
+
+/**
+ * @brief read the HeaderBlock
+ * @returns if the file can be read
+ */
+bool
+pbf_header(pbf_reader blob, osm_t::ref osm, bool &haveBounds)
+{
+  std::string buffer;
+  pbf_reader header;
+  if(unlikely(!pbf_blob_data(blob, buffer, header)))
+    return false;
+
+  while(header.next()) {
+    switch(header.field) {
+    case 1: {
+      pbf_reader bbox = header.message();
+      int64_t b[4] = { 0, 0, 0, 0 }; // left, right, top, bottom
+      while(bbox.next()) {
+        if(bbox.field >= 1 && bbox.field <= 4)
+          b[bbox.field - 1] = bbox.svalue();
+        else
+          bbox.skip();
+      }
+      // the coordinates are given in nanodegrees
+      std::optional<bounds_t> bounds = make_bounds(pos_area(pos_t(b[3] / 1e9, b[0] / 1e9),
+                                                            pos_t(b[2] / 1e9, b[1] / 1e9)));
+      if(unlikely(!bbox.ok || !bounds))
+        return false;
+      osm->bounds = *bounds;
+      haveBounds = true;
+      break;
+    }
+    case 4: {
+      const std::string feature = header.bytes();
+      if(unlikely(feature != "OsmSchema-V0.6" && feature != "DenseNodes")) {
+        printf("unsupported PBF feature %s\n", feature.c_str());
+        return false;
+      }
+      break;
+    }
+    default:
+      header.skip();
+    }
+  }
+
+  return header.ok;
+}
+
+/**
+ * @brief parse a memory mapped OSM PBF file
+ *
+ * The data blocks are independent of each other, so they are decoded in
+ * parallel. The objects are then created in the order they appear in the
+ * file.
+ */
+osm_t *
+scan_pbf(const char *data, size_t len)
+{
+  const char * const end = data + len;
+  std::string type;
+  pbf_reader blob;
+
+  if(unlikely(!pbf_next_blob(data, end, type, blob) || type != "OSMHeader"))
+    return nullptr;
+
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  bool haveBounds = false;
+  if(unlikely(!pbf_header(blob, osm, haveBounds)))
+    return nullptr;
+
+  std::vector<scanned_chunk_t> chunks;
+  while(data < end) {
+    if(unlikely(!pbf_next_blob(data, end, type, blob)))
+      return nullptr;
+    // unknown blob types are ignored
+    if(likely(type == "OSMData"))
+      chunks.push_back(scanned_chunk_t(blob.data(), blob.dataEnd()));
+  }
+
+#if __cplusplus >= 201103L
+  // the calling thread takes part in decoding
+  std::atomic<size_t> nextChunk(0);
+  const unsigned int threads = std::max(1u, std::min(std::thread::hardware_concurrency(), 8u));
+  std::vector<std::thread> workers;
+  for(unsigned int i = 1; i < threads && i < chunks.size(); i++)
+    workers.push_back(std::thread(decode_pbf_chunks, &chunks, &nextChunk));
+  decode_pbf_chunks(&chunks, &nextChunk);
+  std::for_each(workers.begin(), workers.end(), std::mem_fn(&std::thread::join));
+#else
+  for(size_t i = 0; i < chunks.size(); i++)
+    pbf_block_decoder(chunks[i]).decode();
+#endif
+
+  if(unlikely(!build_chunks(osm, haveBounds, chunks)))
+    return nullptr;
+
+  return osm.release();
+}
+
+struct relation_ref_functor {
+  osm_t::ref osm;
+  const relation_t *relation;
+  explicit inline relation_ref_functor(osm_t::ref o) : osm(o), relation(nullptr) {}
+  void operator()(std::pair<item_id_t, relation_t *> p) {
+    relation = p.second;
+    std::for_each(p.second->members.begin(), p.second->members.end(), *this);
+  }
+  void operator()(member_t &m) {
+    if(m.object.type != object_t::RELATION_ID)
+      return;
+    relation_t *r = osm->object_by_id<relation_t>(m.object.get_id());
+    if(r == nullptr)
+      return;
+    m.object = r;
+    osm->addMemberRef(m.object, relation);
+  }
+};
+
+/* ----------------------- incremental parser ------------------- */
+
+class stream_scanner : public osm_stream_parser {
+  enum {
+    STREAM_DETECT,  ///< not enough data to check the compression
+    STREAM_PLAIN,
+    STREAM_GZIP,
+    STREAM_FAILED
+  } mode;
+  z_stream zs;
+  std::string pending; ///< uncompressed data that was not scanned yet
+  bool headerDone;
+  osm_t::UploadPolicy policy;
+  std::optional<bounds_t> bounds;
+  std::vector<scanned_chunk_t> chunks;
+
+  void inflateData(const char *data, size_t len);
+  void scan(bool final);
+  void scanChunk(const char *end);
+
+public:
+  stream_scanner()
+    : osm_stream_parser(), mode(STREAM_DETECT), headerDone(false), policy(osm_t::Upload_Normal)
+  {
+    memset(&zs, 0, sizeof(zs));
+  }
+  ~stream_scanner() override
+  {
+    if(mode == STREAM_GZIP)
+      inflateEnd(&zs);
+  }
+
+  void feed(const char *data, size_t len) override;
+  osm_t *finish() override;
+};
+
+void
+stream_scanner::inflateData(const char *data, size_t len)
+{
+  zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  zs.avail_in = len;
+
+  char buf[64 * 1024];
+  do {
+    zs.next_out = reinterpret_cast<Bytef *>(buf);
+    zs.avail_out = sizeof(buf);
+    const int ret = inflate(&zs, Z_NO_FLUSH);
+    if(unlikely(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)) {
+      mode = STREAM_FAILED;
+      return;
+    }
+    pending.append(buf, sizeof(buf) - zs.avail_out);
+    if(ret == Z_STREAM_END)
+      return;
+  } while(zs.avail_out == 0);
+}
+
+void
+stream_scanner::scanChunk(const char *end)
+{
+  chunks.push_back(scanned_chunk_t(pending.data(), end));
+  scan_chunk(&chunks.back());
+  if(unlikely(!chunks.back().ok))
+    mode = STREAM_FAILED;
+  pending.erase(0, end - pending.data());
+}
+
+/**
+ * @brief scan everything that is complete
+ * @param final if all data has been received
+ */
+void
+stream_scanner::scan(bool final)
+{
+  const char *data = pending.data();
+  const char *end = data + pending.size();
+
+  if(!headerDone) {
+    // wait until the start of the first object is there, which means the bounds are complete
+    const char *first = find_object_start(data, end);
+    if(first == end && !final)
+      return;
+    const char *bodyStart = scan_header(data, first, policy, bounds);
+    if(unlikely(bodyStart == nullptr)) {
+      mode = STREAM_FAILED;
+      return;
+    }
+    pending.erase(0, bodyStart - data);
+    headerDone = true;
+    data = pending.data();
+    end = data + pending.size();
+  }
+
+  if(final) {
+    const char *bodyEnd = find_body_end(data, end);
+    if(unlikely(bodyEnd == nullptr))
+      mode = STREAM_FAILED;
+    else
+      scanChunk(bodyEnd);
+    return;
+  }
+
+  // collect some data first to not create too many small chunks
+  const size_t minChunkSize = 1024 * 1024;
+  if(pending.size() < minChunkSize)
+    return;
+
+  // the first half is complete at least, the element at the end may not
+  const char *stop = find_object_start(data + pending.size() / 2, end);
+  if(stop != end)
+    scanChunk(stop);
+}
+
+void
+stream_scanner::feed(const char *data, size_t len)
+{
+  switch(mode) {
+  case STREAM_FAILED:
+    return;
+  case STREAM_DETECT:
+    pending.append(data, len);
+    if(pending.size() < 3)
+      return;
+    if(check_gzip(pending.data(), pending.size())) {
+      if(unlikely(inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)) {
+        mode = STREAM_FAILED;
+        return;
+      }
+      mode = STREAM_GZIP;
+      const std::string compressed = pending;
+      pending.clear();
+      inflateData(compressed.data(), compressed.size());
+    } else {
+      mode = STREAM_PLAIN;
+    }
+    break;
+  case STREAM_PLAIN:
+    pending.append(data, len);
+    break;
+  case STREAM_GZIP:
+    inflateData(data, len);
+    break;
+  }
+
+  if(likely(mode != STREAM_FAILED))
+    scan(false);
+}
+
+osm_t *
+stream_scanner::finish()
+{
+  if(mode == STREAM_DETECT)
+    mode = STREAM_PLAIN;
+  if(likely(mode != STREAM_FAILED))
+    scan(true);
+  if(unlikely(mode == STREAM_FAILED))
+    return nullptr;
+
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  osm->uploadPolicy = policy;
+  if(bounds)
+    osm->bounds = *bounds;
+
+  if(unlikely(!build_chunks(osm, static_cast<bool>(bounds), chunks)))
+    return nullptr;
+  chunks.clear();
+
+  std::for_each(osm->relations.begin(), osm->relations.end(), relation_ref_functor(osm));
+
+  return osm.release();
+}
+
+#if __cplusplus >= 201103L
+/**
+ * @brief inflates a gzip compressed file in a background thread
+ *
+ * The data is inflated into a ring of buffers ahead of the consumer, so
+ * decompression and parsing run in parallel.
+ */
+class gzip_read_ahead {
+  enum {
+    BUFFER_COUNT = 4,
+    BUFFER_SIZE = 1024 * 1024
+  };
+
+  const char * const data;
+  const size_t length;
+  std::string buffers[BUFFER_COUNT];
+  size_t produced; ///< number of buffers filled by the worker
+  size_t consumed; ///< number of buffers given back by the consumer
+  bool holding;    ///< if the consumer is using the buffer at consumed
+  bool finished;
+  bool cancel;
+  bool failed;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::thread worker;
+
+  void run();
+  bool fill(z_stream &zs, std::string &buf, bool &streamEnd);
+
+public:
+  gzip_read_ahead(const char *d, size_t len);
+  gzip_read_ahead() O2G_DELETED_FUNCTION;
+  gzip_read_ahead(const gzip_read_ahead &) O2G_DELETED_FUNCTION;
+  gzip_read_ahead &operator=(const gzip_read_ahead &) O2G_DELETED_FUNCTION;
+  ~gzip_read_ahead();
+
+  /**
+   * @brief get the next piece of inflated data
+   * @returns the data or nullptr once everything was read
+   *
+   * The returned buffer is valid until the next call.
+   */
+  const std::string *next();
+
+  inline bool ok()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !failed;
+  }
+};
+
+gzip_read_ahead::gzip_read_ahead(const char *d, size_t len)
+  : data(d), length(len), produced(0), consumed(0), holding(false)
+  , finished(false), cancel(false), failed(false)
+{
+  worker = std::thread(&gzip_read_ahead::run, this);
+}
+
+gzip_read_ahead::~gzip_read_ahead()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancel = true;
+  }
+  cond.notify_all();
+  worker.join();
+}
+
+/**
+ * @brief inflate into the given buffer until it is full or the data ends
+ * @returns false if the data is invalid or truncated
+ */
+bool
+gzip_read_ahead::fill(z_stream &zs, std::string &buf, bool &streamEnd)
+{
+  buf.resize(BUFFER_SIZE);
+  zs.next_out = reinterpret_cast<Bytef *>(&buf[0]);
+  zs.avail_out = buf.size();
+
+  bool ret = true;
+  while(zs.avail_out > 0) {
+    const int zret = inflate(&zs, Z_NO_FLUSH);
+    if(zret == Z_STREAM_END) {
+      if(zs.avail_in == 0) {
+        streamEnd = true;
+        break;
+      }
+      // files may consist of several concatenated gzip members
+      if(unlikely(inflateReset(&zs) != Z_OK)) {
+        ret = false;
+        break;
+      }
+    } else if(unlikely(zret != Z_OK || zs.avail_in == 0)) {
+      // the input ended without the end of the stream
+      ret = false;
+      break;
+    }
+  }
+
+  buf.resize(buf.size() - zs.avail_out);
+  return ret;
+}
+
+void
+gzip_read_ahead::run()
+{
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  bool ok = inflateInit2(&zs, 16 + MAX_WBITS) == Z_OK;
+  zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  zs.avail_in = length;
+
+  bool streamEnd = false;
+  while(ok && !streamEnd) {
+    std::string *buf;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this]() { return cancel || produced - consumed < BUFFER_COUNT; });
+      if(cancel)
+        break;
+      buf = &buffers[produced % BUFFER_COUNT];
+    }
+
+    // the buffer is not visible to the consumer until produced is increased
+    ok = fill(zs, *buf, streamEnd);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(!buf->empty())
+        produced++;
+    }
+    cond.notify_all();
+  }
+
+  inflateEnd(&zs);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    failed = !ok;
+  }
+  cond.notify_all();
+}
+
+const std::string *
+gzip_read_ahead::next()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if(holding) {
+    consumed++;
+    holding = false;
+    cond.notify_all();
+  }
+
+  cond.wait(lock, [this]() { return finished || produced > consumed; });
+  if(produced == consumed)
+    return nullptr;
+
+  holding = true;
+  return &buffers[consumed % BUFFER_COUNT];
+}
+#endif
+
+/**
+ * @brief parse a gzip compressed OSM file
+ * @returns the parsed data or nullptr if the libxml parser should be tried
+ */
+osm_t *
+scan_gzip(const char *data, size_t len)
+{
+  stream_scanner scanner;
+
+#if __cplusplus >= 201103L
+  gzip_read_ahead reader(data, len);
+  const std::string *buf;
+  while((buf = reader.next()) != nullptr)
+    scanner.feed(buf->data(), buf->size());
+
+  if(unlikely(!reader.ok()))
+    return nullptr;
+#else
+  // the scanner inflates the data itself
+  const size_t step = 1024 * 1024;
+  for(size_t pos = 0; pos < len; pos += step)
+    scanner.feed(data + pos, std::min(step, len - pos));
+#endif
+
+  return scanner.finish();
+}
+
+osm_t *
+process_file(const std::string &filename)
+{
+  std::unique_ptr<osm_t> osm;
+
+  osm2go_platform::MappedFile osmData(filename);
+  if(unlikely(osmData && check_pbf(osmData.data(), osmData.length()))) {
+    osm.reset(scan_pbf(osmData.data(), osmData.length()));
+    if(unlikely(!osm)) {
+      fprintf(stderr, "Unable to read PBF file %s\n", filename.c_str());
+      return nullptr;
+    }
+  } else if(likely(osmData)) {
+    if(check_gzip(osmData.data(), osmData.length()))
+      osm.reset(scan_gzip(osmData.data(), osmData.length()));
+    else
+      osm.reset(scan_osm(osmData.data(), osmData.length()));
+    if(unlikely(!osm))
+      printf("falling back to libxml parser for %s\n", filename.c_str());
+  }
+  osmData.reset();
+
+  if(unlikely(!osm)) {
+    xmlTextReaderPtr reader = xmlReaderForFile(filename.c_str(), nullptr, XML_PARSE_NONET);
+    if (likely(reader != nullptr)) {
+      if(likely(xmlTextReaderRead(reader) == 1)) {
+        const char *name = reinterpret_cast<const char *>(xmlTextReaderConstName(reader));
+        if(likely(name && strcmp(name, "osm") == 0))
+          osm.reset(process_osm(reader));
+      } else
+        printf("file empty\n");
+
+      xmlFreeTextReader(reader);
+    } else {
+      fprintf(stderr, "Unable to open %s\n", filename.c_str());
+    }
+  }
+
+  // relations may have references to other relation, which have greater ids
+  // those are not present when the relation itself was created, but may be now
+  if(likely(osm))
+    std::for_each(osm->relations.begin(), osm->relations.end(), relation_ref_functor(osm));
+
+  return osm.release();
+}
+
+} // namespace
+
+/* ----------------------- end of stream parser ------------------- */
+
+osm_stream_parser *osm_stream_parser::create()
+{
+  return new stream_scanner();
+}
 
 osm_t *osm_t::parse(const std::string &path, const std::string &filename) {
 
@@ -0,0 +1,587 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Rolf Eike Beer <eike@sf-mail.de>
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+/**
+ * @file osm_snapshot.cpp
+ *
+ * A binary copy of the parsed OSM data, so projects can be opened without
+ * parsing the XML file again.
+ *
+ * All references between objects are stored as indexes into the tables of
+ * the snapshot, and all strings are stored only once. The data is written in
+ * host byte order, a snapshot from a different machine is simply ignored.
+ */
+
+#include "osm.h"
+#include "osm_p.h"
+
+#include "osm_objects.h"
+#include "pos.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "osm2go_annotations.h"
+#include <osm2go_cpp.h>
+#include <osm2go_platform.h>
+
+namespace {
+
+const char snapshot_magic[8] = "O2GSNAP";
+/// increase whenever the format changes
+const uint32_t snapshot_version = 1;
+const uint32_t snapshot_byte_order = 0x01020304;
+const uint32_t no_index = ~static_cast<uint32_t>(0);
+
+struct source_stamp {
+  uint64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+};
+
+bool
+stamp_file(const std::string &fname, source_stamp &stamp)
+{
+  struct stat st;
+  if(unlikely(stat(fname.c_str(), &st) != 0))
+    return false;
+
+  stamp.size = st.st_size;
+  stamp.mtime_sec = st.st_mtim.tv_sec;
+  stamp.mtime_nsec = st.st_mtim.tv_nsec;
+  return true;
+}
+
+class snapshot_writer {
+public:
+  std::string data;
+  std::string strings; ///< the string table, written in front of data
+  uint32_t stringCount;
+
+  std::unordered_map<const char *, uint32_t> stringIndex;
+  std::map<std::vector<std::pair<const char *, const char *> >, uint32_t> tagListIndex;
+  std::vector<const std::vector<std::pair<const char *, const char *> > *> tagLists;
+
+  std::unordered_map<const node_t *, uint32_t> nodeIndex;
+  std::unordered_map<const way_t *, uint32_t> wayIndex;
+  std::unordered_map<const relation_t *, uint32_t> relationIndex;
+
+  snapshot_writer() : stringCount(0) {}
+
+  template<typename T>
+  inline void put(T v)
+  {
+    data.append(reinterpret_cast<const char *>(&v), sizeof(v));
+  }
+
+  /**
+   * @brief get the index of the string in the string table
+   *
+   * The strings are from the value cache, so the same content always has
+   * the same pointer.
+   */
+  uint32_t string(const char *s)
+  {
+    if(s == nullptr)
+      return no_index;
+
+    const std::pair<std::unordered_map<const char *, uint32_t>::iterator, bool> ins =
+        stringIndex.insert(std::make_pair(s, stringCount));
+    if(ins.second) {
+      const uint32_t len = strlen(s);
+      strings.append(reinterpret_cast<const char *>(&len), sizeof(len));
+      strings.append(s, len + 1);
+      stringCount++;
+    }
+
+    return ins.first->second;
+  }
+
+  uint32_t tagList(const tag_list_t &tags);
+
+  void attributes(const base_object_t *obj)
+  {
+    put<int64_t>(obj->id);
+    put<int64_t>(obj->time);
+    put<int32_t>(obj->user);
+    put<uint32_t>(obj->version);
+    put<uint32_t>(tagList(obj->tags));
+  }
+
+  void operator()(const std::pair<item_id_t, node_t *> &pair)
+  {
+    const node_t * const node = pair.second;
+    const uint32_t idx = nodeIndex.size();
+    nodeIndex[node] = idx;
+    attributes(node);
+    put<int32_t>(node->pos.ilat);
+    put<int32_t>(node->pos.ilon);
+    put<int32_t>(node->lpos.x);
+    put<int32_t>(node->lpos.y);
+  }
+
+  void operator()(const std::pair<item_id_t, way_t *> &pair)
+  {
+    const way_t * const way = pair.second;
+    const uint32_t idx = wayIndex.size();
+    wayIndex[way] = idx;
+    attributes(way);
+    put<uint32_t>(way->node_chain.size());
+    const node_chain_t::const_iterator itEnd = way->node_chain.end();
+    for(node_chain_t::const_iterator it = way->node_chain.begin(); it != itEnd; it++)
+      put<uint32_t>(nodeIndex.at(*it));
+  }
+
+  void operator()(const std::pair<item_id_t, relation_t *> &pair)
+  {
+    const uint32_t idx = relationIndex.size();
+    relationIndex[pair.second] = idx;
+    attributes(pair.second);
+  }
+
+  void members(const relation_t *relation);
+};
+
+struct collect_tag {
+  std::vector<std::pair<const char *, const char *> > &tags;
+  explicit inline collect_tag(std::vector<std::pair<const char *, const char *> > &t) : tags(t) {}
+  inline void operator()(const tag_t &tag)
+  { tags.push_back(std::make_pair(tag.key, tag.value)); }
+};
+
+uint32_t
+snapshot_writer::tagList(const tag_list_t &tags)
+{
+  if(tags.empty())
+    return no_index;
+
+  std::vector<std::pair<const char *, const char *> > list;
+  tags.for_each(collect_tag(list));
+
+  const std::pair<std::map<std::vector<std::pair<const char *, const char *> >, uint32_t>::iterator, bool> ins =
+      tagListIndex.insert(std::make_pair(list, static_cast<uint32_t>(tagLists.size())));
+  if(ins.second)
+    tagLists.push_back(&ins.first->first);
+
+  return ins.first->second;
+}
+
+void
+snapshot_writer::members(const relation_t *relation)
+{
+  put<uint32_t>(relation->members.size());
+  const std::vector<member_t>::const_iterator itEnd = relation->members.end();
+  for(std::vector<member_t>::const_iterator it = relation->members.begin(); it != itEnd; it++) {
+    put<uint8_t>(it->object.type);
+    switch(it->object.type) {
+    case object_t::NODE:
+      put<uint32_t>(nodeIndex.at(static_cast<node_t *>(it->object)));
+      break;
+    case object_t::WAY:
+      put<uint32_t>(wayIndex.at(static_cast<way_t *>(it->object)));
+      break;
+    case object_t::RELATION:
+      put<uint32_t>(relationIndex.at(static_cast<relation_t *>(it->object)));
+      break;
+    default:
+      put<int64_t>(it->object.get_id());
+      break;
+    }
+    put<uint32_t>(string(it->role));
+  }
+}
+
+class snapshot_reader {
+  const char *pos;
+  const char * const end;
+
+public:
+  bool ok;
+
+  inline snapshot_reader(const char *data, size_t len)
+    : pos(data), end(data + len), ok(true) {}
+
+  template<typename T>
+  T get()
+  {
+    T ret = T();
+    if(unlikely(static_cast<size_t>(end - pos) < sizeof(ret))) {
+      ok = false;
+      return ret;
+    }
+    memcpy(&ret, pos, sizeof(ret));
+    pos += sizeof(ret);
+    return ret;
+  }
+
+  /**
+   * @brief read a string stored inside the snapshot
+   * @returns the NUL terminated string inside the mapped data
+   */
+  const char *string()
+  {
+    const uint32_t len = get<uint32_t>();
+    if(unlikely(!ok || static_cast<size_t>(end - pos) <= len || pos[len] != '\0')) {
+      ok = false;
+      return nullptr;
+    }
+    const char *ret = pos;
+    pos += len + 1;
+    return ret;
+  }
+
+  inline bool atEnd() const
+  { return pos == end; }
+};
+
+class snapshot_loader {
+  snapshot_reader &reader;
+  osm_t::ref osm;
+  std::vector<const char *> strings;
+  std::vector<std::vector<tag_t> > tagLists;
+  std::vector<node_t *> nodes;
+  std::vector<way_t *> ways;
+  std::vector<relation_t *> relations;
+
+  template<typename T>
+  T *index(const std::vector<T *> &v)
+  {
+    const uint32_t idx = reader.get<uint32_t>();
+    if(unlikely(idx >= v.size())) {
+      reader.ok = false;
+      return nullptr;
+    }
+    return v[idx];
+  }
+
+  const char *string(bool allowNull)
+  {
+    const uint32_t idx = reader.get<uint32_t>();
+    if(idx == no_index && allowNull)
+      return nullptr;
+    if(unlikely(idx >= strings.size())) {
+      reader.ok = false;
+      return nullptr;
+    }
+    return strings[idx];
+  }
+
+  base_attributes attributes(std::vector<tag_t> &tags);
+
+public:
+  inline snapshot_loader(snapshot_reader &r, osm_t::ref o)
+    : reader(r), osm(o) {}
+
+  bool load();
+};
+
+base_attributes
+snapshot_loader::attributes(std::vector<tag_t> &tags)
+{
+  base_attributes ret;
+  ret.id = reader.get<int64_t>();
+  ret.time = reader.get<int64_t>();
+  ret.user = reader.get<int32_t>();
+  ret.version = reader.get<uint32_t>();
+
+  tags.clear();
+  const uint32_t tl = reader.get<uint32_t>();
+  if(tl != no_index) {
+    if(unlikely(tl >= tagLists.size()))
+      reader.ok = false;
+    else
+      tags = tagLists[tl];
+  }
+
+  // the consistency checks of the objects must not trigger on broken input
+  if(unlikely((ret.version == 0) != (ret.id <= ID_ILLEGAL)))
+    reader.ok = false;
+
+  return ret;
+}
+
+bool
+snapshot_loader::load()
+{
+  osm->uploadPolicy = static_cast<osm_t::UploadPolicy>(reader.get<uint32_t>());
+  osm->bounds.ll.min.lat = reader.get<double>();
+  osm->bounds.ll.min.lon = reader.get<double>();
+  osm->bounds.ll.max.lat = reader.get<double>();
+  osm->bounds.ll.max.lon = reader.get<double>();
+  osm->bounds.min.x = reader.get<int32_t>();
+  osm->bounds.min.y = reader.get<int32_t>();
+  osm->bounds.max.x = reader.get<int32_t>();
+  osm->bounds.max.y = reader.get<int32_t>();
+  osm->bounds.center.x = reader.get<int32_t>();
+  osm->bounds.center.y = reader.get<int32_t>();
+  osm->bounds.scale = reader.get<float>();
+
+  const uint32_t userCount = reader.get<uint32_t>();
+  for(uint32_t i = 0; reader.ok && i < userCount; i++) {
+    const int uid = reader.get<int32_t>();
+    const char *name = reader.string();
+    if(likely(reader.ok))
+      osm->users[uid] = name;
+  }
+
+  strings.resize(reader.get<uint32_t>());
+  for(size_t i = 0; reader.ok && i < strings.size(); i++)
+    // the value cache only makes a copy if the string is not already known
+    strings[i] = value_cache.insert(reader.string());
+
+  tagLists.resize(reader.get<uint32_t>());
+  for(size_t i = 0; reader.ok && i < tagLists.size(); i++) {
+    const uint32_t count = reader.get<uint32_t>();
+    for(uint32_t j = 0; reader.ok && j < count; j++) {
+      const char *k = string(false);
+      const char *v = string(false);
+      // both are already in the value cache
+      if(likely(reader.ok))
+        tagLists[i].push_back(tag_t::uncached(k, v));
+    }
+  }
+
+  std::vector<tag_t> tags;
+
+  const uint32_t nodeCount = reader.get<uint32_t>();
+  nodes.reserve(nodeCount);
+  for(uint32_t i = 0; reader.ok && i < nodeCount; i++) {
+    const base_attributes ba = attributes(tags);
+    pos_fixed_t pos;
+    pos.ilat = reader.get<int32_t>();
+    pos.ilon = reader.get<int32_t>();
+    lpos_t lpos;
+    lpos.x = reader.get<int32_t>();
+    lpos.y = reader.get<int32_t>();
+    if(unlikely(!reader.ok))
+      break;
+
+    node_t *node = new(osm->pools.nodes) node_t(ba, lpos, pos);
+    node->tags.replace(std::move(tags));
+    osm->insert(node);
+    nodes.push_back(node);
+  }
+
+  const uint32_t wayCount = reader.get<uint32_t>();
+  for(uint32_t i = 0; reader.ok && i < wayCount; i++) {
+    const base_attributes ba = attributes(tags);
+    const uint32_t count = reader.get<uint32_t>();
+    if(unlikely(!reader.ok))
+      break;
+
+    std::unique_ptr<way_t> way(new(osm->pools.ways) way_t(ba));
+    way->node_chain.reserve(count);
+    for(uint32_t j = 0; reader.ok && j < count; j++) {
+      node_t *node = index(nodes);
+      if(likely(node != nullptr)) {
+        node->ways++;
+        way->node_chain.push_back(node);
+      }
+    }
+    if(unlikely(!reader.ok))
+      break;
+
+    way->tags.replace(std::move(tags));
+    osm->insert(way.get());
+    ways.push_back(way.release());
+  }
+
+  // all relations must exist before the members can be resolved
+  const uint32_t relationCount = reader.get<uint32_t>();
+  std::vector<std::unique_ptr<relation_t> > nrelations;
+  for(uint32_t i = 0; reader.ok && i < relationCount; i++) {
+    const base_attributes ba = attributes(tags);
+    if(unlikely(!reader.ok))
+      break;
+
+    nrelations.push_back(std::unique_ptr<relation_t>(new(osm->pools.relations) relation_t(ba)));
+    nrelations.back()->tags.replace(std::move(tags));
+    relations.push_back(nrelations.back().get());
+  }
+
+  for(uint32_t i = 0; reader.ok && i < nrelations.size(); i++) {
+    relation_t * const relation = nrelations[i].get();
+    const uint32_t count = reader.get<uint32_t>();
+    relation->members.reserve(count);
+    for(uint32_t j = 0; reader.ok && j < count; j++) {
+      const object_t::type_t type = static_cast<object_t::type_t>(reader.get<uint8_t>());
+      object_t obj;
+      switch(type) {
+      case object_t::NODE:
+        obj = object_t(index(nodes));
+        break;
+      case object_t::WAY:
+        obj = object_t(index(ways));
+        break;
+      case object_t::RELATION:
+        obj = object_t(index(relations));
+        break;
+      case object_t::NODE_ID:
+      case object_t::WAY_ID:
+      case object_t::RELATION_ID:
+        obj = object_t(type, reader.get<int64_t>());
+        break;
+      default:
+        reader.ok = false;
+        break;
+      }
+      const char *role = string(true);
+      if(likely(reader.ok))
+        relation->members.push_back(member_t(obj, role));
+    }
+  }
+
+  if(unlikely(!reader.ok || !reader.atEnd()))
+    return false;
+
+  for(size_t i = 0; i < nrelations.size(); i++)
+    osm->insert(nrelations[i].release());
+
+  return true;
+}
+
+} // namespace
+
+bool osm_t::saveSnapshot(const std::string &snapshot, const std::string &source) const
+{
+  source_stamp stamp;
+  if(unlikely(!stamp_file(source, stamp)))
+    return false;
+
+  snapshot_writer writer;
+
+  writer.put<uint32_t>(uploadPolicy);
+  writer.put<double>(bounds.ll.min.lat);
+  writer.put<double>(bounds.ll.min.lon);
+  writer.put<double>(bounds.ll.max.lat);
+  writer.put<double>(bounds.ll.max.lon);
+  writer.put<int32_t>(bounds.min.x);
+  writer.put<int32_t>(bounds.min.y);
+  writer.put<int32_t>(bounds.max.x);
+  writer.put<int32_t>(bounds.max.y);
+  writer.put<int32_t>(bounds.center.x);
+  writer.put<int32_t>(bounds.center.y);
+  writer.put<float>(bounds.scale);
+
+  writer.put<uint32_t>(users.size());
+  const std::map<int, std::string>::const_iterator uitEnd = users.end();
+  for(std::map<int, std::string>::const_iterator it = users.begin(); it != uitEnd; it++) {
+    writer.put<int32_t>(it->first);
+    writer.put<uint32_t>(it->second.size());
+    writer.data.append(it->second.c_str(), it->second.size() + 1);
+  }
+
+  // the objects are written to a separate buffer first, they fill the string table
+  std::string header;
+  header.swap(writer.data);
+
+  writer.put<uint32_t>(nodes.size());
+  std::for_each(nodes.begin(), nodes.end(), std::ref(writer));
+  writer.put<uint32_t>(ways.size());
+  std::for_each(ways.begin(), ways.end(), std::ref(writer));
+  writer.put<uint32_t>(relations.size());
+  std::for_each(relations.begin(), relations.end(), std::ref(writer));
+  const object_map<relation_t>::const_iterator ritEnd = relations.end();
+  for(object_map<relation_t>::const_iterator it = relations.begin(); it != ritEnd; it++)
+    writer.members(it->second);
+
+  std::string objects;
+  objects.swap(writer.data);
+
+  writer.put<uint32_t>(writer.tagLists.size());
+  for(size_t i = 0; i < writer.tagLists.size(); i++) {
+    const std::vector<std::pair<const char *, const char *> > &list = *writer.tagLists[i];
+    writer.put<uint32_t>(list.size());
+    for(size_t j = 0; j < list.size(); j++) {
+      writer.put<uint32_t>(writer.string(list[j].first));
+      writer.put<uint32_t>(writer.string(list[j].second));
+    }
+  }
+
+  std::string tables;
+  tables.swap(writer.data);
+
+  writer.data.append(snapshot_magic, sizeof(snapshot_magic));
+  writer.put<uint32_t>(snapshot_version);
+  writer.put<uint32_t>(snapshot_byte_order);
+  writer.put<uint64_t>(stamp.size);
+  writer.put<int64_t>(stamp.mtime_sec);
+  writer.put<int64_t>(stamp.mtime_nsec);
+
+  const std::string tmpname = snapshot + ".tmp";
+  FILE *f = fopen(tmpname.c_str(), "wb");
+  if(unlikely(f == nullptr)) {
+    printf("unable to write snapshot %s\n", tmpname.c_str());
+    return false;
+  }
+
+  const uint32_t stringCount = writer.stringCount;
+  bool ret = fwrite(writer.data.data(), 1, writer.data.size(), f) == writer.data.size() &&
+             fwrite(header.data(), 1, header.size(), f) == header.size() &&
+             fwrite(&stringCount, sizeof(stringCount), 1, f) == 1 &&
+             fwrite(writer.strings.data(), 1, writer.strings.size(), f) == writer.strings.size() &&
+             fwrite(tables.data(), 1, tables.size(), f) == tables.size() &&
+             fwrite(objects.data(), 1, objects.size(), f) == objects.size();
+  ret = (fclose(f) == 0) && ret;
+
+  if(likely(ret))
+    ret = rename(tmpname.c_str(), snapshot.c_str()) == 0;
+  if(unlikely(!ret)) {
+    printf("unable to write snapshot %s\n", snapshot.c_str());
+    unlink(tmpname.c_str());
+  }
+
+  return ret;
+}
+
+osm_t *osm_t::loadSnapshot(const std::string &snapshot, const std::string &source)
+{
+  source_stamp stamp;
+  if(unlikely(!stamp_file(source, stamp)))
+    return nullptr;
+
+  osm2go_platform::MappedFile map(snapshot);
+  if(!map)
+    return nullptr;
+
+  snapshot_reader reader(map.data(), map.length());
+
+  char magic[sizeof(snapshot_magic)];
+  for(size_t i = 0; i < sizeof(magic); i++)
+    magic[i] = reader.get<char>();
+  if(memcmp(magic, snapshot_magic, sizeof(magic)) != 0 ||
+     reader.get<uint32_t>() != snapshot_version ||
+     reader.get<uint32_t>() != snapshot_byte_order) {
+    printf("ignoring snapshot %s in unknown format\n", snapshot.c_str());
+    return nullptr;
+  }
+
+  if(reader.get<uint64_t>() != stamp.size ||
+     reader.get<int64_t>() != stamp.mtime_sec ||
+     reader.get<int64_t>() != stamp.mtime_nsec) {
+    printf("snapshot %s is outdated\n", snapshot.c_str());
+    return nullptr;
+  }
+
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  if(unlikely(!snapshot_loader(reader, osm).load())) {
+    printf("snapshot %s is damaged\n", snapshot.c_str());
+    return nullptr;
+  }
+
+  return osm.release();
+}
@@ -7,18 +7,7 @@
 /**
  * @file canvas_goocanvas.cpp
  *
- * this file contains the canvas functions specific to GooCanvas. It also
- * contains e.g. a canvas agnostic way of detecting which items are at a
- * certain position. This is required for some canvas that don't provide this
- * function
- *
- * This also allows for a less precise item selection and especially
- * to differentiate between the clicks on a polygon border and its
- * interior
- *
- * References:
- * https://en.wikipedia.org/wiki/Point_in_polygon
- * https://www.visibone.com/inpoly/
+ * this file contains the canvas functions specific to GooCanvas.
  */
 
 #include "canvas_goocanvas.h"
@@ -311,137 +300,6 @@ void canvas_t::erase(unsigned int group_mask) {
   }
 }
 
-namespace {
-
-/* check whether a given point is inside a polygon */
-/* inpoly() taken from https://www.visibone.com/inpoly/ */
-bool
-inpoly(const canvas_item_info_poly *poly, int x, int y, int fuzziness)
-{
-  if(poly->num_points < 3)
-    return false;
-
-  lpos_t oldPos = poly->points[poly->num_points - 1];
-  bool inside = false;
-
-  for (unsigned i = 0 ; i < poly->num_points ; i++) {
-    float x1, y1, x2, y2;
-    lpos_t newPos = poly->points[i];
-
-    // in contrast to the original algorithm we want to consider the corners as always inside the polygon
-    float dist_sq = (x - newPos.x) * (x - newPos.x) + (y - newPos.y) * (y - newPos.y);
-    if (dist_sq < fuzziness * fuzziness)
-      return true;
-
-    if (newPos.x > oldPos.x) {
-      x1 = oldPos.x;
-      x2 = newPos.x;
-      y1 = oldPos.y;
-      y2 = newPos.y;
-    } else {
-      x1 = newPos.x;
-      x2 = oldPos.x;
-      y1 = newPos.y;
-      y2 = oldPos.y;
-    }
-    if ((newPos.x < x) == (x <= oldPos.x)          /* edge "open" at one end */
-        && (y - y1) * (x2 - x1) < (y2 - y1) * (x - x1))
-      inside = !inside;
-
-    oldPos = newPos;
-  }
-
-  return inside;
-}
-
-class item_at_functor {
-  const int x;
-  const int y;
-  const float ffuzziness;
-public:
-  const int fuzziness;
-  const canvas_t * const canvas;
-  inline item_at_functor(const lpos_t pos, float f, const canvas_t *cv)
-    : x(pos.x), y(pos.y), ffuzziness(f), fuzziness(f), canvas(cv) {}
-  bool operator()(const canvas_item_info_t *item) const;
-};
-
-bool item_at_functor::operator()(const canvas_item_info_t *item) const
-{
-  switch(item->type) {
-  case CANVAS_ITEM_CIRCLE: {
-    const canvas_item_info_circle *circle = static_cast<const canvas_item_info_circle *>(item);
-    int xdist = circle->center.x - x;
-    int ydist = circle->center.y - y;
-    return (xdist * xdist + ydist * ydist <
-           (static_cast<int>(circle->radius) + fuzziness) * (static_cast<int>(circle->radius) + fuzziness));
-  }
-
-  case CANVAS_ITEM_POLY: {
-    const canvas_item_info_poly *poly = static_cast<const canvas_item_info_poly *>(item);
-    return poly->get_segment(x, y, ffuzziness) || (poly->is_polygon && inpoly(poly, x, y, fuzziness));
-  }
-  }
-  assert_unreachable();
-}
-
-gint
-item_at_compare(gconstpointer i, gconstpointer f)
-{
-  const item_at_functor &fc = *static_cast<const item_at_functor *>(f);
-  const canvas_item_t * const citem = static_cast<const canvas_item_t *>(i);
-
-  const canvas_t::item_mapping_t::const_iterator it = fc.canvas->item_mapping.find(citem);
-  if(it == fc.canvas->item_mapping.end()) {
-    g_debug("item %p not in canvas map", citem);
-    return -1;
-  }
-
-  return fc(it->second) ? 0 : -1;
-}
-
-struct g_list_deleter {
-  inline void operator()(GList *list)
-  { g_list_free(list); }
-};
-
-} // namespace
-
-/* try to find the object at position x/y by searching through the */
-/* item_info list */
-canvas_item_t *canvas_t::get_item_at(lpos_t pos) const {
-  /* convert all "fuzziness" into meters */
-  const float fuzziness = EXTRA_FUZZINESS_METER +
-    EXTRA_FUZZINESS_PIXEL / get_zoom();
-
-  const item_at_functor fc(pos, fuzziness, this);
-  GooCanvasBounds find_bounds;
-  find_bounds.x1 = pos.x - fc.fuzziness;
-  find_bounds.y1 = pos.y - fc.fuzziness;
-  find_bounds.x2 = pos.x + fc.fuzziness;
-  find_bounds.y2 = pos.y + fc.fuzziness;
-  std::unique_ptr<GList, g_list_deleter> items(goo_canvas_get_items_in_area(GOO_CANVAS(widget),
-                                                                            &find_bounds, TRUE,
-                                                                            TRUE, FALSE));
-
-  if (!items)
-    return nullptr;
-
-  // items of all kinds and layers are returned, now select the best matching one
-  GList *item = g_list_find_custom(items.get(), &fc, item_at_compare);
-  if (item == nullptr)
-    return nullptr;
-
-  return static_cast<canvas_item_t *>(item->data);
-}
-
-canvas_item_t *canvas_t::get_next_item_at(lpos_t pos, canvas_item_t *oldtop) const
-{
-  goo_canvas_item_lower(static_cast<GooCanvasItem *>(oldtop), nullptr);
-
-  return get_item_at(pos);
-}
-
 canvas_item_circle *canvas_t::circle_new(canvas_group_t group, lpos_t c,
                                     float radius, int border,
                                     color_t fill_col, color_t border_col) {
@@ -454,7 +312,7 @@ canvas_item_circle *canvas_t::circle_new(canvas_group_t group, lpos_t c,
                            nullptr);
 
   if(CANVAS_SELECTABLE & (1<<group))
-    (void) new canvas_item_info_circle(this, item, c, static_cast<unsigned int>(radius) + border);
+    (void) new canvas_item_info_circle(this, group, item, c, static_cast<unsigned int>(radius) + border);
 
   return static_cast<canvas_item_circle *>(item);
 }
@@ -499,7 +357,7 @@ canvas_item_polyline *canvas_t::polyline_new(canvas_group_t group, const std::ve
                             nullptr);
 
   if(CANVAS_SELECTABLE & (1<<group))
-    (void) new canvas_item_info_poly(this, item, false, width, points);
+    (void) new canvas_item_info_poly(this, group, item, false, width, points);
 
   return static_cast<canvas_item_polyline *>(item);
 }
@@ -519,11 +377,42 @@ canvas_item_t *canvas_t::polygon_new(canvas_group_t group, const std::vector<lpo
                             nullptr);
 
   if(CANVAS_SELECTABLE & (1<<group))
-    (void) new canvas_item_info_poly(this, item, true, width, points);
+    (void) new canvas_item_info_poly(this, group, item, true, width, points);
 
   return item;
 }
 
+void canvas_t::poly_batch_new(canvas_group_t group, const std::vector<canvas_poly_t> &polys,
+                              std::vector<canvas_item_t *> &items)
+{
+  // there is no bulk insertion in goocanvas, but it already collects the
+  // update requests of the new items and handles them at once on the next
+  // redraw, so only the bookkeeping is prepared here
+  items.reserve(items.size() + polys.size());
+  if(CANVAS_SELECTABLE & (1 << group))
+    item_mapping.reserve(item_mapping.size() + polys.size());
+
+  const std::vector<canvas_poly_t>::const_iterator itEnd = polys.end();
+  for(std::vector<canvas_poly_t>::const_iterator it = polys.begin(); it != itEnd; it++) {
+    if(it->polygon)
+      items.push_back(polygon_new(group, it->points, it->width, it->color, it->fill));
+    else
+      items.push_back(polyline_new(group, it->points, it->width, it->color));
+  }
+}
+
+void canvas_t::circle_batch_new(canvas_group_t group, const std::vector<canvas_circle_t> &circles,
+                                std::vector<canvas_item_circle *> &items)
+{
+  items.reserve(items.size() + circles.size());
+  if(CANVAS_SELECTABLE & (1 << group))
+    item_mapping.reserve(item_mapping.size() + circles.size());
+
+  const std::vector<canvas_circle_t>::const_iterator itEnd = circles.end();
+  for(std::vector<canvas_circle_t>::const_iterator it = circles.begin(); it != itEnd; it++)
+    items.push_back(circle_new(group, it->center, it->radius, it->border, it->fill, it->border_color));
+}
+
 /* place the image in pix centered on x/y on the canvas */
 canvas_item_pixmap *canvas_t::image_new(canvas_group_t group, icon_item *icon, lpos_t pos,
                                         float scale)
@@ -539,7 +428,7 @@ canvas_item_pixmap *canvas_t::image_new(canvas_group_t group, icon_item *icon, l
 
   if(CANVAS_SELECTABLE & (1<<group)) {
     int radius = 0.75f * scale * std::max(width, height);
-    (void) new canvas_item_info_circle(this, item, pos, radius);
+    (void) new canvas_item_info_circle(this, group, item, pos, radius);
   }
 
   return reinterpret_cast<canvas_item_pixmap *>(item);
@@ -557,6 +446,14 @@ void canvas_item_polyline::set_points(const std::vector<lpos_t> &points) {
   g_object_set(G_OBJECT(this), "points", cpoints.get(), nullptr);
 }
 
+void canvas_item_t::set_shape(const std::vector<lpos_t> &points)
+{
+  // polygons are closed polylines in goocanvas
+  assert(GOO_IS_CANVAS_POLYLINE(this));
+  pointGuard cpoints(canvas_points_create(points));
+  g_object_set(G_OBJECT(this), "points", cpoints.get(), nullptr);
+}
+
 void
 canvas_item_circle::set_radius(float radius)
 {
@@ -566,6 +463,11 @@ canvas_item_circle::set_radius(float radius)
                nullptr);
 }
 
+void canvas_item_t::lower()
+{
+  goo_canvas_item_lower(reinterpret_cast<GooCanvasItem *>(this), nullptr);
+}
+
 void canvas_item_t::set_zoom_max(float zoom_max) {
   gdouble vis_thres = zoom_max;
   GooCanvasItemVisibility vis
@@ -619,19 +521,26 @@ void canvas_item_t::destroy_connect(canvas_item_destroyer *d)
 }
 
 bool canvas_goocanvas::isVisible(const lpos_t lpos) const
+{
+  // Is the point still onscreen?
+  lpos_t min, max;
+  visible_area(min, max);
+
+  return (lpos.x <= max.x) && (lpos.x >= min.x) &&
+         (lpos.y <= max.y) && (lpos.y >= min.y);
+}
+
+void canvas_t::visible_area(lpos_t &min, lpos_t &max) const
 {
   // Viewport dimensions in canvas space
 
   /* get size of visible area in canvas units (meters) */
-  const canvas_dimensions dim = get_viewport_dimensions();
+  const canvas_dimensions dim = static_cast<const canvas_goocanvas *>(this)->get_viewport_dimensions() / 2;
 
-  // Is the point still onscreen?
-  osm2go_platform::screenpos s = scroll_get();
+  const osm2go_platform::screenpos s = scroll_get();
 
-  return (lpos.x <= s.x() + dim.width / 2) &&
-         (lpos.x >= s.x() - dim.width / 2) &&
-         (lpos.y <= s.y() + dim.height / 2) &&
-         (lpos.y >= s.y() - dim.height / 2);
+  min = lpos_t(s.x() - dim.width, s.y() - dim.height);
+  max = lpos_t(s.x() + dim.width, s.y() + dim.height);
 }
 
 bool canvas_t::ensureVisible(const lpos_t lpos)
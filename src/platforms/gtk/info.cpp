@@ -572,7 +572,7 @@ details_widget(const info_tag_context_t &context, bool big)
   switch(context.object.type) {
   case object_t::NODE: {
     char pos_str[32];
-    const pos_t &pos = static_cast<node_t *>(context.object)->pos;
+    const pos_t pos = static_cast<node_t *>(context.object)->pos.toPos();
     pos_lat_str_deg(pos_str, sizeof(pos_str), pos.lat);
     label = gtk_label_new(pos_str);
     if(big) table_attach(table, gtk_label_new(_("Latitude:")), 0, 2);
@@ -114,19 +114,22 @@ void appdata_t::main_ui_enable() {
   set_title();
 
   iconbar->setToolbarEnable(osm_valid);
+  // disabled while a project is loaded
+  uicontrol->setActionEnable(MainUi::MENU_ITEM_PROJECT_OPEN, true);
   /* disable all menu entries related to map */
   uicontrol->setActionEnable(MainUi::SUBMENU_MAP, static_cast<bool>(project));
 
   // those icons that get enabled or disabled depending on OSM data being loaded
 #ifndef FREMANTLE
-  std::array<MainUi::menu_items, 7> osm_active_items = { {
+  std::array<MainUi::menu_items, 8> osm_active_items = { {
     MainUi::MENU_ITEM_MAP_SAVE_CHANGES,
 #else
-  std::array<MainUi::menu_items, 6> osm_active_items = { {
+  std::array<MainUi::menu_items, 7> osm_active_items = { {
 #endif
     MainUi::MENU_ITEM_MAP_UNDO_CHANGES,
     MainUi::MENU_ITEM_MAP_SHOW_CHANGES,
     MainUi::MENU_ITEM_MAP_RELATIONS,
+    MainUi::MENU_ITEM_MAP_SEARCH,
     MainUi::SUBMENU_TRACK,
     MainUi::SUBMENU_VIEW,
     MainUi::SUBMENU_WMS
@@ -202,7 +205,7 @@ cb_menu_download(appdata_t *appdata) {
 
   // download
   bool hasMap = static_cast<bool>(appdata->project->osm);
-  if(osm_download(appdata_t::window, appdata->project.get())) {
+  if(osm_download(appdata_t::window, appdata->project.get(), true)) {
     if(hasMap)
       /* redraw the entire map by destroying all map items and redrawing them */
       appdata->map->clear(map_t::MAP_LAYER_OBJECTS_ONLY);
@@ -360,6 +363,11 @@ cb_menu_osm_relations(appdata_t *appdata) {
   relation_list(appdata_t::window, appdata->map, appdata->project->osm, appdata->presets.get());
 }
 
+void
+cb_menu_osm_search(appdata_t *appdata) {
+  tag_search_dialog(appdata_t::window, appdata->map, appdata->project->osm);
+}
+
 #ifndef FREMANTLE
 void
 cb_menu_fullscreen(appdata_t *, GtkCheckMenuItem *item) {
@@ -654,9 +662,12 @@ menu_create(appdata_internal &appdata, GtkBox *mainvbox)
   GtkWidget *submenu = mainui->addMenu(_("_Project"));
   gtk_menu_set_accel_group(GTK_MENU(submenu), accel_grp);
 
+  GtkStockItem stock_item;
+  gboolean b = gtk_stock_lookup(GTK_STOCK_OPEN, &stock_item);
+  assert(b == TRUE);
   menu_append_new_item(
-    &appdata, submenu, G_CALLBACK(cb_menu_project_open), _("_Open"),
-    GTK_STOCK_OPEN, "<OSM2Go-Main>/Project/Open");
+    appdata, submenu, G_CALLBACK(cb_menu_project_open), MainUi::MENU_ITEM_PROJECT_OPEN,
+    "<OSM2Go-Main>/Project/Open", KeySequence(stock_item));
 
   gtk_menu_shell_append(GTK_MENU_SHELL(submenu),
                         gtk_separator_menu_item_new());
@@ -739,8 +750,7 @@ menu_create(appdata_internal &appdata, GtkBox *mainvbox)
 
   gtk_menu_shell_append(GTK_MENU_SHELL(submenu), gtk_separator_menu_item_new());
 
-  GtkStockItem stock_item;
-  gboolean b = gtk_stock_lookup(GTK_STOCK_SAVE, &stock_item);
+  b = gtk_stock_lookup(GTK_STOCK_SAVE, &stock_item);
   assert(b == TRUE);
   menu_append_new_item(
     appdata, submenu, G_CALLBACK(cb_menu_save_changes), MainUi::MENU_ITEM_MAP_SAVE_CHANGES,
@@ -761,6 +771,11 @@ menu_create(appdata_internal &appdata, GtkBox *mainvbox)
     "<OSM2Go-Main>/Map/Relations",
     KeySequence(GDK_r, GDK_SHIFT_MASK, GDK_CONTROL_MASK));
 
+  menu_append_new_item(
+    appdata, submenu, G_CALLBACK(cb_menu_osm_search), MainUi::MENU_ITEM_MAP_SEARCH,
+    "<OSM2Go-Main>/Map/Search",
+    KeySequence(GDK_f, GDK_CONTROL_MASK));
+
   /* -------------------- wms submenu -------------------- */
 
   submenu = mainui->addMenu(MainUi::SUBMENU_WMS);
@@ -985,12 +1000,13 @@ HildonAppMenu *
 app_menu_create(appdata_internal &appdata)
 {
   /* -- the applications main menu -- */
-  std::array<main_menu_entry_t, 7> main_menu = { {
+  std::array<main_menu_entry_t, 8> main_menu = { {
     main_menu_entry_t(_("About"),                      G_CALLBACK(about_box), appdata.uicontrol.get()),
-    main_menu_entry_t(_("Project"),                    G_CALLBACK(cb_menu_project_open), &appdata),
+    main_menu_entry_t(MainUi::MENU_ITEM_PROJECT_OPEN,  G_CALLBACK(cb_menu_project_open), &appdata),
     main_menu_entry_t(MainUi::SUBMENU_VIEW,            G_CALLBACK(on_submenu_view_clicked), &appdata),
     main_menu_entry_t(MainUi::SUBMENU_MAP,             G_CALLBACK(submenu_popup), appdata.app_menu_map.get()),
     main_menu_entry_t(MainUi::MENU_ITEM_MAP_RELATIONS, G_CALLBACK(cb_menu_osm_relations), &appdata),
+    main_menu_entry_t(MainUi::MENU_ITEM_MAP_SEARCH,    G_CALLBACK(cb_menu_osm_search), &appdata),
     main_menu_entry_t(MainUi::SUBMENU_WMS,             G_CALLBACK(submenu_popup), appdata.app_menu_wms.get()),
     main_menu_entry_t(MainUi::SUBMENU_TRACK,           G_CALLBACK(on_submenu_track_clicked), &appdata)
   } };
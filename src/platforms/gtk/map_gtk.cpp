@@ -46,6 +46,11 @@ static gboolean map_destroy_event(map_gtk *map)
   return FALSE;
 }
 
+static void map_viewport_changed(map_t *map)
+{
+  map->viewport_changed();
+}
+
 static gboolean map_scroll_event(GtkWidget *, GdkEventScroll *event, map_t *map) {
   if(unlikely(!map->appdata.project->osm))
     return FALSE;
@@ -211,6 +216,27 @@ map_gtk::map_gtk(appdata_t &a)
 
   g_signal_connect_swapped(canvas->widget, "destroy",
                            G_CALLBACK(map_destroy_event), this);
+
+  // scrolling, zooming, and resizing all change the adjustments
+  adjustments[0] = GOO_CANVAS(canvas->widget)->hadjustment;
+  adjustments[1] = GOO_CANVAS(canvas->widget)->vadjustment;
+  for(unsigned int i = 0; i < 2; i++) {
+    g_object_add_weak_pointer(G_OBJECT(adjustments[i]), reinterpret_cast<gpointer *>(adjustments + i));
+    g_signal_connect_swapped(adjustments[i], "value-changed",
+                             G_CALLBACK(map_viewport_changed), this);
+    g_signal_connect_swapped(adjustments[i], "changed",
+                             G_CALLBACK(map_viewport_changed), this);
+  }
+}
+
+map_gtk::~map_gtk()
+{
+  for(unsigned int i = 0; i < 2; i++) {
+    if(adjustments[i] == nullptr)
+      continue;
+    g_signal_handlers_disconnect_by_data(adjustments[i], this);
+    g_object_remove_weak_pointer(G_OBJECT(adjustments[i]), reinterpret_cast<gpointer *>(adjustments + i));
+  }
 }
 
 void map_gtk::set_autosave(bool enable)
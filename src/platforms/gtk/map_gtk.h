@@ -15,13 +15,14 @@
 class map_gtk : public map_t {
 public:
   explicit map_gtk(appdata_t &a);
-  inline ~map_gtk() override {}
+  ~map_gtk() override;
 
   void set_autosave(bool enable) override;
   gboolean key_press_event(unsigned int keyval);
 
 private:
   osm2go_platform::Timer autosave;
+  GtkAdjustment *adjustments[2];    ///< the scroll adjustments of the canvas, reset when they are destroyed
 
   static gboolean map_motion_notify_event(GtkWidget *, GdkEventMotion *event, map_gtk *map);
   static gboolean map_button_event(map_gtk *map, GdkEventButton *event);
@@ -29,7 +29,7 @@
 namespace {
 
 struct net_io_request_t {
-  net_io_request_t(const std::string &u, const std::string &f, bool c);
+  net_io_request_t(const std::string &u, const std::string &f, bool c, const std::shared_ptr<net_io_sink> &s);
   net_io_request_t(const std::string &u, std::string *smem) __attribute__((nonnull(3)));
 
   const std::string url;
@@ -46,6 +46,7 @@ struct net_io_request_t {
   const std::string filename;   /* used for NET_IO_DL_FILE */
   std::string * const mem;   /* used for NET_IO_DL_MEM */
   const bool use_compression;
+  const std::shared_ptr<net_io_sink> sink; /* optionally used for NET_IO_DL_FILE */
 };
 
 gint
@@ -95,7 +96,8 @@ busy_dialog(osm2go_platform::Widget *parent, GtkProgressBar *&pbar, bool *cancel
   return dialog;
 }
 
-net_io_request_t::net_io_request_t(const std::string &u, const std::string &f, bool c)
+net_io_request_t::net_io_request_t(const std::string &u, const std::string &f, bool c,
+                                   const std::shared_ptr<net_io_sink> &s)
   : url(u)
   , cancel(false)
   , download_cur(0)
@@ -105,6 +107,7 @@ net_io_request_t::net_io_request_t(const std::string &u, const std::string &f, b
   , filename(f)
   , mem(nullptr)
   , use_compression(c)
+  , sink(s)
 {
   assert(!filename.empty());
   memset(buffer, 0, sizeof(buffer));
@@ -144,6 +147,20 @@ struct f_closer {
   { fclose(f); }
 };
 
+struct file_sink_t {
+  FILE *file;
+  net_io_sink *sink;
+};
+
+size_t
+file_sink_write(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+  const file_sink_t *target = static_cast<file_sink_t *>(stream);
+  const size_t ret = fwrite(ptr, size, nmemb, target->file);
+  target->sink->write(static_cast<char *>(ptr), size * ret);
+  return ret;
+}
+
 void *worker_thread(void *ptr)
 {
   std::shared_ptr<net_io_request_t> request(*static_cast<std::shared_ptr<net_io_request_t>*>(ptr));
@@ -154,12 +171,20 @@ void *worker_thread(void *ptr)
   if(likely(curl)) {
     bool ok = false;
     std::unique_ptr<FILE, f_closer> outfile;
+    file_sink_t sinkTarget;
 
     /* prepare target (file, memory, ...) */
     if(!request->filename.empty()) {
       outfile.reset(fopen(request->filename.c_str(), "w"));
       ok = static_cast<bool>(outfile);
-      curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, outfile.get());
+      if(request->sink) {
+        sinkTarget.file = outfile.get();
+        sinkTarget.sink = request->sink.get();
+        curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, &sinkTarget);
+        curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, file_sink_write);
+      } else {
+        curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, outfile.get());
+      }
     } else {
       request->mem->clear();
       curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, request->mem);
@@ -310,9 +335,10 @@ net_io_do(osm2go_platform::Widget *parent, net_io_request_t *rq, const std::stri
 
 bool net_io_download_file(osm2go_platform::Widget *parent,
                           const std::string &url, const std::string &filename,
-                          const std::string &title, bool compress)
+                          const std::string &title, bool compress,
+                          const std::shared_ptr<net_io_sink> &sink)
 {
-  net_io_request_t *request = new net_io_request_t(url, filename, compress);
+  net_io_request_t *request = new net_io_request_t(url, filename, compress, sink);
 
   printf("net_io: download %s to file %s\n", url.c_str(), filename.c_str());
 
@@ -337,9 +363,10 @@ bool net_io_download_file(osm2go_platform::Widget *parent,
 
 bool net_io_download_file(osm2go_platform::Widget *parent,
                           const std::string &url, const std::string &filename,
-                          trstring::native_type_arg title, bool compress)
+                          trstring::native_type_arg title, bool compress,
+                          const std::shared_ptr<net_io_sink> &sink)
 {
-  return net_io_download_file(parent, url, filename, title.toStdString(), compress);
+  return net_io_download_file(parent, url, filename, title.toStdString(), compress, sink);
 }
 
 bool net_io_download_mem(osm2go_platform::Widget *parent, const std::string &url,
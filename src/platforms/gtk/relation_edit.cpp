@@ -310,7 +310,7 @@ relation_list_widget(relation_context_t &context)
 
   relation_list_widget_functor fc(context.store.get(), context.osm);
 
-  const std::map<item_id_t, relation_t *> &rchain = context.osm->relations;
+  const object_map<relation_t> &rchain = context.osm->relations;
   std::for_each(rchain.begin(), rchain.end(), fc);
 
   relation_list_selected(context.list, nullptr);
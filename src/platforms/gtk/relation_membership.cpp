@@ -199,6 +199,7 @@ relation_add_item(GtkWidget *parent, relation_t *relation, const object_t &objec
   // must be done before the widget is destroyed as it may reference the
   // internal string from the text entry
   relation->members.push_back(*change);
+  osm->addMemberRef(change->object, relation);
 
   return true;
 }
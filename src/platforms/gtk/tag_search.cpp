@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Rolf Eike Beer <eike@sf-mail.de>
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+/**
+ * @file tag_search.cpp
+ *
+ * This file contains the dialog to find all objects with a given tag.
+ */
+
+#include <object_dialogs.h>
+
+#include "list.h"
+#include <map.h>
+
+#include <cassert>
+#include <vector>
+
+#include <osm2go_annotations.h>
+#include <osm2go_cpp.h>
+#include "osm2go_i18n.h"
+#include "osm2go_platform.h"
+#include "osm2go_platform_gtk.h"
+
+namespace {
+
+struct search_context_t {
+  inline search_context_t(map_t *m, osm_t::ref o, GtkWidget *d)
+    : map(m), osm(o), dialog(d), keyEntry(nullptr), valueEntry(nullptr), list(nullptr) {}
+  search_context_t() O2G_DELETED_FUNCTION;
+  search_context_t(const search_context_t &) O2G_DELETED_FUNCTION;
+  search_context_t &operator=(const search_context_t &) O2G_DELETED_FUNCTION;
+#if __cplusplus >= 201103L
+  search_context_t(search_context_t &&) = delete;
+  search_context_t &operator=(search_context_t &&) = delete;
+  ~search_context_t() = default;
+#endif
+
+  map_t * const map;
+  osm_t::ref osm;
+  osm2go_platform::DialogGuard dialog;
+  GtkWidget *keyEntry;
+  GtkWidget *valueEntry;
+  GtkWidget *list;
+  std::unique_ptr<GtkListStore, g_object_deleter> store;
+  std::vector<object_t> results; ///< the objects shown in the list
+};
+
+enum {
+  SEARCH_COL_TYPE = 0,
+  SEARCH_COL_NAME,
+  SEARCH_COL_INDEX,
+  SEARCH_NUM_COLS
+};
+
+void
+search_list_changed(GtkTreeSelection *selection, gpointer userdata)
+{
+  GtkWidget *list = static_cast<search_context_t *>(userdata)->list;
+
+  list_button_enable(list, LIST_BUTTON_NEW,
+                     gtk_tree_selection_get_selected(selection, nullptr, nullptr) == TRUE);
+}
+
+/* user clicked "find" button */
+void
+on_search_find(search_context_t *context)
+{
+  const gchar *key = gtk_entry_get_text(GTK_ENTRY(context->keyEntry));
+  const gchar *value = gtk_entry_get_text(GTK_ENTRY(context->valueEntry));
+
+  gtk_list_store_clear(context->store.get());
+
+  if(*key == '\0') {
+    context->results.clear();
+    return;
+  }
+
+  // an empty value matches all values of the key
+  context->results = context->osm->find_by_tag(key, *value == '\0' ? nullptr : value);
+
+  for(unsigned int i = 0; i < context->results.size(); i++) {
+    const object_t &obj = context->results[i];
+    gtk_list_store_insert_with_values(context->store.get(), nullptr, -1,
+                                      SEARCH_COL_TYPE, static_cast<const gchar *>(obj.type_string()),
+                                      SEARCH_COL_NAME, static_cast<const gchar *>(obj.get_name(*context->osm)),
+                                      SEARCH_COL_INDEX, i,
+                                      -1);
+  }
+
+  list_button_enable(context->list, LIST_BUTTON_NEW, false);
+}
+
+/* user clicked "select" button in the result list */
+void
+on_search_select(search_context_t *context, GtkWidget *but)
+{
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  if(!list_get_selected(context->list, &model, &iter))
+    return;
+
+  guint idx;
+  gtk_tree_model_get(model, &iter, SEARCH_COL_INDEX, &idx, -1);
+  assert_cmpnum_op(idx, <, context->results.size());
+
+  context->map->select_object(context->results[idx]);
+
+  /* tell dialog to close as we want to see the selected object */
+  GtkWidget *toplevel = gtk_widget_get_toplevel(GTK_WIDGET(but));
+  assert(GTK_IS_DIALOG(toplevel) == TRUE);
+
+  gtk_dialog_response(GTK_DIALOG(toplevel), GTK_RESPONSE_CLOSE);
+}
+
+GtkWidget *
+search_list_widget(search_context_t &context)
+{
+  std::vector<list_view_column> columns;
+  columns.push_back(list_view_column(_("Type"), 0));
+  columns.push_back(list_view_column(_("Name"), LIST_FLAG_ELLIPSIZE));
+
+  std::vector<list_button> buttons;
+  buttons.push_back(list_button(_("Select"), G_CALLBACK(on_search_select)));
+
+  context.store.reset(gtk_list_store_new(SEARCH_NUM_COLS,
+                                         G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT));
+
+  context.list = list_new(LIST_HILDON_WITH_HEADERS, &context,
+                          search_list_changed, buttons, columns,
+                          GTK_TREE_MODEL(context.store.get()));
+
+  list_button_enable(context.list, LIST_BUTTON_NEW, false);
+
+  return context.list;
+}
+
+} // namespace
+
+void tag_search_dialog(GtkWidget *parent, map_t *map, osm_t::ref osm)
+{
+  search_context_t context(map, osm,
+                           gtk_dialog_new_with_buttons(static_cast<const gchar *>(_("Find by tag")),
+                                                       GTK_WINDOW(parent),
+                                                       GTK_DIALOG_MODAL,
+                                                       GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE,
+                                                       nullptr));
+
+  osm2go_platform::dialog_size_hint(context.dialog, osm2go_platform::MISC_DIALOG_LARGE);
+  gtk_dialog_set_default_response(context.dialog, GTK_RESPONSE_CLOSE);
+
+  context.keyEntry = osm2go_platform::entry_new(osm2go_platform::EntryFlagsNoAutoCap);
+  context.valueEntry = osm2go_platform::entry_new(osm2go_platform::EntryFlagsNoAutoCap);
+#ifdef FREMANTLE
+  GtkWidget *findButton = osm2go_platform::button_new_with_label(_("Find"));
+#else
+  GtkWidget *findButton = gtk_button_new_from_stock(GTK_STOCK_FIND);
+#endif
+  g_signal_connect_swapped(findButton, "clicked", G_CALLBACK(on_search_find), &context);
+  // pressing enter in any of the entries starts the search
+  g_signal_connect_swapped(context.keyEntry, "activate", G_CALLBACK(on_search_find), &context);
+  g_signal_connect_swapped(context.valueEntry, "activate", G_CALLBACK(on_search_find), &context);
+
+  GtkBox *hbox = GTK_BOX(gtk_hbox_new(FALSE, 8));
+  gtk_box_pack_start(hbox, gtk_label_new(static_cast<const gchar *>(_("Key:"))), FALSE, FALSE, 0);
+  gtk_box_pack_start(hbox, context.keyEntry, TRUE, TRUE, 0);
+  gtk_box_pack_start(hbox, gtk_label_new(static_cast<const gchar *>(_("Value:"))), FALSE, FALSE, 0);
+  gtk_box_pack_start(hbox, context.valueEntry, TRUE, TRUE, 0);
+  gtk_box_pack_start(hbox, findButton, FALSE, FALSE, 0);
+
+  gtk_box_pack_start(context.dialog.vbox(), GTK_WIDGET(hbox), FALSE, FALSE, 0);
+  gtk_box_pack_start(context.dialog.vbox(), search_list_widget(context), TRUE, TRUE, 0);
+
+  gtk_widget_show_all(context.dialog.get());
+  gtk_dialog_run(context.dialog);
+}
@@ -116,12 +116,18 @@ MainUiGtk::MainUiGtk()
   menuitems[SUBMENU_MAP] = create_submenu_item(_("_Map"));
 #endif
   menuitems[MENU_ITEM_MAP_RELATIONS] = createMenuItem(_("_Relations"));
+  menuitems[MENU_ITEM_MAP_SEARCH] = createMenuItem(_("_Find by tag"), "edit-find");
   menuitems[SUBMENU_WMS] = create_submenu_item(_("_WMS"));
   menuitems[SUBMENU_TRACK] = create_submenu_item(_("_Track"));
   menuitems[MENU_ITEM_TRACK_IMPORT] = createMenuItem(_("_Import"));
   menuitems[MENU_ITEM_MAP_UPLOAD] = createMenuItem(_("_Upload"), "upload.16");
   menuitems[MENU_ITEM_MAP_UNDO_CHANGES] = createMenuItem(_("Undo _all"), "edit-delete");
   menuitems[MENU_ITEM_MAP_SHOW_CHANGES] = createMenuItem(_("Show _changes"));
+#ifdef FREMANTLE
+  menuitems[MENU_ITEM_PROJECT_OPEN] = createMenuItem(_("Project"));
+#else
+  menuitems[MENU_ITEM_PROJECT_OPEN] = createMenuItem(_("_Open"), "document-open");
+#endif
 #ifndef FREMANTLE
   menuitems[MENU_ITEM_MAP_SAVE_CHANGES] = createMenuItem(_("_Save local changes"), "document-save");
 #endif
@@ -93,12 +93,14 @@ bool RelationMembershipModel::setData(const QModelIndex &idx, const QVariant &va
     if (role != Qt::CheckStateRole)
       return false;
     relation = m_relations.at(idx.row());
+    m_osm->mark_dirty(relation);
     if (value.value<Qt::CheckState>() == Qt::Unchecked) {
       auto it = relation->find_member_object(m_obj);
       assert(it != relation->members.end());
       relation->members.erase(it);
     } else {
       relation->members.emplace_back(member_t(m_obj, nullptr));
+      m_osm->addMemberRef(m_obj, relation);
     }
 
     break;
@@ -107,11 +109,13 @@ bool RelationMembershipModel::setData(const QModelIndex &idx, const QVariant &va
     if (role != Qt::EditRole)
       return false;
     relation = m_relations.at(idx.row());
+    m_osm->mark_dirty(relation);
     const auto s = value.toString();
     member_t nm(m_obj, s.isEmpty() ? nullptr : s.toUtf8().constData());
 
     if (auto it = relation->find_member_object(m_obj); it == relation->members.end()) {
       relation->members.emplace_back(nm);
+      m_osm->addMemberRef(m_obj, relation);
     } else {
       auto mit = std::next(relation->members.begin(), std::distance(relation->members.cbegin(), it));
       *mit = nm;
@@ -124,7 +128,6 @@ bool RelationMembershipModel::setData(const QModelIndex &idx, const QVariant &va
 
   // always update both columns, even if only one changed
   emit dataChanged(index(idx.row(), RELITEM_COL_MEMBER), index(idx.row(), RELITEM_COL_ROLE));
-  relation->flags |= OSM_FLAG_DIRTY;
   return true;
 }
 
@@ -302,7 +302,7 @@ canvas_t::circle_new(canvas_group_t group, lpos_t c, float radius, int border, c
   auto *ret = reinterpret_cast<canvas_item_circle *>(item);
 
   if (CANVAS_SELECTABLE & (1 << group))
-    (void) new canvas_item_info_circle(this, ret, c, radius + border);
+    (void) new canvas_item_info_circle(this, group, ret, c, radius + border);
 
   return ret;
 }
@@ -319,6 +319,17 @@ canvas_points_create(const std::vector<lpos_t> &points)
   return ret;
 }
 
+static QPolygonF
+canvas_polygon_create(const std::vector<lpos_t> &points)
+{
+  QPolygonF ret(points.size());
+  ret.clear();
+  for (const auto p: points)
+    ret << QPointF(p.x, p.y);
+
+  return ret;
+}
+
 canvas_item_polyline *
 canvas_t::polyline_new(canvas_group_t group, const std::vector<lpos_t> &points, float width, color_t color)
 {
@@ -330,7 +341,7 @@ canvas_t::polyline_new(canvas_group_t group, const std::vector<lpos_t> &points,
   auto *ret = reinterpret_cast<canvas_item_polyline *>(item);
 
   if(CANVAS_SELECTABLE & (1 << group))
-    (void) new canvas_item_info_poly(this, ret, false, width, points);
+    (void) new canvas_item_info_poly(this, group, ret, false, width, points);
 
   return ret;
 }
@@ -339,13 +350,8 @@ canvas_item_t *
 canvas_t::polygon_new(canvas_group_t group, const std::vector<lpos_t> &points, float width,
                       color_t color, color_t fill)
 {
-  QPolygonF cpoints(points.size());
-  cpoints.clear();
-  for (const auto p: points)
-    cpoints << QPointF(p.x, p.y);
-
   auto *item = new ZoomedItem<QGraphicsPolygonItem>(this, group);
-  item->setPolygon(cpoints);
+  item->setPolygon(canvas_polygon_create(points));
 
   item->setPen(QPen(QColor::fromRgba(color.argb()), width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
   item->setBrush(QColor::fromRgba(fill.argb()));
@@ -353,11 +359,75 @@ canvas_t::polygon_new(canvas_group_t group, const std::vector<lpos_t> &points, f
   auto *ret = reinterpret_cast<canvas_item_t *>(item);
 
   if(CANVAS_SELECTABLE & (1 << group))
-    (void) new canvas_item_info_poly(this, ret, true, width, points);
+    (void) new canvas_item_info_poly(this, group, ret, true, width, points);
 
   return ret;
 }
 
+namespace {
+
+/**
+ * @brief disable the scene index while many items are added
+ *
+ * Otherwise every new item is inserted into the BSP tree on its own. When
+ * the index is enabled again the tree is built once for all items, so this
+ * is only done if the batch is big compared to the existing items.
+ */
+class index_suspender {
+  QGraphicsScene * const scene;
+  const QGraphicsScene::ItemIndexMethod method;
+public:
+  index_suspender(canvas_t *canvas, size_t count)
+    : scene(count >= 256 && count * 4 >= canvas->item_mapping.size() ?
+            static_cast<canvas_graphicsscene *>(canvas)->scene : nullptr)
+    , method(static_cast<canvas_graphicsscene *>(canvas)->scene->itemIndexMethod())
+  {
+    if(scene != nullptr)
+      scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+  }
+
+  ~index_suspender()
+  {
+    if(scene != nullptr)
+      scene->setItemIndexMethod(method);
+  }
+};
+
+} // namespace
+
+void
+canvas_t::poly_batch_new(canvas_group_t group, const std::vector<canvas_poly_t> &polys,
+                         std::vector<canvas_item_t *> &items)
+{
+  index_suspender suspend(this, polys.size());
+
+  items.reserve(items.size() + polys.size());
+  if(CANVAS_SELECTABLE & (1 << group))
+    item_mapping.reserve(item_mapping.size() + polys.size());
+
+  for (const auto &poly : polys) {
+    if(poly.polygon)
+      items.push_back(polygon_new(group, poly.points, poly.width, poly.color, poly.fill));
+    else
+      items.push_back(polyline_new(group, poly.points, poly.width, poly.color));
+  }
+}
+
+void
+canvas_t::circle_batch_new(canvas_group_t group, const std::vector<canvas_circle_t> &circles,
+                           std::vector<canvas_item_circle *> &items)
+{
+  index_suspender suspend(this, circles.size());
+
+  items.reserve(items.size() + circles.size());
+  if(CANVAS_SELECTABLE & (1 << group))
+    item_mapping.reserve(item_mapping.size() + circles.size());
+
+  for (const auto &circle : circles)
+    items.push_back(circle_new(group, circle.center, circle.radius, circle.border, circle.fill,
+                               circle.border_color));
+}
+
 /* place the image in pix centered on x/y on the canvas */
 canvas_item_pixmap *
 canvas_t::image_new(canvas_group_t group, icon_item *icon, lpos_t pos, float scale)
@@ -385,7 +455,7 @@ canvas_t::image_new(canvas_group_t group, icon_item *icon, lpos_t pos, float sca
 
   if (CANVAS_SELECTABLE & (1 << group)) {
     int radius = 0.75 * scale * std::max(pix.width(), pix.height());
-    (void) new canvas_item_info_circle(this, ret, pos, radius);
+    (void) new canvas_item_info_circle(this, group, ret, pos, radius);
   }
 
   return ret;
@@ -405,6 +475,19 @@ canvas_item_polyline::set_points(const std::vector<lpos_t> &points)
   reinterpret_cast<QGraphicsPathItem *>(this)->setPath(canvas_points_create(points));
 }
 
+void
+canvas_item_t::set_shape(const std::vector<lpos_t> &points)
+{
+  auto *item = reinterpret_cast<QGraphicsItem *>(this);
+
+  if(item->type() == QGraphicsPathItem::Type) {
+    static_cast<QGraphicsPathItem *>(item)->setPath(canvas_points_create(points));
+  } else {
+    assert(item->type() == QGraphicsPolygonItem::Type);
+    static_cast<QGraphicsPolygonItem *>(item)->setPolygon(canvas_polygon_create(points));
+  }
+}
+
 void
 canvas_item_circle::set_radius(float radius)
 {
@@ -425,6 +508,29 @@ canvas_t::ensureVisible(lpos_t lpos)
   return true;
 }
 
+void
+canvas_t::visible_area(lpos_t &min, lpos_t &max) const
+{
+  auto *view = static_cast<const QGraphicsView *>(widget);
+  const QRectF rect = view->mapToScene(view->viewport()->rect()).boundingRect();
+
+  min = lpos_t(std::floor(rect.left()), std::floor(rect.top()));
+  max = lpos_t(std::ceil(rect.right()), std::ceil(rect.bottom()));
+}
+
+void
+canvas_item_t::lower()
+{
+  auto *qitem = reinterpret_cast<QGraphicsItem *>(this);
+  const auto childs = qitem->parentItem()->childItems();
+
+  qitem->setZValue(-1);
+
+  for (auto &&o : childs)
+    if (o != qitem)
+      o->setZValue(o->zValue() + 1);
+}
+
 void
 canvas_item_t::set_zoom_max(float zoom_max)
 {
@@ -463,52 +569,3 @@ canvas_item_t::destroy_connect(canvas_item_destroyer *d)
   reinterpret_cast<QGraphicsItem *>(this)->setData(DATA_KEY_DELETE_ITEM, QVariant::fromValue(static_cast<void *>(d)));
 }
 
-namespace {
-
-auto items_in_rect(CanvasScene *sc, lpos_t pos, double zoom)
-{
-  int fuzziness = EXTRA_FUZZINESS_METER + EXTRA_FUZZINESS_PIXEL / zoom;
-
-  const QRectF cRect(pos.x - fuzziness, pos.y - fuzziness, fuzziness * 2, fuzziness * 2);
-
-  auto items = sc->items(cRect);
-
-  // remove unselectable entries
-  items.erase(std::remove_if(items.begin(), items.end(), [](auto item) {
-    return !(item->flags() & QGraphicsItem::ItemIsSelectable);
-  }), items.end());
-
-  return items;
-}
-
-} // namespace
-
-canvas_item_t *
-canvas_t::get_item_at(lpos_t pos) const
-{
-  const auto items = items_in_rect(static_cast<const canvas_graphicsscene *>(this)->scene, pos, get_zoom());
-
-  QGraphicsItem *ret = nullptr;
-
-  for (auto &&item : items) {
-    if (ret == nullptr || ret->zValue() < item->zValue())
-      ret = item;
-  }
-
-  return reinterpret_cast<canvas_item_t *>(ret);
-}
-
-canvas_item_t *
-canvas_t::get_next_item_at(lpos_t pos, canvas_item_t *oldtop) const
-{
-  auto *qitem = reinterpret_cast<QGraphicsItem *>(oldtop);
-  const auto childs = qitem->parentItem()->childItems();
-
-  qitem->setZValue(-1);
-
-  for (auto &&o : childs)
-    if (o != qitem)
-      o->setZValue(o->zValue() + 1);
-
-  return get_item_at(pos);
-}
@@ -15,6 +15,7 @@
 #include <QApplication>
 #include <QDebug>
 #include <QGraphicsView>
+#include <QScrollBar>
 
 namespace {
 
@@ -46,6 +47,13 @@ map_graphicsview::map_graphicsview(appdata_t &a)
   autosave.setSingleShot(false);
   QObject::connect(&autosave, &QTimer::timeout, [v = view, &a = appdata](){ map_autosave(v, a); });
 
+  // scrolling, zooming, and resizing all change the scroll bars
+  const auto viewportChanged = [this]() { viewport_changed(); };
+  for(QScrollBar *bar : { view->horizontalScrollBar(), view->verticalScrollBar() }) {
+    QObject::connect(bar, &QScrollBar::valueChanged, &autosave, viewportChanged);
+    QObject::connect(bar, &QScrollBar::rangeChanged, &autosave, viewportChanged);
+  }
+
   auto cs = static_cast<CanvasScene *>(view->scene());
   QObject::connect(cs, &CanvasScene::mouseMove, [this](const QPointF &p) {
     if(unlikely(!appdata.project || !appdata.project->osm))
@@ -33,7 +33,7 @@ namespace {
 
 /* structure shared between worker and master thread */
 struct net_io_request_t {
-  net_io_request_t(const std::string &u, const std::string &f, bool c);
+  net_io_request_t(const std::string &u, const std::string &f, bool c, const std::shared_ptr<net_io_sink> &s);
   net_io_request_t(const std::string &u, std::string *smem) __attribute__((nonnull(3)));
 
   const QUrl url;
@@ -47,15 +47,18 @@ struct net_io_request_t {
   QFile file;   /* used for NET_IO_DL_FILE */
   std::string * const mem;   /* used for NET_IO_DL_MEM */
   const bool use_compression;
+  const std::shared_ptr<net_io_sink> sink; /* optionally used for NET_IO_DL_FILE */
 };
 
-net_io_request_t::net_io_request_t(const std::string &u, const std::string &f, bool c)
+net_io_request_t::net_io_request_t(const std::string &u, const std::string &f, bool c,
+                                   const std::shared_ptr<net_io_sink> &s)
   : url(QString::fromStdString(u))
   , cancel(false)
   , error(QNetworkReply::NoError)
   , file(QString::fromStdString(f))
   , mem(nullptr)
   , use_compression(c)
+  , sink(s)
 {
   assert(!f.empty());
   if(!file.open(QIODevice::WriteOnly))
@@ -128,7 +131,10 @@ net_io_do(osm2go_platform::Widget *parent, net_io_request_t &request, const QStr
 
   if(!request.file.fileName().isEmpty()) {
     QObject::connect(r, &QIODevice::readyRead, [&request, r]() {
-      request.file.write(r->readAll());
+      const QByteArray d = r->readAll();
+      request.file.write(d);
+      if(request.sink)
+        request.sink->write(d.constData(), d.size());
     });
   } else {
     QObject::connect(r, &QIODevice::readyRead, [&request, r]() {
@@ -186,9 +192,9 @@ net_io_do(osm2go_platform::Widget *parent, net_io_request_t &request, const QStr
 
 bool
 net_io_download_file(osm2go_platform::Widget *parent, const std::string &url, const std::string &filename,
-                     const QString &title, bool compress)
+                     const QString &title, bool compress, const std::shared_ptr<net_io_sink> &sink)
 {
-  net_io_request_t request(url, filename, compress);
+  net_io_request_t request(url, filename, compress, sink);
 
   qDebug() << "net_io: download " << url.c_str() << " to file " << filename.c_str();
 
@@ -210,16 +216,17 @@ net_io_download_file(osm2go_platform::Widget *parent, const std::string &url, co
 
 bool
 net_io_download_file(osm2go_platform::Widget *parent, const std::string &url, const std::string &filename,
-                     trstring::native_type_arg title, bool compress)
+                     trstring::native_type_arg title, bool compress, const std::shared_ptr<net_io_sink> &sink)
 {
-  return net_io_download_file(parent, url, filename, static_cast<QString>(title), compress);
+  return net_io_download_file(parent, url, filename, static_cast<QString>(title), compress, sink);
 }
 
 bool
 net_io_download_file(osm2go_platform::Widget *parent, const std::string &url,
-                     const std::string &filename, const std::string &title, bool compress)
+                     const std::string &filename, const std::string &title, bool compress,
+                     const std::shared_ptr<net_io_sink> &sink)
 {
-  return net_io_download_file(parent, url, filename, QString::fromStdString(title), compress);
+  return net_io_download_file(parent, url, filename, QString::fromStdString(title), compress, sink);
 }
 
 bool
@@ -75,7 +75,7 @@ pos_t pos_t::fromXmlProperties(xmlNodePtr node, const char *latName, const char
 
 static pos_float_t xml_reader_attr_float(xmlTextReaderPtr reader, const char *name) {
   xmlString prop(xmlTextReaderGetAttribute(reader, BAD_CAST name));
-  return xml_parse_float(prop);
+  return pos_parse_coord(prop);
 }
 
 pos_t pos_t::fromXmlProperties(xmlTextReaderPtr reader, const char *latName, const char *lonName)
@@ -84,6 +84,73 @@ pos_t pos_t::fromXmlProperties(xmlTextReaderPtr reader, const char *latName, con
                xml_reader_attr_float(reader, lonName));
 }
 
+namespace {
+
+/**
+ * @brief convert one coordinate to fixed point
+ *
+ * This does the same calculation as format_float(), so the XML output of
+ * the fixed point value matches the one of the floating point value.
+ */
+int32_t coord_to_fixed(pos_float_t val)
+{
+  if(unlikely(!std::isfinite(val)))
+    return INT32_MIN;
+
+  for (unsigned int k = pos_fixed_t::Decimals; k > 0; k--)
+    val *= 10;
+  val = round(val);
+
+  // the limit is way outside of the valid coordinate range
+  if(unlikely(val <= INT32_MIN || val > INT32_MAX))
+    return INT32_MIN;
+
+  return static_cast<int32_t>(val);
+}
+
+inline pos_float_t coord_from_fixed(int32_t val)
+{
+  if(unlikely(val == INT32_MIN))
+    return NAN;
+  return static_cast<pos_float_t>(val / 1e7);
+}
+
+void xml_add_prop_coord_fixed(xmlNodePtr node, const char *key, int32_t val)
+{
+  char str[16];
+  format_float_int(val, pos_fixed_t::Decimals, str);
+  xmlNewProp(node, BAD_CAST key, BAD_CAST str);
+}
+
+} // namespace
+
+pos_float_t pos_parse_coord(const char *str)
+{
+  int32_t val;
+  // both are the nearest representable value of the decimal number
+  if(likely(str != nullptr && parse_float_int(str, pos_fixed_t::Decimals, val)))
+    return coord_from_fixed(val);
+
+  return osm2go_platform::string_to_double(str);
+}
+
+pos_fixed_t::pos_fixed_t(const pos_t &pos) noexcept
+  : ilat(coord_to_fixed(pos.lat))
+  , ilon(coord_to_fixed(pos.lon))
+{
+}
+
+pos_t pos_fixed_t::toPos() const noexcept
+{
+  return pos_t(coord_from_fixed(ilat), coord_from_fixed(ilon));
+}
+
+void pos_fixed_t::toXmlProperties(xmlNodePtr node) const
+{
+  xml_add_prop_coord_fixed(node, "lat", ilat);
+  xml_add_prop_coord_fixed(node, "lon", ilon);
+}
+
 lpos_t pos_t::toLpos() const {
   lpos_t lpos;
   lpos.x = POS_EQ_RADIUS * DEG2RAD(lon);
@@ -16,6 +16,7 @@ typedef double pos_float_t;
 #ifdef __cplusplus
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <libxml/tree.h>
 #include <libxml/xmlreader.h>
 #include <string>
@@ -71,6 +72,53 @@ struct pos_t {
 
 #ifdef __cplusplus
 
+/**
+ * @brief global position in fixed point representation
+ *
+ * The coordinates are stored as integer multiples of 1e-7 degrees, which is
+ * the precision of the OSM database. This needs only half of the memory of
+ * pos_t, so it is used for the node positions.
+ */
+struct pos_fixed_t {
+  enum {
+    Decimals = 7
+  };
+
+  int32_t ilat, ilon; ///< coordinates in 1e-7 degrees
+
+  /**
+   * @brief create an invalid position
+   */
+  inline pos_fixed_t() noexcept : ilat(INT32_MIN), ilon(INT32_MIN) {}
+  // intentionally not explicit: this is the conversion at the pos_t API boundary
+  pos_fixed_t(const pos_t &pos) noexcept;
+
+  inline bool operator==(const pos_fixed_t &other) const noexcept
+  { return ilat == other.ilat && ilon == other.ilon; }
+  inline bool operator!=(const pos_fixed_t &other) const noexcept
+  { return !operator==(other); }
+
+  /**
+   * @brief convert back to floating point coordinates
+   *
+   * An invalid position results in NAN coordinates.
+   */
+  pos_t toPos() const noexcept;
+
+  inline bool valid() const noexcept
+  { return toPos().valid(); }
+
+  inline lpos_t toLpos(const bounds_t &bounds) const;
+
+  /**
+   * @brief write the coordinates as "lat" and "lon" properties
+   *
+   * The result is identical to pos_t::toXmlProperties() of the position
+   * this was created from.
+   */
+  void toXmlProperties(xmlNodePtr node) const;
+};
+
 struct pos_area {
   explicit pos_area() noexcept {}
   pos_area(const pos_t &mi, const pos_t &ma) noexcept
@@ -139,6 +187,11 @@ struct bounds_t {
   bool init(const pos_area &area);
 };
 
+inline lpos_t pos_fixed_t::toLpos(const bounds_t &bounds) const
+{
+  return toPos().toLpos(bounds);
+}
+
 void pos_lat_str(char *str, size_t len, pos_float_t latitude);
 static inline void pos_lon_str(char *str, size_t len, pos_float_t longitude)
 {
@@ -154,4 +207,14 @@ static inline void pos_lon_str_deg(char *str, size_t len, pos_float_t longitude)
 bool pos_lat_valid(pos_float_t lat) noexcept;
 bool pos_lon_valid(pos_float_t lon) noexcept;
 
+/**
+ * @brief parse a coordinate
+ * @param str the string to parse, may be nullptr
+ *
+ * Coordinates with at most pos_fixed_t::Decimals decimals are parsed with
+ * parse_float_int(), everything else is passed to
+ * osm2go_platform::string_to_double(). The result is the same in both cases.
+ */
+pos_float_t pos_parse_coord(const char *str);
+
 #endif
@@ -10,6 +10,7 @@
 #include "appdata.h"
 #include "area_edit.h"
 #include "diff.h"
+#include "iconbar.h"
 #include "map.h"
 #include "misc.h"
 #include "net_io.h"
@@ -21,6 +22,7 @@
 #include "wms.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cerrno>
 #include <cstring>
@@ -505,7 +507,9 @@ static bool project_load_inner(appdata_t &appdata, std::unique_ptr<project_t> &p
   if(unlikely(appdata_t::window == nullptr))
     return false;
 
-  appdata.map->init();
+  // draws the visible area first and handles events in between
+  if(unlikely(!appdata.map->init()))
+    return false;
 
   /* restore a track */
   osm2go_platform::process_events();
@@ -544,6 +548,21 @@ static void project_replace_start(appdata_t &appdata, const std::string &name)
   if(appdata.project)
     project_close(appdata);
 
+  // the map is drawn while events are handled, but nothing may be edited and
+  // no other project may be opened before this one is completely loaded,
+  // main_ui_enable() will activate the controls again
+  if(likely(appdata_t::window != nullptr)) {
+    appdata.iconbar->setToolbarEnable(false);
+    const std::array<MainUi::menu_items, 4> busy_items = { {
+      MainUi::MENU_ITEM_PROJECT_OPEN,
+      MainUi::SUBMENU_MAP,
+      MainUi::SUBMENU_TRACK,
+      MainUi::SUBMENU_WMS
+    } };
+    for(unsigned int i = 0; i < busy_items.size(); i++)
+      appdata.uicontrol->setActionEnable(busy_items[i], false);
+  }
+
   osm2go_platform::process_events();
 }
 
@@ -579,8 +598,30 @@ bool project_load(appdata_t &appdata, std::unique_ptr<project_t> &project)
 }
 
 bool project_t::parse_osm() {
-  osm.reset(osm_t::parse(path, osmFile));
-  return static_cast<bool>(osm);
+  const std::string source = osm_file_path();
+  // the snapshot is bound to the size and modification time of the source,
+  // so a new download automatically invalidates it
+  const std::string snapshot = snapshot_file();
+
+  if(downloaded) {
+    osm.reset(downloaded.release());
+  } else {
+    osm.reset(osm_t::loadSnapshot(snapshot, source));
+    if(osm)
+      return true;
+
+    osm.reset(osm_t::parse(path, osmFile));
+    if(unlikely(!osm))
+      return false;
+  }
+
+  osm->saveSnapshot(snapshot, source);
+  return true;
+}
+
+std::string project_t::osm_file_path() const
+{
+  return osmFile.find('/') != std::string::npos ? osmFile : path + osmFile;
 }
 
 project_t::project_t(const std::string &n, const std::string &base_path)
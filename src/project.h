@@ -64,13 +64,27 @@ struct project_t {
   fdguard dirfd;       // filedescriptor of path
 
   std::unique_ptr<osm_t> osm;          ///< the OSM data
+  std::unique_ptr<osm_t> downloaded;   ///< data scanned during the last download, see osm_download()
 
   /**
    * @brief parse the OSM data file
    * @returns if the loading was successful
+   *
+   * If the data was scanned during the download it is used instead.
    */
   bool parse_osm();
 
+  /**
+   * @brief the full path of the OSM data file
+   */
+  std::string osm_file_path() const;
+
+  /**
+   * @brief the file the binary snapshot of the parsed OSM data is kept in
+   */
+  inline std::string snapshot_file() const
+  { return path + name + ".snapshot"; }
+
   /**
    * @brief save the current project to disk
    * @param parent parent window for dialogs
@@ -30,12 +30,14 @@ public:
     SUBMENU_VIEW,
     SUBMENU_MAP,
     MENU_ITEM_MAP_RELATIONS,
+    MENU_ITEM_MAP_SEARCH,
     SUBMENU_WMS,
     SUBMENU_TRACK,
     MENU_ITEM_TRACK_IMPORT,
     MENU_ITEM_MAP_UPLOAD,
     MENU_ITEM_MAP_UNDO_CHANGES,
     MENU_ITEM_MAP_SHOW_CHANGES,
+    MENU_ITEM_PROJECT_OPEN,
   #ifndef FREMANTLE
     MENU_ITEM_MAP_SAVE_CHANGES,
   #endif
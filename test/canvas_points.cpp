@@ -1,10 +1,12 @@
 #include "dummy_map.h"
+#include "test_lcg.h"
 
 #include <canvas.h>
 #include <canvas_p.h>
 #include <style.h>
 
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <unistd.h>
@@ -235,9 +237,228 @@ void testTrackSegments()
     assert_cmpnum(m->elements_drawn, 4);
   }
 
+  // drawing all segments at once must give the same pieces as one by one
+  std::vector<size_t> pieces;
+  a.track.track->clear();
+  for (unsigned int i = 0; i < a.track.track->segments.size(); i++) {
+    m->track_draw_seg(a.track.track->segments[i]);
+    pieces.push_back(a.track.track->segments[i].item_chain.size());
+  }
+
+  m->track_draw(DrawAll, *a.track.track);
+  for (unsigned int i = 0; i < a.track.track->segments.size(); i++) {
+    assert_cmpnum(a.track.track->segments[i].item_chain.size(), pieces[i]);
+    for (unsigned int j = 0; j < pieces[i]; j++)
+      assert(a.track.track->segments[i].item_chain[j] != nullptr);
+  }
+
   assert_cmpnum(rmdir(tmpdir), 0);
 }
 
+void testBatch()
+{
+  std::vector<canvas_poly_t> polys;
+  polys.push_back(canvas_poly_t(false, 1, color_t::black()));
+  polys.back().points.push_back(lpos_t(0, 0));
+  polys.back().points.push_back(lpos_t(100, 0));
+  polys.push_back(canvas_poly_t(true, 1, color_t::black(), color_t::black()));
+  polys.back().points.push_back(lpos_t(200, 200));
+  polys.back().points.push_back(lpos_t(300, 200));
+  polys.back().points.push_back(lpos_t(300, 300));
+  polys.back().points.push_back(lpos_t(200, 300));
+  polys.back().points.push_back(lpos_t(200, 200));
+
+  std::vector<canvas_circle_t> circles;
+  circles.push_back(canvas_circle_t(lpos_t(500, 500), 5, 0, color_t::black(), 0));
+  circles.push_back(canvas_circle_t(lpos_t(600, 500), 5, 1, color_t::black(), color_t::black()));
+
+  canvas_holder canvas;
+
+  // existing entries are kept
+  std::vector<canvas_item_t *> items(1, nullptr);
+  canvas->poly_batch_new(CANVAS_GROUP_WAYS, polys, items);
+  assert_cmpnum(items.size(), 3);
+  assert_null(items.front());
+
+  std::vector<canvas_item_circle *> citems;
+  canvas->circle_batch_new(CANVAS_GROUP_NODES, circles, citems);
+  assert_cmpnum(citems.size(), 2);
+
+  // the items are in the same order as their descriptions
+  assert(canvas->get_item_at(lpos_t(50, 0)) == items[1]);
+  assert(canvas->get_item_at(lpos_t(250, 250)) == items[2]);
+  assert(canvas->get_item_at(lpos_t(500, 500)) == citems[0]);
+  assert(canvas->get_item_at(lpos_t(600, 500)) == citems[1]);
+  assert_cmpnum(canvas->item_mapping.size(), 4);
+
+  // nothing to do
+  canvas->poly_batch_new(CANVAS_GROUP_WAYS, std::vector<canvas_poly_t>(), items);
+  assert_cmpnum(items.size(), 3);
+}
+
+void testHitIndex()
+{
+  canvas_holder canvas;
+
+  // items of higher groups are on top, no matter when they were created
+  const lpos_t center(1000, 1000);
+  canvas_item_circle * const node1 = canvas->circle_new(CANVAS_GROUP_NODES, center, 5, 0, color_t::black());
+  std::vector<lpos_t> points;
+  points.push_back(lpos_t(900, 1000));
+  points.push_back(lpos_t(1100, 1000));
+  canvas_item_t * const way = canvas->polyline_new(CANVAS_GROUP_WAYS, points, 3, color_t::black());
+  assert(canvas->get_item_at(center) == node1);
+
+  // inside a group newer items are on top
+  canvas_item_circle * const node2 = canvas->circle_new(CANVAS_GROUP_NODES, center, 5, 0, color_t::black());
+  assert(canvas->get_item_at(center) == node2);
+  assert(canvas->get_next_item_at(center, node2) == node1);
+  assert(canvas->get_next_item_at(center, node1) == node2);
+  // the way is only found where no node is
+  assert(canvas->get_item_at(lpos_t(1050, 1000)) == way);
+
+  // hidden items are not found
+  canvas->set_item_zoom_max(node1, 1000);
+  canvas->set_item_zoom_max(node2, 1000);
+  assert(canvas->get_item_at(center) == way);
+  canvas->set_item_zoom_max(node1, 0);
+  assert(canvas->get_item_at(center) == node1);
+
+  // deleted items are gone
+  delete node1;
+  delete way;
+  assert_null(canvas->get_item_at(center));
+  canvas->set_item_zoom_max(node2, 0);
+  assert(canvas->get_item_at(center) == node2);
+  delete node2;
+  assert_null(canvas->get_item_at(center));
+  assert(canvas->item_mapping.empty());
+
+  // a long diagonal segment
+  points.clear();
+  points.push_back(lpos_t(-100000, -100000));
+  points.push_back(lpos_t(100000, 100000));
+  canvas_item_t * const diagonal = canvas->polyline_new(CANVAS_GROUP_WAYS, points, 1, color_t::black());
+  assert(canvas->get_item_at(lpos_t(50000, 50000)) == diagonal);
+  assert_null(canvas->get_item_at(lpos_t(50000, -50000)));
+
+  // the inside of a big polygon far away from its borders
+  points.clear();
+  points.push_back(lpos_t(0, 0));
+  points.push_back(lpos_t(100000, 0));
+  points.push_back(lpos_t(100000, 100000));
+  points.push_back(lpos_t(0, 100000));
+  points.push_back(points.front());
+  canvas_item_t * const area = canvas->polygon_new(CANVAS_GROUP_POLYGONS, points, 1, color_t::black(), color_t::black());
+  assert(canvas->get_item_at(lpos_t(80000, 20000)) == area);
+  assert(canvas->get_item_at(lpos_t(50000, 50000)) == diagonal);
+  assert_null(canvas->get_item_at(lpos_t(-50000, 50000)));
+
+  // a way that has segments in many cells
+  points.clear();
+  for (int i = 0; i < 100; i++)
+    points.push_back(lpos_t(-20000 + i * 100, (i % 2) * 100 - 20000));
+  canvas_item_t * const zigzag = canvas->polyline_new(CANVAS_GROUP_WAYS, points, 1, color_t::black());
+  assert(canvas->get_item_at(lpos_t(-20000 + 50 * 100 + 50, -19950)) == zigzag);
+  assert_null(canvas->get_item_at(lpos_t(-20000 + 50 * 100 + 50, -19500)));
+
+  // many nodes next to each other
+  std::vector<canvas_item_circle *> nodes;
+  for (int x = 0; x < 40; x++)
+    for (int y = 0; y < 40; y++)
+      nodes.push_back(canvas->circle_new(CANVAS_GROUP_NODES, lpos_t(-50000 + x * 100, 50000 + y * 100), 5, 0,
+                                         color_t::black()));
+  for (int x = 0; x < 40; x++)
+    for (int y = 0; y < 40; y++)
+      assert(canvas->get_item_at(lpos_t(-50000 + x * 100 + 1, 50000 + y * 100 - 1)) == nodes[x * 40 + y]);
+  assert_null(canvas->get_item_at(lpos_t(-50000 + 50, 50000 + 50)));
+}
+
+const canvas_item_info_poly *polyInfo(canvas_holder &canvas, const std::vector<lpos_t> &points, float width)
+{
+  canvas_item_t * const item = canvas->polyline_new(CANVAS_GROUP_WAYS, points, width, color_t::black());
+  const canvas_t::item_mapping_t::const_iterator it = canvas->item_mapping.find(item);
+  assert(it != canvas->item_mapping.end());
+  return static_cast<const canvas_item_info_poly *>(it->second);
+}
+
+void testSegmentSimd()
+{
+  canvas_holder canvas;
+
+  // the same distance to 2 segments, the first one must be returned
+  std::vector<lpos_t> points;
+  for (int i = 0; i < 5; i++) {
+    points.push_back(lpos_t(0, 0));
+    points.push_back(lpos_t(100, 0));
+  }
+  const canvas_item_info_poly *info = polyInfo(canvas, points, 1);
+  std::optional<unsigned int> seg = info->get_segment(50, 1, 2);
+  assert(seg);
+  assert_cmpnum(*seg, 0);
+  assert(!info->get_segment(50, 10, 2));
+
+  // a long way where the searched segment is in the middle
+  points.clear();
+  for (int i = 0; i < 5000; i++)
+    points.push_back(lpos_t(i * 10, (i % 2) * 10));
+  info = polyInfo(canvas, points, 0);
+  seg = info->get_segment(2345 * 10 + 5, 5, 1);
+  assert(seg);
+  assert_cmpnum(*seg, 2345);
+
+  // random ways of all lengths must give the same results as the plain code
+  lcg rnd(42);
+  const float fuzziness[] = { 0, 0.5, 8, 100 };
+  const float widths[] = { 0, 1, 3 };
+  unsigned int found = 0;
+  for (unsigned int len = 2; len < 40; len++) {
+    for (unsigned int w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+      points.clear();
+      lpos_t pos(rnd.offset(5000), rnd.offset(5000));
+      for (unsigned int i = 0; i < len; i++) {
+        points.push_back(pos);
+        // also create duplicate points and horizontal and vertical segments
+        switch (rnd.next(8)) {
+        case 0:
+          break;
+        case 1:
+          pos.x += rnd.offset(200);
+          break;
+        case 2:
+          pos.y += rnd.offset(200);
+          break;
+        default:
+          pos.x += rnd.offset(200);
+          pos.y += rnd.offset(200);
+          break;
+        }
+      }
+      info = polyInfo(canvas, points, widths[w]);
+
+      for (unsigned int q = 0; q < 200; q++) {
+        // positions close to the way and random ones
+        const lpos_t &base = points[rnd.next(len)];
+        const int spread = q % 2 == 0 ? 30 : 1000;
+        const int x = base.x + rnd.offset(spread);
+        const int y = base.y + rnd.offset(spread);
+        for (unsigned int f = 0; f < sizeof(fuzziness) / sizeof(fuzziness[0]); f++) {
+          const std::optional<unsigned int> expected = info->get_segment_scalar(x, y, fuzziness[f]);
+          const std::optional<unsigned int> actual = info->get_segment(x, y, fuzziness[f]);
+          assert_cmpnum(static_cast<bool>(actual), static_cast<bool>(expected));
+          if (expected) {
+            assert_cmpnum(*actual, *expected);
+            found++;
+          }
+        }
+      }
+    }
+  }
+
+  // make sure the comparison was not only done for the misses
+  assert_cmpnum_op(found, >, 1000);
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -248,6 +469,9 @@ int main(int argc, char **argv)
   testInObject();
   testToBottom();
   testTrackSegments();
+  testBatch();
+  testHitIndex();
+  testSegmentSimd();
 
   return 0;
 }
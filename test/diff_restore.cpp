@@ -66,21 +66,21 @@ void verify_diff(osm_t::ref osm)
   // added in diff
   const node_t * const nn1 = osm->object_by_id<node_t>(-1);
   assert(nn1 != nullptr);
-  assert_cmpnum(nn1->pos.lat, 52.2693518);
-  assert_cmpnum(nn1->pos.lon, 9.576014);
+  assert_cmpnum(nn1->pos.toPos().lat, 52.2693518);
+  assert_cmpnum(nn1->pos.toPos().lon, 9.576014);
   assert(nn1->tags.empty());
   // added in diff, same position as existing node
   const node_t * const nn2 = osm->object_by_id<node_t>(-2);
   assert(nn2 != nullptr);
-  assert_cmpnum(nn2->pos.lat, 52.269497);
-  assert_cmpnum(nn2->pos.lon, 9.5752223);
+  assert_cmpnum(nn2->pos.toPos().lat, 52.269497);
+  assert_cmpnum(nn2->pos.toPos().lon, 9.5752223);
   assert(nn2->tags.empty());
   // which is this one
   const node_t * const n27 = osm->object_by_id<node_t>(3577031227LL);
   assert(n27 != nullptr);
   assert_cmpnum(n27->flags, 0);
-  assert_cmpnum(nn2->pos.lat, n27->pos.lat);
-  assert_cmpnum(nn2->pos.lon, n27->pos.lon);
+  assert_cmpnum(nn2->pos.toPos().lat, n27->pos.toPos().lat);
+  assert_cmpnum(nn2->pos.toPos().lon, n27->pos.toPos().lon);
   // the node was part of the deleted way 351899455 and nothing else, the reference count must now be 0
   assert_cmpnum(n27->ways, 0);
   const node_t * const n29 = osm->object_by_id<node_t>(3577031229LL);
@@ -179,6 +179,8 @@ project_t *setup_for_restore(const char *argv2, const std::string &osm_path)
 
   if (!project->parse_osm())
     return nullptr;
+  // the snapshot is created next to the OSM file, which is in the source directory
+  unlink((project->path + project->name + ".snapshot").c_str());
 
   osm_t::ref osm = project->osm;
   assert(osm);
@@ -364,6 +366,7 @@ int main(int argc, char **argv)
 
     unlink(osmpath.c_str());
     unlink(bdiff.c_str());
+    unlink((sproject->path + sproject->name + ".snapshot").c_str());
     bpath.erase(bpath.rfind('/'));
     rmdir(bpath.c_str());
     bpath.erase(bpath.rfind('/'));
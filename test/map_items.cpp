@@ -554,6 +554,121 @@ void test_map_node_create_outside(const std::string &tmpdir)
   assert(!a.iconbar->isTrashEnabled());
 }
 
+void test_way_lod()
+{
+  // a straight line with small zigzags
+  std::vector<lpos_t> points;
+  for(int i = 0; i <= 20; i++)
+    points.push_back(lpos_t(i * 10, (i % 2) * 2));
+
+  way_lod_t lod(points);
+  assert_cmpnum(lod.points.size(), points.size());
+  assert_cmpnum(lod.importance.size(), points.size());
+
+  // nothing is removed without tolerance
+  std::vector<lpos_t> simple = lod.simplified(0);
+  assert_cmpnum(simple.size(), points.size());
+
+  // the zigzag is smaller than the tolerance, only the endpoints are kept
+  simple = lod.simplified(3);
+  assert_cmpnum(simple.size(), 2);
+  assert(simple.front() == points.front());
+  assert(simple.back() == points.back());
+
+  // the spike is kept, the zigzag around it is not
+  points[10].y = 50;
+  const way_lod_t spiked(points);
+  simple = spiked.simplified(40);
+  assert_cmpnum(simple.size(), 3);
+  assert(simple[0] == points.front());
+  assert(simple[1] == points[10]);
+  assert(simple[2] == points.back());
+
+  // the endpoints are always kept
+  simple = spiked.simplified(1000);
+  assert_cmpnum(simple.size(), 2);
+  assert(simple.front() == points.front());
+  assert(simple.back() == points.back());
+
+  // a point can't be more important than the one it depends on
+  for(unsigned int i = 1; i < points.size() - 1; i++)
+    assert_cmpnum_op(spiked.importance[i], <=, spiked.importance[10]);
+
+  // closed ways keep their shape
+  std::vector<lpos_t> square;
+  square.push_back(lpos_t(0, 0));
+  square.push_back(lpos_t(50, 1));
+  square.push_back(lpos_t(100, 0));
+  square.push_back(lpos_t(100, 100));
+  square.push_back(lpos_t(50, 99));
+  square.push_back(lpos_t(0, 100));
+  square.push_back(lpos_t(0, 0));
+  const way_lod_t sqlod(square);
+  simple = sqlod.simplified(2);
+  assert_cmpnum(simple.size(), 5);
+  assert(simple.front() == simple.back());
+}
+
+// only the objects close to the visible area get canvas items
+void test_map_cull(const std::string &tmpdir)
+{
+  appdata_t a;
+  a.project.reset(new project_t("foo", tmpdir));
+  canvas_holder canvas;
+  std::unique_ptr<test_map> m(std::make_unique<test_map>(a, *canvas, test_map::EmptyStyle));
+  a.project->osm.reset(new osm_t());
+  osm_t::ref o = a.project->osm;
+  set_bounds(o);
+  canvas->set_bounds(o->bounds.min, o->bounds.max);
+  iconbar_t::create(a);
+
+  node_t * const near = o->node_new(lpos_t(10, 10));
+  o->attach(near);
+  node_t * const far = o->node_new(lpos_t(100000, 100000));
+  o->attach(far);
+  node_t * const far2 = o->node_new(lpos_t(100000, 100010));
+  o->attach(far2);
+
+  // ways are drawn if their bounding box intersects the visible area
+  way_t * const w1 = new way_t();
+  w1->node_chain.push_back(near);
+  w1->node_chain.push_back(far);
+  o->attach(w1);
+  way_t * const w2 = new way_t();
+  w2->node_chain.push_back(far);
+  w2->node_chain.push_back(far2);
+  o->attach(w2);
+
+  // the default threshold is not reached, so everything is drawn
+  m->paint();
+  assert(near->map_item != nullptr);
+  assert(far->map_item != nullptr);
+  assert(w1->map_item != nullptr);
+  assert(w2->map_item != nullptr);
+
+  m->cull_threshold = 0;
+  m->paint();
+  assert(near->map_item != nullptr);
+  assert_null(far->map_item);
+  assert(w1->map_item != nullptr);
+  assert_null(w2->map_item);
+
+  // the visible area did not change
+  m->viewport_changed();
+  assert_null(far->map_item);
+  assert_null(w2->map_item);
+
+  // explicitly drawn objects get an item anyway
+  m->draw(w2);
+  assert(w2->map_item != nullptr);
+
+  MainUiDummy * const ui = static_cast<MainUiDummy *>(a.uicontrol.get());
+  expectMapItemDeselect(ui);
+  m->clear(map_t::MAP_LAYER_OBJECTS_ONLY);
+  assert_null(near->map_item);
+  assert_null(w1->map_item);
+}
+
 void test_map_reverse(const std::string &tmpdir)
 {
   appdata_t a;
@@ -667,6 +782,8 @@ int main(int argc, char **argv)
   test_map_press_way_add_cancel(osm_path);
   test_map_node_create_outside(osm_path);
   test_map_reverse(osm_path);
+  test_way_lod();
+  test_map_cull(osm_path);
 
   assert_cmpnum(rmdir(tmpdir), 0);
 
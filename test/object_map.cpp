@@ -0,0 +1,113 @@
+#include <object_map.h>
+
+#include <osm2go_annotations.h>
+
+#include <cassert>
+#include <map>
+#include <vector>
+
+namespace {
+
+struct dummy_t {
+  explicit dummy_t(int64_t i) : id(i) {}
+  int64_t id;
+};
+
+// checks that the contents and the order match the one of std::map
+void compare(const object_map<dummy_t> &map, const std::map<int64_t, dummy_t *> &ref)
+{
+  assert_cmpnum(map.size(), ref.size());
+  assert(map.empty() == ref.empty());
+
+  std::map<int64_t, dummy_t *>::const_iterator rit = ref.begin();
+  for(object_map<dummy_t>::const_iterator it = map.begin(); it != map.end(); it++, rit++) {
+    assert(rit != ref.end());
+    assert_cmpnum(it->first, rit->first);
+    assert(it->second == rit->second);
+    assert(map.find(rit->first) == it);
+  }
+  assert(rit == ref.end());
+}
+
+void test_order()
+{
+  object_map<dummy_t> map;
+  std::map<int64_t, dummy_t *> ref;
+  std::vector<dummy_t> objs;
+
+  const int64_t ids[] = { 5, 7, 12, -1, -2, 6, -5, 1, -3, 100, -4 };
+  for(unsigned int i = 0; i < sizeof(ids) / sizeof(ids[0]); i++)
+    objs.push_back(dummy_t(ids[i]));
+
+  compare(map, ref);
+
+  for(unsigned int i = 0; i < objs.size(); i++) {
+    std::pair<object_map<dummy_t>::iterator, bool> r = map.insert(std::make_pair(objs[i].id, &objs[i]));
+    assert(r.second);
+    assert_cmpnum(r.first->first, objs[i].id);
+    assert(r.first->second == &objs[i]);
+    ref[objs[i].id] = &objs[i];
+    compare(map, ref);
+  }
+
+  // duplicate keys are not inserted
+  std::pair<object_map<dummy_t>::iterator, bool> r = map.insert(std::make_pair(objs[0].id, nullptr));
+  assert(!r.second);
+  assert(r.first->second == &objs[0]);
+  r = map.insert(std::make_pair(objs[3].id, nullptr));
+  assert(!r.second);
+  assert(r.first->second == &objs[3]);
+
+  assert(map.find(2) == map.end());
+  assert(map.find(-6) == map.end());
+  assert(map.find(1000) == map.end());
+
+  // the first element is the one with the lowest id
+  assert_cmpnum(map.begin()->first, -5);
+
+  assert_cmpnum(map.erase(-3), 1);
+  ref.erase(-3);
+  compare(map, ref);
+  assert_cmpnum(map.erase(-3), 0);
+  assert_cmpnum(map.erase(7), 1);
+  ref.erase(7);
+  compare(map, ref);
+  assert_cmpnum(map.erase(-5), 1);
+  ref.erase(-5);
+  compare(map, ref);
+  assert_cmpnum(map.erase(100), 1);
+  ref.erase(100);
+  compare(map, ref);
+
+  // operator[] behaves like the std::map version
+  map[-10] = &objs[1];
+  ref[-10] = &objs[1];
+  compare(map, ref);
+  assert(map[5] == &objs[0]);
+  assert(map[8] == nullptr);
+  ref[8] = nullptr;
+  compare(map, ref);
+
+  // walking backwards
+  object_map<dummy_t>::const_iterator it = map.end();
+  std::map<int64_t, dummy_t *>::const_reverse_iterator rit = ref.rbegin();
+  while(it != map.begin()) {
+    it--;
+    assert_cmpnum(it->first, rit->first);
+    rit++;
+  }
+  assert(rit == ref.rend());
+
+  map.clear();
+  ref.clear();
+  compare(map, ref);
+}
+
+} // namespace
+
+int main()
+{
+  test_order();
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include <osm.h>
+#include <osm_objects.h>
+
+#include <osm2go_annotations.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief compare the object containers of osm_t to std::map
+ *
+ * This mimics the container accesses of loading data and drawing it:
+ * objects are added in ascending id order, every node reference of a way is
+ * looked up by id, and finally all objects are iterated.
+ */
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double elapsed_ms(clock_type::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+struct bench_data {
+  std::vector<node_t *> nodes;
+  std::vector<way_t *> ways;
+  std::vector<item_id_t> refs; ///< the node references of all ways
+
+  explicit bench_data(unsigned int count);
+  ~bench_data();
+};
+
+bench_data::bench_data(unsigned int count)
+{
+  base_attributes attr;
+  attr.version = 1;
+  // ids have gaps like real data
+  attr.id = 1000;
+  for(unsigned int i = 0; i < count; i++) {
+    attr.id += 1 + (i * 7) % 13;
+    nodes.push_back(new node_t(attr));
+  }
+  attr.id = 500;
+  // a simple LCG to get deterministic, scattered references
+  uint32_t seed = 42;
+  for(unsigned int i = 0; i < count / 8; i++) {
+    attr.id += 1 + i % 5;
+    ways.push_back(new way_t(attr));
+    for(unsigned int j = 0; j < 10; j++) {
+      seed = seed * 1103515245 + 12345;
+      refs.push_back(nodes[(seed >> 8) % nodes.size()]->id);
+    }
+  }
+}
+
+bench_data::~bench_data()
+{
+  std::for_each(nodes.begin(), nodes.end(), std::default_delete<node_t>());
+  std::for_each(ways.begin(), ways.end(), std::default_delete<way_t>());
+}
+
+template<typename NodeMap, typename WayMap>
+void run(const char *name, const bench_data &data)
+{
+  NodeMap nmap;
+  WayMap wmap;
+
+  clock_type::time_point start = clock_type::now();
+  for(std::vector<node_t *>::const_iterator it = data.nodes.begin(); it != data.nodes.end(); it++)
+    nmap.insert(std::make_pair((*it)->id, *it));
+  unsigned int found = 0;
+  std::vector<item_id_t>::const_iterator rit = data.refs.begin();
+  for(std::vector<way_t *>::const_iterator it = data.ways.begin(); it != data.ways.end(); it++) {
+    for(unsigned int j = 0; j < 10; j++, rit++) {
+      typename NodeMap::const_iterator nit = nmap.find(*rit);
+      if(likely(nit != nmap.end()))
+        found++;
+    }
+    wmap.insert(std::make_pair((*it)->id, *it));
+  }
+  const double parse = elapsed_ms(start);
+  assert_cmpnum(found, data.refs.size());
+
+  start = clock_type::now();
+  unsigned int flags = 0;
+  for(typename WayMap::const_iterator it = wmap.begin(); it != wmap.end(); it++)
+    flags |= it->second->flags;
+  for(typename NodeMap::const_iterator it = nmap.begin(); it != nmap.end(); it++)
+    flags |= it->second->flags;
+  const double paint = elapsed_ms(start);
+  assert_cmpnum(flags, 0);
+
+  printf("%-12s parse %9.3f ms  paint %9.3f ms\n", name, parse, paint);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  unsigned int count = 1000000;
+  if(argc > 1)
+    count = strtoul(argv[1], nullptr, 10);
+
+  bench_data data(count);
+  printf("%u nodes, %zu ways, %zu node references\n", count, data.ways.size(), data.refs.size());
+
+  run<std::map<item_id_t, node_t *>, std::map<item_id_t, way_t *> >("std::map", data);
+  run<object_map<node_t>, object_map<way_t> >("object_map", data);
+
+  return 0;
+}
+
+#include "dummy_appdata.h"
@@ -0,0 +1,135 @@
+#include <object_pool.h>
+#include <osm.h>
+#include <osm_objects.h>
+
+#include <osm2go_annotations.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct big_t {
+  double d[4];
+};
+
+void test_reuse()
+{
+  object_pool *pool = object_pool::create(sizeof(big_t));
+
+  assert_cmpnum(pool->size(), 0);
+  assert_cmpnum(pool->slabCount(), 0);
+
+  void *a = pool->allocate();
+  void *b = pool->allocate();
+  assert(a != b);
+  assert_cmpnum(reinterpret_cast<uintptr_t>(a) % alignof(big_t), 0);
+  assert_cmpnum(reinterpret_cast<uintptr_t>(b) % alignof(big_t), 0);
+  assert_cmpnum(pool->size(), 2);
+  assert_cmpnum(pool->slabCount(), 1);
+
+  // released objects are handed out again
+  object_pool::release(a);
+  assert_cmpnum(pool->size(), 1);
+  void *c = pool->allocate();
+  assert(c == a);
+
+  object_pool::release(b);
+  object_pool::release(c);
+  assert_cmpnum(pool->size(), 0);
+  assert_cmpnum(pool->slabCount(), 0);
+
+  object_pool::release(nullptr);
+
+  pool->disown();
+}
+
+void test_slabs()
+{
+  object_pool *pool = object_pool::create(sizeof(big_t));
+  std::vector<void *> objs;
+
+  for(unsigned int i = 0; i < 10000; i++) {
+    big_t *o = static_cast<big_t *>(pool->allocate());
+    // make sure the memory does not overlap
+    o->d[0] = i;
+    o->d[3] = i;
+    objs.push_back(o);
+  }
+  assert_cmpnum(pool->size(), objs.size());
+  assert(pool->slabCount() > 1);
+  unsigned int slabs = pool->slabCount();
+
+  for(unsigned int i = 0; i < objs.size(); i++) {
+    assert_cmpnum(static_cast<big_t *>(objs[i])->d[0], i);
+    assert_cmpnum(static_cast<big_t *>(objs[i])->d[3], i);
+  }
+
+  // the slabs are kept as long as any object is alive
+  for(unsigned int i = 1; i < objs.size(); i++)
+    object_pool::release(objs[i]);
+  assert_cmpnum(pool->size(), 1);
+  assert_cmpnum(pool->slabCount(), slabs);
+
+  object_pool::release(objs.front());
+  assert_cmpnum(pool->size(), 0);
+  assert_cmpnum(pool->slabCount(), 0);
+
+  pool->disown();
+}
+
+void test_owners()
+{
+  object_pool *pool1 = object_pool::create(sizeof(big_t));
+  object_pool *pool2 = object_pool::create(sizeof(big_t));
+
+  // every object goes back to the pool it was allocated from
+  void *a = pool1->allocate();
+  void *b = pool2->allocate();
+  object_pool::release(a);
+  assert_cmpnum(pool1->size(), 0);
+  assert_cmpnum(pool2->size(), 1);
+
+  // the pool stays alive as long as objects still use it
+  pool2->disown();
+  memset(b, 0x55, sizeof(big_t));
+  object_pool::release(b);
+
+  pool1->disown();
+}
+
+void test_osm()
+{
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  object_pool * const nodes = osm->pools.nodes;
+
+  // objects created by an osm_t are allocated from its pools
+  node_t *n = osm->node_new(lpos_t(10, 10));
+  assert_cmpnum(nodes->size(), 1);
+  osm->attach(n);
+
+  // other objects are not
+  std::unique_ptr<node_t> other(new node_t(base_attributes()));
+  assert_cmpnum(nodes->size(), 1);
+
+  way_t *w = new(osm->pools.ways) way_t();
+  assert_cmpnum(osm->pools.ways->size(), 1);
+  delete w;
+  assert_cmpnum(osm->pools.ways->size(), 0);
+
+  osm.reset();
+}
+} // namespace
+
+int main()
+{
+  test_reuse();
+  test_slabs();
+  test_owners();
+  test_osm();
+
+  return 0;
+}
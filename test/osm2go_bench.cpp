@@ -0,0 +1,310 @@
+#include "dummy_map.h"
+#include "osm_generator.h"
+#include "test_lcg.h"
+
+#include <canvas.h>
+#include <map.h>
+#include <osm.h>
+#include <osm_objects.h>
+#include <project.h>
+#include <style.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <osm2go_annotations.h>
+#include <osm2go_cpp.h>
+#include <osm2go_test.h>
+
+/**
+ * @brief measure the major steps of working with a large project
+ *
+ * A city-like data set of the requested size is generated. It is loaded,
+ * styled, and painted on a canvas that is never shown, then some edits are
+ * done and saved to the diff file. The time of each step is reported as
+ * JSON, either on stdout or into the given file.
+ */
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double elapsed_ms(clock_type::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+struct bench_result {
+  bench_result() : nodes(0), ways(0), relations(0), edits(0), generate(0), load(0), styleLoad(0)
+    , style(0), paint(0), edit(0), diffSave(0), osmSize(0), diffSize(0) {}
+
+  unsigned int nodes, ways, relations, edits;
+  double generate, load, styleLoad, style, paint, edit, diffSave;
+  off_t osmSize, diffSize;
+};
+
+struct colorizer {
+  const style_t * const style;
+  explicit inline colorizer(const style_t *s) : style(s) {}
+  inline void operator()(const std::pair<const item_id_t, node_t *> &pair) const
+  {
+    style->colorize(pair.second);
+  }
+  inline void operator()(const std::pair<const item_id_t, way_t *> &pair) const
+  {
+    style->colorize(pair.second);
+  }
+};
+
+off_t file_size(const std::string &fname)
+{
+  struct stat st;
+  if(stat(fname.c_str(), &st) != 0)
+    return -1;
+  return st.st_size;
+}
+
+/**
+ * @brief do the kind of edits a user would do, including the map updates
+ * @returns the number of edits
+ *
+ * About 1% of the ways get their tags changed, 1% of the nodes are moved, and
+ * 0.2% of the ways are deleted. New nodes are added, too.
+ */
+unsigned int do_edits(osm_t::ref osm, map_t *map)
+{
+  lcg rnd(7);
+  unsigned int edits = 0;
+
+  // the maps may not be modified while iterating over them
+  std::vector<node_t *> nodes;
+  nodes.reserve(osm->nodes.size() / 100 + 1);
+  std::vector<way_t *> ways;
+  ways.reserve(osm->ways.size() / 100 + 1);
+  unsigned int i = 0;
+  const object_map<node_t>::const_iterator nitEnd = osm->nodes.end();
+  for(object_map<node_t>::const_iterator it = osm->nodes.begin(); it != nitEnd; it++, i++)
+    if(i % 100 == 0)
+      nodes.push_back(it->second);
+  i = 0;
+  const object_map<way_t>::const_iterator witEnd = osm->ways.end();
+  for(object_map<way_t>::const_iterator it = osm->ways.begin(); it != witEnd; it++, i++)
+    if(i % 100 == 0)
+      ways.push_back(it->second);
+
+  for(std::vector<node_t *>::const_iterator it = nodes.begin(); it != nodes.end(); it++) {
+    node_t * const node = *it;
+    const lpos_t lpos(node->lpos.x + rnd.offset(10), node->lpos.y + rnd.offset(10));
+    if(!osm->bounds.contains(lpos))
+      continue;
+    osm->mark_dirty(node);
+    osm->node_move(node, lpos.toPos(osm->bounds));
+    map->redraw_item(node);
+    const way_chain_t &nways = osm->node_ways(node);
+    for(way_chain_t::const_iterator wit = nways.begin(); wit != nways.end(); wit++)
+      map->redraw_item(*wit);
+    edits++;
+  }
+
+  for(std::vector<way_t *>::const_iterator it = ways.begin(); it != ways.end(); it++) {
+    way_t * const way = *it;
+    if(way->isDeleted())
+      continue;
+    if(rnd.next(5) == 0) {
+      osm->way_delete(way, map);
+    } else {
+      osm_t::TagMap tags = way->tags.asMap();
+      tags.insert(osm_t::TagMap::value_type("note", "checked"));
+      tags.insert(osm_t::TagMap::value_type("source", "survey"));
+      osm->updateTags(object_t(way), tags);
+      map->redraw_item(way);
+    }
+    edits++;
+  }
+
+  const unsigned int newNodes = nodes.size() / 10 + 1;
+  for(unsigned int n = 0; n < newNodes; n++) {
+    const lpos_t lpos(osm->bounds.min.x + static_cast<int>(rnd.next(osm->bounds.max.x - osm->bounds.min.x + 1)),
+                      osm->bounds.min.y + static_cast<int>(rnd.next(osm->bounds.max.y - osm->bounds.min.y + 1)));
+    node_t *node = osm->node_new(lpos);
+    osm->attach(node);
+    osm_t::TagMap tags;
+    tags.insert(osm_t::TagMap::value_type("amenity", "bench"));
+    node->tags.replace(tags);
+    map->draw(node);
+    edits++;
+  }
+
+  return edits;
+}
+
+int run(const std::string &tmpdir, const char *stylename, unsigned int nodes, unsigned int ways,
+        unsigned int relations, bench_result &result)
+{
+  const std::string name = "bench";
+  const std::string projectdir = tmpdir + name + '/';
+  const std::string osmfile = projectdir + name + ".osm";
+  mkdir(projectdir.c_str(), S_IRWXU);
+
+  clock_type::time_point start = clock_type::now();
+  {
+    const osm_generator gen(nodes, ways, relations);
+    if(!gen.write(osmfile.c_str())) {
+      std::cerr << "cannot write " << osmfile << std::endl;
+      return 1;
+    }
+  }
+  result.generate = elapsed_ms(start);
+  result.osmSize = file_size(osmfile);
+
+  appdata_t appdata;
+  appdata.project.reset(new project_t(name, tmpdir));
+  project_t::ref project = appdata.project;
+  project->osmFile = name + ".osm";
+
+  start = clock_type::now();
+  std::unique_ptr<osm_t> osm(osm_t::parse(project->path, project->osmFile));
+  result.load = elapsed_ms(start);
+  if(!osm) {
+    std::cerr << "cannot load " << osmfile << std::endl;
+    return 1;
+  }
+  project->osm.reset(osm.release());
+  osm_t::ref o = project->osm;
+  result.nodes = o->nodes.size();
+  result.ways = o->ways.size();
+  result.relations = o->relations.size();
+
+  start = clock_type::now();
+  appdata.style.reset(style_t::load(stylename));
+  result.styleLoad = elapsed_ms(start);
+  if(!appdata.style) {
+    std::cerr << "cannot load style " << stylename << std::endl;
+    return 1;
+  }
+
+  start = clock_type::now();
+  std::for_each(o->ways.begin(), o->ways.end(), colorizer(appdata.style.get()));
+  std::for_each(o->nodes.begin(), o->nodes.end(), colorizer(appdata.style.get()));
+  result.style = elapsed_ms(start);
+
+  canvas_holder canvas;
+  std::unique_ptr<test_map> map(std::make_unique<test_map>(appdata, *canvas));
+
+  start = clock_type::now();
+  map->paint();
+  result.paint = elapsed_ms(start);
+
+  start = clock_type::now();
+  result.edits = do_edits(o, map.get());
+  result.edit = elapsed_ms(start);
+
+  const std::string difffile = projectdir + name + ".diff";
+  start = clock_type::now();
+  project->diff_save();
+  result.diffSave = elapsed_ms(start);
+  result.diffSize = file_size(difffile);
+
+  // the canvas items are owned by the canvas
+  map.reset();
+
+  unlink(difffile.c_str());
+  unlink(osmfile.c_str());
+  rmdir(projectdir.c_str());
+
+  return 0;
+}
+
+void write_json(FILE *f, const bench_result &r)
+{
+  fprintf(f, "{\n"
+             "  \"nodes\": %u,\n"
+             "  \"ways\": %u,\n"
+             "  \"relations\": %u,\n"
+             "  \"osm_bytes\": %lld,\n"
+             "  \"edits\": %u,\n"
+             "  \"diff_bytes\": %lld,\n"
+             "  \"times_ms\": {\n"
+             "    \"generate\": %.3f,\n"
+             "    \"load\": %.3f,\n"
+             "    \"style_load\": %.3f,\n"
+             "    \"style\": %.3f,\n"
+             "    \"paint\": %.3f,\n"
+             "    \"edit\": %.3f,\n"
+             "    \"diff_save\": %.3f\n"
+             "  }\n"
+             "}\n",
+          r.nodes, r.ways, r.relations, static_cast<long long>(r.osmSize), r.edits,
+          static_cast<long long>(r.diffSize), r.generate, r.load, r.styleLoad, r.style, r.paint,
+          r.edit, r.diffSave);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if(argc < 2 || argc > 6) {
+    std::cerr << "usage: " << argv[0] << " style [nodes [ways [relations [result.json]]]]" << std::endl;
+    return 1;
+  }
+
+  unsigned int nodes = 200000;
+  if(argc > 2)
+    nodes = strtoul(argv[2], nullptr, 10);
+  unsigned int ways = nodes / 6;
+  if(argc > 3)
+    ways = strtoul(argv[3], nullptr, 10);
+  unsigned int relations = ways / 50;
+  if(argc > 4)
+    relations = strtoul(argv[4], nullptr, 10);
+
+  char tmpdir[] = "/tmp/osm2go-bench-XXXXXX";
+
+  if(mkdtemp(tmpdir) == nullptr) {
+    std::cerr << "cannot create temporary directory" << std::endl;
+    return 1;
+  }
+
+  OSM2GO_TEST_INIT(argc, argv);
+
+  xmlInitParser();
+
+  bench_result result;
+  int ret = 1;
+  OSM2GO_TEST_CODE(
+    ret = run(tmpdir + std::string("/"), argv[1], nodes, ways, relations, result);
+  )
+
+  rmdir(tmpdir);
+
+  if(ret != 0)
+    return ret;
+
+  // the library prints progress information on stdout, so the result should
+  // go into a file to be machine readable
+  if(argc > 5) {
+    FILE *f = fopen(argv[5], "w");
+    if(f == nullptr) {
+      std::cerr << "cannot write " << argv[5] << std::endl;
+      return 1;
+    }
+    write_json(f, result);
+    fclose(f);
+  } else {
+    write_json(stdout, result);
+  }
+
+  xmlCleanupParser();
+
+  return 0;
+}
+
+#include "dummy_appdata.h"
@@ -2646,6 +2646,612 @@ void test_updateMembers()
   }
 }
 
+void test_node_ways()
+{
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  set_bounds(osm);
+
+  std::vector<node_t *> nodes;
+  for(int i = 0; i < 4; i++) {
+    node_t *n = osm->node_new(lpos_t(10 * i, 10));
+    osm->attach(n);
+    nodes.push_back(n);
+  }
+
+  way_t *w1 = new way_t();
+  w1->append_node(nodes[0]);
+  w1->append_node(nodes[1]);
+  w1->append_node(nodes[2]);
+  osm->attach(w1);
+
+  way_t *w2 = new way_t();
+  w2->append_node(nodes[2]);
+  w2->append_node(nodes[3]);
+  osm->attach(w2);
+
+  assert(osm->node_ways(nodes[0]) == way_chain_t(1, w1));
+  assert(osm->node_ways(nodes[3]) == way_chain_t(1, w2));
+  way_chain_t wc = osm->node_ways(nodes[2]);
+  assert_cmpnum(wc.size(), 2);
+  // sorted by id
+  assert(wc.front() == w2);
+  assert(wc.back() == w1);
+
+  // modifying the node chain directly is detected by the reference count
+  w2->append_node(nodes[0]);
+  wc = osm->node_ways(nodes[0]);
+  assert_cmpnum(wc.size(), 2);
+  assert(std::find(wc.begin(), wc.end(), w2) != wc.end());
+
+  // outdated entries are ignored
+  w1->node_chain.erase(w1->node_chain.begin());
+  nodes[0]->ways--;
+  assert(osm->node_ways(nodes[0]) == way_chain_t(1, w2));
+
+  // splitting moves nodes to the new way
+  node_t *n = w1->insert_node(osm, 1, lpos_t(15, 10));
+  assert(osm->node_ways(n) == way_chain_t(1, w1));
+  way_t *w3 = w1->split(osm, std::next(w1->node_chain.begin()), true);
+  assert(w3 != nullptr);
+  wc = osm->node_ways(n);
+  assert_cmpnum(wc.size(), 2);
+  assert(std::find(wc.begin(), wc.end(), w3) != wc.end());
+
+  // deleting a node removes it from exactly those ways
+  osm->node_delete(n);
+  assert(!w1->contains_node(n));
+  assert(!w3->contains_node(n));
+}
+
+void test_object_relations()
+{
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  set_bounds(osm);
+
+  node_t *n = osm->node_new(lpos_t(10, 10));
+  osm->attach(n);
+
+  relation_t *r1 = new relation_t();
+  r1->members.push_back(member_t(object_t(n), "foo"));
+  osm->attach(r1);
+
+  // members are registered when the relation is added
+  relation_t *r2 = new relation_t();
+  osm->attach(r2);
+  assert(osm->object_relations(object_t(n)) == std::vector<relation_t *>(1, r1));
+
+  // members added directly to the list are found by checking the relations
+  r2->members.push_back(member_t(object_t(n)));
+  r2->members.push_back(member_t(object_t(n), "bar"));
+  std::vector<relation_t *> rels = osm->object_relations(object_t(n));
+  assert_cmpnum(rels.size(), 2);
+  // sorted by id, every relation only once
+  assert(rels.front() == r2);
+  assert(rels.back() == r1);
+
+  // members stored by id are found for the real object
+  relation_t *r3 = new relation_t();
+  r3->members.push_back(member_t(object_t(object_t::NODE_ID, n->id)));
+  osm->attach(r3);
+  assert_cmpnum(osm->object_relations(object_t(n)).size(), 3);
+
+  // outdated entries are ignored
+  r1->eraseMember(r1->members.begin());
+  rels = osm->object_relations(object_t(n));
+  assert_cmpnum(rels.size(), 2);
+  assert(std::find(rels.begin(), rels.end(), r1) == rels.end());
+
+  // removing the object from all relations
+  osm->remove_from_relations(object_t(n));
+  assert(osm->object_relations(object_t(n)).empty());
+  assert(r2->members.empty());
+  assert(r3->members.empty());
+}
+
+void test_fixed_pos()
+{
+  // invalid positions stay invalid
+  assert(!pos_fixed_t().valid());
+  assert(!pos_fixed_t(pos_t(NAN, NAN)).valid());
+  assert(std::isnan(pos_fixed_t().toPos().lat));
+  assert(pos_fixed_t(pos_t(NAN, 9.5)) != pos_fixed_t(pos_t(52.5, 9.5)));
+
+  const pos_t positions[] = {
+    pos_t(52.2693518, 9.576014),
+    pos_t(-33.8688197, 151.2092955),
+    pos_t(90, -180),
+    pos_t(-0.00000005, 0.12345675),
+    pos_t(1.23456789012, -45.987654321)
+  };
+
+  for(unsigned int i = 0; i < sizeof(positions) / sizeof(positions[0]); i++) {
+    const pos_fixed_t fp(positions[i]);
+    assert(fp.valid());
+    // converting back does not lose anything further
+    assert(pos_fixed_t(fp.toPos()) == fp);
+    assert_cmpnum_op(std::abs(fp.toPos().lat - positions[i].lat), <, 0.0000001);
+    assert_cmpnum_op(std::abs(fp.toPos().lon - positions[i].lon), <, 0.0000001);
+
+    // the XML representation is the same as the one of the original value
+    xmlNodePtr fnode = xmlNewNode(nullptr, BAD_CAST "node");
+    xmlNodePtr pnode = xmlNewNode(nullptr, BAD_CAST "node");
+    fp.toXmlProperties(fnode);
+    positions[i].toXmlProperties(pnode);
+    xmlString flat(xmlGetProp(fnode, BAD_CAST "lat"));
+    xmlString plat(xmlGetProp(pnode, BAD_CAST "lat"));
+    xmlString flon(xmlGetProp(fnode, BAD_CAST "lon"));
+    xmlString plon(xmlGetProp(pnode, BAD_CAST "lon"));
+    assert_cmpstr(flat, plat);
+    assert_cmpstr(flon, plon);
+    xmlFreeNode(fnode);
+    xmlFreeNode(pnode);
+  }
+
+  // values from the OSM data are exactly preserved
+  assert_cmpnum(pos_fixed_t(positions[0]).toPos().lat, 52.2693518);
+  assert_cmpnum(pos_fixed_t(positions[0]).toPos().lon, 9.576014);
+}
+
+void test_nodes_near()
+{
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  set_bounds(osm);
+
+  node_t * const n1 = osm->node_new(lpos_t(10, 10));
+  osm->attach(n1);
+  node_t * const n2 = osm->node_new(lpos_t(12, 10));
+  osm->attach(n2);
+  node_t * const n3 = osm->node_new(lpos_t(100, 100));
+  osm->attach(n3);
+  // on the other side of a cell border
+  node_t * const n4 = osm->node_new(lpos_t(-1, 10));
+  osm->attach(n4);
+
+  std::vector<node_t *> near = osm->nodes_near(lpos_t(11, 10), 4);
+  assert_cmpnum(near.size(), 2);
+  // sorted by id
+  assert(near.front() == n2);
+  assert(near.back() == n1);
+
+  near = osm->nodes_near(lpos_t(1, 10), 4);
+  assert_cmpnum(near.size(), 1);
+  assert(near.front() == n4);
+
+  // the exact distance is checked, not only the bounding box
+  near = osm->nodes_near(lpos_t(103, 103), 4);
+  assert(near.empty());
+  near = osm->nodes_near(lpos_t(102, 102), 4);
+  assert_cmpnum(near.size(), 1);
+
+  osm->node_move(n3, n1->pos.toPos());
+  near = osm->nodes_near(lpos_t(100, 100), 4);
+  assert(near.empty());
+  near = osm->nodes_near(n1->lpos, 4);
+  assert_cmpnum(near.size(), 3);
+  assert(std::find(near.begin(), near.end(), n3) != near.end());
+
+  // new nodes are removed completely
+  osm->node_delete(n1);
+  near = osm->nodes_near(lpos_t(11, 10), 4);
+  assert_cmpnum(near.size(), 2);
+  assert(std::find(near.begin(), near.end(), n1) == near.end());
+
+  // existing ones are kept, but marked as deleted
+  base_attributes ba(1234);
+  ba.version = 1;
+  node_t * const n5 = osm->node_new(lpos_t(200, 200).toPos(osm->bounds), ba);
+  osm->insert(n5);
+  near = osm->nodes_near(n5->lpos, 2);
+  assert_cmpnum(near.size(), 1);
+  assert(near.front() == n5);
+  osm->node_delete(n5);
+  near = osm->nodes_near(n5->lpos, 2);
+  assert(near.empty());
+}
+
+void test_nodes_in_area()
+{
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  set_bounds(osm);
+
+  node_t * const n1 = osm->node_new(lpos_t(10, 10));
+  osm->attach(n1);
+  node_t * const n2 = osm->node_new(lpos_t(40, 10));
+  osm->attach(n2);
+  node_t * const n3 = osm->node_new(lpos_t(-5, -5));
+  osm->attach(n3);
+
+  std::vector<node_t *> nodes = osm->nodes_in_area(lpos_t(0, 0), lpos_t(40, 10));
+  assert_cmpnum(nodes.size(), 2);
+  assert(std::find(nodes.begin(), nodes.end(), n1) != nodes.end());
+  assert(std::find(nodes.begin(), nodes.end(), n2) != nodes.end());
+
+  nodes = osm->nodes_in_area(lpos_t(-10, -10), lpos_t(100, 100));
+  assert_cmpnum(nodes.size(), 3);
+
+  // an area covering many more cells than exist
+  nodes = osm->nodes_in_area(lpos_t(-100000, -100000), lpos_t(100000, 100000));
+  assert_cmpnum(nodes.size(), 3);
+
+  nodes = osm->nodes_in_area(lpos_t(11, 11), lpos_t(39, 100));
+  assert(nodes.empty());
+
+  // an empty area
+  nodes = osm->nodes_in_area(lpos_t(100, 100), lpos_t(-100, -100));
+  assert(nodes.empty());
+
+  osm->node_delete(n2);
+  nodes = osm->nodes_in_area(lpos_t(0, 0), lpos_t(40, 10));
+  assert_cmpnum(nodes.size(), 1);
+  assert(nodes.front() == n1);
+
+  // the position was changed without telling the grid, moving the node must
+  // still remove the old entry
+  n3->lpos = lpos_t(1000, 1000);
+  osm->node_move(n3, lpos_t(20, 20).toPos(osm->bounds));
+  nodes = osm->nodes_in_area(lpos_t(-10, -10), lpos_t(-1, -1));
+  assert(nodes.empty());
+  nodes = osm->nodes_in_area(lpos_t(15, 15), lpos_t(25, 25));
+  assert_cmpnum(nodes.size(), 1);
+  assert(nodes.front() == n3);
+
+  // same for deleting it
+  n1->lpos = lpos_t(2000, 2000);
+  osm->node_delete(n1);
+  nodes = osm->nodes_in_area(lpos_t(-100000, -100000), lpos_t(100000, 100000));
+  assert_cmpnum(nodes.size(), 1);
+  assert(nodes.front() == n3);
+}
+
+void test_way_grid()
+{
+  std::unique_ptr<osm_t> osm(std::make_unique<osm_t>());
+  set_bounds(osm);
+  way_grid_t grid;
+
+  // a short way inside a single cell
+  way_t * const w1 = new way_t();
+  osm->attach(w1);
+  for(int i = 0; i < 3; i++) {
+    node_t *n = osm->node_new(lpos_t(10 + i, 10 + 2 * i));
+    osm->attach(n);
+    w1->append_node(n);
+  }
+  grid.update(w1);
+
+  // a way crossing several cells
+  way_t * const w2 = new way_t();
+  osm->attach(w2);
+  node_t *n = osm->node_new(lpos_t(-300, 100));
+  osm->attach(n);
+  w2->append_node(n);
+  n = osm->node_new(lpos_t(600, 700));
+  osm->attach(n);
+  w2->append_node(n);
+  grid.update(w2);
+
+  // a way spanning far more than MaxCells cells
+  way_t * const w3 = new way_t();
+  osm->attach(w3);
+  n = osm->node_new(lpos_t(-5000, -5000));
+  osm->attach(n);
+  w3->append_node(n);
+  n = osm->node_new(lpos_t(5000, 5000));
+  osm->attach(n);
+  w3->append_node(n);
+  grid.update(w3);
+
+  // ways without nodes are ignored
+  way_t * const w4 = new way_t();
+  osm->attach(w4);
+  grid.update(w4);
+
+  assert_cmpnum(grid.size(), 3);
+
+  std::vector<way_t *> ways = grid.find(lpos_t(0, 0), lpos_t(20, 20));
+  assert_cmpnum(ways.size(), 2);
+  assert(std::find(ways.begin(), ways.end(), w1) != ways.end());
+  assert(std::find(ways.begin(), ways.end(), w3) != ways.end());
+  ways = grid.find(lpos_t(0, 0), lpos_t(20, 100));
+  assert_cmpnum(ways.size(), 3);
+  assert(std::find(ways.begin(), ways.end(), w2) != ways.end());
+
+  // w2 is in many cells of the search area, but is reported only once
+  ways = grid.find(lpos_t(-1000, -1000), lpos_t(1000, 1000));
+  assert_cmpnum(ways.size(), 3);
+  ways = grid.find(lpos_t(100, 100), lpos_t(700, 800));
+  assert_cmpnum(ways.size(), 2);
+  assert(std::find(ways.begin(), ways.end(), w1) == ways.end());
+
+  // only the bounding box is checked
+  ways = grid.find(lpos_t(-5100, 6000), lpos_t(-5050, 6100));
+  assert(ways.empty());
+  ways = grid.find(lpos_t(4999, 4999), lpos_t(6000, 6000));
+  assert_cmpnum(ways.size(), 1);
+  assert(ways.front() == w3);
+
+  // moving the nodes updates the box
+  osm->node_move(w1->node_chain.front(), lpos_t(2000, 2000).toPos(osm->bounds));
+  grid.update(w1);
+  ways = grid.find(lpos_t(1990, 1990), lpos_t(2010, 2010));
+  assert_cmpnum(ways.size(), 2);
+  assert(std::find(ways.begin(), ways.end(), w1) != ways.end());
+  assert_cmpnum(grid.size(), 3);
+
+  // renumbering the ways like the upload does must not affect the grid
+  osm->ways.erase(w2->id);
+  w2->id = 4711;
+  w2->flags = 0;
+  osm->ways[w2->id] = w2;
+  ways = grid.find(lpos_t(500, 600), lpos_t(510, 610));
+  assert(std::find(ways.begin(), ways.end(), w2) != ways.end());
+
+  grid.erase(w1);
+  grid.erase(w3);
+  assert_cmpnum(grid.size(), 1);
+  ways = grid.find(lpos_t(-10000, -10000), lpos_t(10000, 10000));
+  assert_cmpnum(ways.size(), 1);
+  assert(ways.front() == w2);
+
+  // deleted ways are dropped on update
+  osm->way_delete(w2, nullptr);
+  assert(w2->isDeleted());
+  grid.update(w2);
+  assert_cmpnum(grid.size(), 0);
+  grid.update(w2);
+  assert_cmpnum(grid.size(), 0);
+
+  grid.clear();
+  assert_cmpnum(grid.size(), 0);
+  ways = grid.find(lpos_t(-10000, -10000), lpos_t(10000, 10000));
+  assert(ways.empty());
+}
+
+/**
+ * @brief check that identical tag lists are shared and changes do not leak
+ *
+ * singleTag() returns a pointer into the list, so it is identical if the
+ * contents are shared.
+ */
+void test_tag_sharing()
+{
+  std::vector<tag_t> ntags;
+  ntags.push_back(tag_t("building", "yes"));
+
+  std::vector<tag_t> ntags2 = ntags;
+  tag_list_t a;
+  a.replace(std::move(ntags));
+  tag_list_t b;
+  b.replace(std::move(ntags2));
+  assert(a == b);
+  assert(a.singleTag() != nullptr);
+  assert(a.singleTag() == b.singleTag());
+
+  // copying filters out the discardable tags, the result is shared again
+  tag_list_t c;
+  ntags.clear();
+  ntags.push_back(tag_t("created_by", "test"));
+  ntags.push_back(tag_t("building", "yes"));
+  c.replace(std::move(ntags));
+  assert(c.hasNonDiscardableTags());
+  tag_list_t d;
+  d.copy(c);
+  assert(d.singleTag() == a.singleTag());
+  tag_list_t e;
+  e.copy(a);
+  assert(e.singleTag() == a.singleTag());
+
+  // merging creates a new list and leaves the others alone
+  tag_list_t f;
+  ntags.clear();
+  ntags.push_back(tag_t("name", "foo"));
+  f.replace(std::move(ntags));
+  assert(!a.merge(f));
+  assert(f.empty());
+  assert_cmpstr(a.get_value("name"), "foo");
+  assert_cmpstr(a.get_value("building"), "yes");
+  assert(b.get_value("name") == nullptr);
+  assert(a != b);
+  assert(e.singleTag() == b.singleTag());
+
+  // reversing only changes the reversed way
+  std::unique_ptr<osm_t> o(std::make_unique<osm_t>());
+  set_bounds(o);
+  way_t *w1 = o->attach(new way_t());
+  way_t *w2 = o->attach(new way_t());
+  ntags.clear();
+  ntags.push_back(tag_t("oneway", "yes"));
+  ntags2 = ntags;
+  w1->tags.replace(std::move(ntags));
+  w2->tags.replace(std::move(ntags2));
+  assert(w1->tags == w2->tags);
+  assert_cmpnum(w1->reverse(o).first, 1);
+  assert_cmpstr(w1->tags.get_value("oneway"), "-1");
+  assert_cmpstr(w2->tags.get_value("oneway"), "yes");
+
+  // releasing one user keeps the contents for the others
+  b.clear();
+  d.clear();
+  assert_cmpstr(e.get_value("building"), "yes");
+  e.replace(osm_t::TagMap());
+  assert(e.empty());
+}
+
+void test_find_by_tag()
+{
+  std::unique_ptr<osm_t> o(std::make_unique<osm_t>());
+  set_bounds(o);
+
+  assert(o->find_by_tag("highway").empty());
+
+  base_attributes ba(42);
+  ba.version = 1;
+  node_t *n1 = o->node_new(pos_t(52.25, 9.58), ba);
+  std::vector<tag_t> ntags;
+  ntags.push_back(tag_t("highway", "bus_stop"));
+  ntags.push_back(tag_t("name", "Central"));
+  n1->tags.replace(std::move(ntags));
+  o->insert(n1);
+
+  node_t *n2 = o->node_new(lpos_t(10, 10));
+  o->attach(n2);
+  osm_t::TagMap tmap;
+  tmap.insert(osm_t::TagMap::value_type("highway", "bus_stop"));
+  o->updateTags(object_t(n2), tmap);
+
+  way_t *w = o->attach(new way_t());
+  tmap.clear();
+  tmap.insert(osm_t::TagMap::value_type("highway", "residential"));
+  o->updateTags(object_t(w), tmap);
+
+  std::vector<object_t> found = o->find_by_tag("highway", "bus_stop");
+  assert_cmpnum(found.size(), 2);
+  // sorted by type and id
+  assert(found.front() == n2);
+  assert(found.back() == n1);
+
+  found = o->find_by_tag("highway");
+  assert_cmpnum(found.size(), 3);
+  assert(found.back() == w);
+
+  assert(o->find_by_tag("highway", "primary").empty());
+  assert(o->find_by_tag("does not exist").empty());
+
+  // changed tags are not found anymore
+  tmap.clear();
+  tmap.insert(osm_t::TagMap::value_type("highway", "platform"));
+  o->updateTags(object_t(n1), tmap);
+  found = o->find_by_tag("highway", "bus_stop");
+  assert_cmpnum(found.size(), 1);
+  assert(found.front() == n2);
+  found = o->find_by_tag("highway", "platform");
+  assert_cmpnum(found.size(), 1);
+  assert(found.front() == n1);
+  assert(o->find_by_tag("name").empty());
+
+  // neither are deleted objects
+  o->node_delete(n2);
+  assert(o->find_by_tag("highway", "bus_stop").empty());
+  o->node_delete(n1);
+  found = o->find_by_tag("highway");
+  assert_cmpnum(found.size(), 1);
+  assert(found.front() == w);
+
+  // changing the tags very often makes the index start over, which must
+  // not change the results
+  for(unsigned int i = 0; i < 3000; i++) {
+    tmap.clear();
+    tmap.insert(osm_t::TagMap::value_type("highway", (i & 1) ? "primary" : "secondary"));
+    tmap.insert(osm_t::TagMap::value_type("ref", std::to_string(i)));
+    o->updateTags(object_t(w), tmap);
+  }
+  found = o->find_by_tag("highway");
+  assert_cmpnum(found.size(), 1);
+  assert(found.front() == w);
+  assert(o->find_by_tag("highway", "primary").size() == 1);
+  assert(o->find_by_tag("highway", "secondary").empty());
+  assert(o->find_by_tag("ref", "2999").size() == 1);
+  assert(o->find_by_tag("ref", "2998").empty());
+  assert(o->find_by_tag("ref").size() == 1);
+
+  // the index is created from the existing objects on the first search
+  o = std::make_unique<osm_t>();
+  set_bounds(o);
+  n1 = o->node_new(pos_t(52.25, 9.58), ba);
+  o->insert(n1);
+  w = o->attach(new way_t());
+  ntags.push_back(tag_t("highway", "bus_stop"));
+  n1->tags.replace(std::move(ntags));
+  ntags.push_back(tag_t("highway", "residential"));
+  w->tags.replace(std::move(ntags));
+  n2 = o->node_new(lpos_t(10, 10));
+  o->attach(n2);
+
+  found = o->find_by_tag("highway");
+  assert_cmpnum(found.size(), 2);
+  assert(found.front() == n1);
+  assert(found.back() == w);
+  found = o->find_by_tag("highway", "residential");
+  assert_cmpnum(found.size(), 1);
+  assert(found.front() == w);
+}
+
+void test_shared_original()
+{
+  std::unique_ptr<osm_t> o(std::make_unique<osm_t>());
+  set_bounds(o);
+
+  base_attributes ba(42);
+  ba.version = 1;
+  way_t * const w = new way_t(ba);
+  for (int i = 0; i < 3; i++) {
+    node_t *n = o->node_new(lpos_t(10 + i, 10));
+    o->attach(n);
+    w->append_node(n);
+  }
+  o->insert(w);
+
+  osm_t::TagMap tags;
+  tags.insert(osm_t::TagMap::value_type("highway", "residential"));
+
+  // changing only the tags does not copy the node chain
+  o->updateTags(object_t(w), tags);
+  assert_cmpnum(w->flags, OSM_FLAG_DIRTY);
+  assert_cmpnum(o->original.ways.size(), 1);
+  const way_t *orig = o->original.ways.begin()->second;
+  assert_cmpnum(orig->flags, OSM_FLAG_SHARED);
+  assert(orig->node_chain.empty());
+  assert(orig->tags.empty());
+
+  // going back to the original tags resets the object
+  o->updateTags(object_t(w), osm_t::TagMap());
+  assert_cmpnum(w->flags, 0);
+  assert(o->original.ways.empty());
+
+  // the node chain is copied before it is modified
+  o->updateTags(object_t(w), tags);
+  const node_chain_t chain = w->node_chain;
+  w->reverse(o);
+  orig = o->original.ways.begin()->second;
+  assert_cmpnum(orig->flags, 0);
+  assert(orig->node_chain == chain);
+  assert(orig->node_chain != w->node_chain);
+  assert(orig->tags.empty());
+  assert(o->originalObject(w) == orig);
+
+  // originalObject() only returns complete objects
+  base_attributes rba(43);
+  rba.version = 1;
+  relation_t * const r = new relation_t(rba);
+  r->members.push_back(member_t(object_t(w), "outer"));
+  o->insert(r);
+  o->updateTags(object_t(r), tags);
+  assert_cmpnum(o->original.relations.begin()->second->flags, OSM_FLAG_SHARED);
+  const relation_t * const origR = o->originalObject(r);
+  assert(origR != nullptr);
+  assert_cmpnum(origR->flags, 0);
+  assert(origR->members == r->members);
+  assert(origR->tags.empty());
+
+  // deleting a way keeps the original node chain
+  base_attributes wba(44);
+  wba.version = 1;
+  way_t * const w2 = new way_t(wba);
+  w2->append_node(chain.front());
+  w2->append_node(chain.back());
+  o->insert(w2);
+  o->updateTags(object_t(w2), tags);
+  o->way_delete(w2, nullptr);
+  assert(w2->isDeleted());
+  assert(w2->node_chain.empty());
+  const way_t * const origW2 = o->originalObject(w2);
+  assert(origW2 != nullptr);
+  assert_cmpnum(origW2->flags, 0);
+  assert_cmpnum(origW2->node_chain.size(), 2);
+  assert(origW2->node_chain.front() == chain.front());
+  assert(origW2->node_chain.back() == chain.back());
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -2686,6 +3292,15 @@ int main(int argc, char **argv)
   test_delete_markdirty();
   test_membership_state();
   test_updateMembers();
+  test_fixed_pos();
+  test_nodes_near();
+  test_nodes_in_area();
+  test_way_grid();
+  test_node_ways();
+  test_object_relations();
+  test_tag_sharing();
+  test_find_by_tag();
+  test_shared_original();
 
   xmlCleanupParser();
 
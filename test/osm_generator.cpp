@@ -0,0 +1,528 @@
+#include "osm_generator.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+namespace {
+
+// the center of the area, somewhere in Hannover
+inline double lat(double y)
+{
+  return 52.3745 + y / 111320.0;
+}
+
+inline double lon(double x)
+{
+  return 9.7385 + x / (111320.0 * cos(52.3745 * M_PI / 180.0));
+}
+
+/**
+ * @brief replace the characters that are not allowed in an XML attribute value
+ */
+std::string xml_escape(const std::string &s)
+{
+  std::string ret;
+  ret.reserve(s.size());
+  for(std::string::const_iterator it = s.begin(); it != s.end(); it++) {
+    switch(*it) {
+    case '&':
+      ret += "&amp;";
+      break;
+    case '<':
+      ret += "&lt;";
+      break;
+    case '>':
+      ret += "&gt;";
+      break;
+    case '"':
+      ret += "&quot;";
+      break;
+    case '\'':
+      ret += "&apos;";
+      break;
+    default:
+      ret += *it;
+    }
+  }
+  return ret;
+}
+
+} // namespace
+
+osm_generator::osm_generator(unsigned int nodeCount, unsigned int wayCount, unsigned int relationCount, uint32_t seed)
+  : rnd(seed)
+{
+  generate(nodeCount, wayCount, relationCount);
+}
+
+template<size_t N>
+const char *osm_generator::pick(const weighted_value (&table)[N])
+{
+  unsigned int total = 0;
+  for(size_t i = 0; i < N; i++)
+    total += table[i].weight;
+  unsigned int r = rnd.next(total);
+  for(size_t i = 0; i < N - 1; i++) {
+    if(r < table[i].weight)
+      return table[i].value;
+    r -= table[i].weight;
+  }
+  return table[N - 1].value;
+}
+
+template<size_t N>
+const char *osm_generator::pick(const char * const (&table)[N])
+{
+  return table[rnd.next(N)];
+}
+
+void osm_generator::init_meta(gen_object &obj)
+{
+  // most objects were touched only a few times
+  static const weighted_value versions[] = {
+    { "1", 45 }, { "2", 25 }, { "3", 12 }, { "4", 8 }, { "7", 6 }, { "15", 4 }
+  };
+  obj.version = atoi(pick(versions));
+  obj.changeset = 1000000 + rnd.large(50000000);
+  obj.uid = 1 + rnd.next(5000);
+  obj.timestamp = rnd.large(8 * 365 * 86400);
+}
+
+void osm_generator::add_tag(gen_object &obj, const std::string &tag)
+{
+  const std::string::size_type eq = tag.find('=');
+  obj.tags.push_back(std::make_pair(tag.substr(0, eq), tag.substr(eq + 1)));
+}
+
+std::string osm_generator::number(unsigned int low, unsigned int high)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u", low + rnd.next(high - low + 1));
+  return buf;
+}
+
+std::string osm_generator::street_name()
+{
+  static const char * const prefixes[] = {
+    "Linden", "Ahorn", "Birken", "Kastanien", "Berg", "Bahnhof", "Schiller", "Goethe",
+    "Garten", "Mühlen", "Kirch", "Schul", "Wiesen", "Wald", "Markt", "Rosen", "Eichen",
+    "Brunnen", "Feld", "Hafen", "Buchen", "Sonnen", "Tannen", "Friedhof"
+  };
+  static const weighted_value suffixes[] = {
+    { "straße", 60 }, { "weg", 20 }, { "allee", 5 }, { "platz", 5 }, { "ring", 5 }, { "gasse", 5 }
+  };
+  return std::string(pick(prefixes)) + pick(suffixes);
+}
+
+unsigned int osm_generator::add_node(double x, double y)
+{
+  nodes.resize(nodes.size() + 1);
+  gen_node &n = nodes.back();
+  init_meta(n);
+  n.x = x;
+  n.y = y;
+  return nodes.size() - 1;
+}
+
+unsigned int osm_generator::way_node(double x, double y)
+{
+  if(nodes.size() < nodeBudget || nodes.empty())
+    return add_node(x, y);
+  return rnd.next(nodes.size());
+}
+
+osm_generator::gen_way &osm_generator::add_way()
+{
+  ways.resize(ways.size() + 1);
+  gen_way &w = ways.back();
+  init_meta(w);
+  return w;
+}
+
+void osm_generator::add_closed(gen_way &w, const std::vector<std::pair<double, double> > &points)
+{
+  for(std::vector<std::pair<double, double> >::const_iterator it = points.begin(); it != points.end(); it++)
+    w.nodes.push_back(way_node(it->first, it->second));
+  if(w.nodes.size() > 1 && w.nodes.front() != w.nodes.back())
+    w.nodes.push_back(w.nodes.front());
+}
+
+void osm_generator::add_building()
+{
+  static const weighted_value types[] = {
+    { "yes", 60 }, { "house", 18 }, { "apartments", 9 }, { "garage", 5 }, { "commercial", 3 },
+    { "retail", 2 }, { "detached", 2 }, { "school", 1 }
+  };
+
+  const double cx = rnd.between(-extent / 2, extent / 2);
+  const double cy = rnd.between(-extent / 2, extent / 2);
+  const double w2 = rnd.between(4, 15);
+  const double h2 = rnd.between(4, 15);
+
+  std::vector<std::pair<double, double> > points;
+  points.push_back(std::make_pair(cx - w2, cy - h2));
+  points.push_back(std::make_pair(cx + w2, cy - h2));
+  points.push_back(std::make_pair(cx + w2, cy + h2));
+  points.push_back(std::make_pair(cx - w2, cy + h2));
+
+  gen_way &w = add_way();
+  add_closed(w, points);
+  w.tags.push_back(std::make_pair("building", pick(types)));
+  if(rnd.chance(40)) {
+    w.tags.push_back(std::make_pair("addr:street", street_name()));
+    w.tags.push_back(std::make_pair("addr:housenumber", number(1, 150)));
+    w.tags.push_back(std::make_pair("addr:postcode", number(30159, 30669)));
+    w.tags.push_back(std::make_pair("addr:city", std::string("Hannover")));
+  }
+  if(rnd.chance(12))
+    w.tags.push_back(std::make_pair("building:levels", number(1, 8)));
+  if(rnd.chance(5))
+    w.tags.push_back(std::make_pair("roof:shape", std::string(rnd.chance(50) ? "gabled" : "flat")));
+
+  // some buildings have their entrance mapped
+  if(rnd.chance(3))
+    nodes[w.nodes.front()].tags.push_back(std::make_pair("entrance", std::string("yes")));
+
+  buildings.push_back(ways.size() - 1);
+}
+
+void osm_generator::add_street()
+{
+  static const weighted_value types[] = {
+    { "residential", 40 }, { "service", 20 }, { "footway", 12 }, { "tertiary", 8 },
+    { "secondary", 6 }, { "primary", 4 }, { "track", 3 }, { "cycleway", 3 },
+    { "unclassified", 3 }, { "steps", 1 }
+  };
+
+  gen_way &w = add_way();
+  const char *type = pick(types);
+  w.tags.push_back(std::make_pair("highway", type));
+
+  // streets are mostly aligned to a grid and start at an existing crossing
+  double x, y;
+  if(!streets.empty() && rnd.chance(60)) {
+    const gen_way &other = ways[streets[rnd.next(streets.size())]];
+    const unsigned int start = other.nodes[rnd.next(other.nodes.size())];
+    w.nodes.push_back(start);
+    x = nodes[start].x;
+    y = nodes[start].y;
+  } else {
+    x = rnd.between(-extent / 2, extent / 2);
+    y = rnd.between(-extent / 2, extent / 2);
+    w.nodes.push_back(way_node(x, y));
+  }
+
+  const bool horizontal = rnd.chance(50);
+  const double dir = rnd.chance(50) ? 1 : -1;
+  const unsigned int segments = 1 + rnd.next(10);
+  for(unsigned int i = 0; i < segments; i++) {
+    const double step = dir * rnd.between(15, 45);
+    const double jitter = rnd.between(-3, 3);
+    if(horizontal) {
+      x += step;
+      y += jitter;
+    } else {
+      x += jitter;
+      y += step;
+    }
+    w.nodes.push_back(way_node(x, y));
+    // some crossings and traffic signals
+    if(rnd.chance(4))
+      nodes[w.nodes.back()].tags.push_back(std::make_pair("highway",
+                                           std::string(rnd.chance(70) ? "crossing" : "traffic_signals")));
+  }
+
+  const std::string t = type;
+  if(t != "service" && t != "footway" && t != "track" && t != "cycleway" && t != "steps") {
+    w.tags.push_back(std::make_pair("name", street_name()));
+    if(rnd.chance(50))
+      w.tags.push_back(std::make_pair("maxspeed", std::string(rnd.chance(70) ? "50" : "30")));
+    if(rnd.chance(30))
+      w.tags.push_back(std::make_pair("lanes", number(1, 4)));
+    if(rnd.chance(10))
+      w.tags.push_back(std::make_pair("oneway", std::string("yes")));
+  } else if(t == "service" && rnd.chance(30)) {
+    w.tags.push_back(std::make_pair("service", std::string(rnd.chance(60) ? "driveway" : "parking_aisle")));
+  }
+  if(rnd.chance(35)) {
+    static const weighted_value surfaces[] = {
+      { "asphalt", 60 }, { "paving_stones", 20 }, { "gravel", 8 }, { "sett", 7 }, { "unpaved", 5 }
+    };
+    w.tags.push_back(std::make_pair("surface", pick(surfaces)));
+  }
+  if(rnd.chance(8))
+    w.tags.push_back(std::make_pair("lit", std::string("yes")));
+
+  streets.push_back(ways.size() - 1);
+}
+
+void osm_generator::add_area()
+{
+  static const weighted_value types[] = {
+    { "landuse=residential", 25 }, { "landuse=grass", 20 }, { "leisure=park", 12 },
+    { "amenity=parking", 12 }, { "landuse=forest", 8 }, { "landuse=commercial", 6 },
+    { "natural=water", 5 }, { "leisure=playground", 5 }, { "landuse=farmland", 4 },
+    { "natural=scrub", 3 }
+  };
+
+  const double cx = rnd.between(-extent / 2, extent / 2);
+  const double cy = rnd.between(-extent / 2, extent / 2);
+  const double radius = rnd.between(30, 150);
+  const unsigned int count = 5 + rnd.next(12);
+
+  std::vector<std::pair<double, double> > points;
+  for(unsigned int i = 0; i < count; i++) {
+    const double angle = 2 * M_PI * i / count;
+    const double r = radius * rnd.between(0.7, 1.0);
+    points.push_back(std::make_pair(cx + r * cos(angle), cy + r * sin(angle)));
+  }
+
+  gen_way &w = add_way();
+  add_closed(w, points);
+  add_tag(w, pick(types));
+  if(rnd.chance(15)) {
+    static const char * const names[] = { "Park am", "Grünfläche", "Spielplatz" };
+    w.tags.push_back(std::make_pair("name", std::string(pick(names)) + ' ' + street_name()));
+  }
+
+  areas.push_back(ways.size() - 1);
+}
+
+void osm_generator::add_line()
+{
+  static const weighted_value types[] = {
+    { "barrier=fence", 40 }, { "barrier=hedge", 25 }, { "waterway=stream", 15 },
+    { "railway=rail", 10 }, { "power=line", 10 }
+  };
+
+  gen_way &w = add_way();
+  double x = rnd.between(-extent / 2, extent / 2);
+  double y = rnd.between(-extent / 2, extent / 2);
+  const unsigned int count = 2 + rnd.next(8);
+  for(unsigned int i = 0; i < count; i++) {
+    w.nodes.push_back(way_node(x, y));
+    x += rnd.between(-40, 40);
+    y += rnd.between(-40, 40);
+  }
+
+  add_tag(w, pick(types));
+}
+
+void osm_generator::add_poi(gen_node &n)
+{
+  static const weighted_value types[] = {
+    { "natural=tree", 30 }, { "highway=street_lamp", 15 }, { "amenity=bench", 10 },
+    { "amenity=waste_basket", 8 }, { "highway=bus_stop", 6 }, { "shop=bakery", 4 },
+    { "amenity=restaurant", 4 }, { "amenity=cafe", 3 }, { "shop=supermarket", 3 },
+    { "amenity=post_box", 3 }, { "shop=hairdresser", 3 }, { "amenity=bicycle_parking", 3 },
+    { "amenity=pharmacy", 2 }, { "tourism=information", 2 }, { "amenity=recycling", 2 },
+    { "shop=kiosk", 2 }
+  };
+  static const char * const owners[] = {
+    "Müller", "Schmidt", "Schneider", "Fischer", "Weber", "Meyer", "Wagner", "Becker",
+    "Schulz", "Hoffmann", "Koch", "Richter"
+  };
+
+  const std::string tag = pick(types);
+  add_tag(n, tag);
+
+  if(n.tags.back().first == "shop" || tag == "amenity=restaurant" || tag == "amenity=cafe" ||
+     tag == "amenity=pharmacy") {
+    n.tags.push_back(std::make_pair("name", std::string(pick(owners)) + ' ' + n.tags.back().second));
+    if(rnd.chance(30))
+      n.tags.push_back(std::make_pair("opening_hours", std::string("Mo-Fr 08:00-18:00; Sa 08:00-13:00")));
+    if(rnd.chance(50)) {
+      n.tags.push_back(std::make_pair("addr:street", street_name()));
+      n.tags.push_back(std::make_pair("addr:housenumber", number(1, 150)));
+    }
+  } else if(tag == "highway=bus_stop") {
+    n.tags.push_back(std::make_pair("name", street_name()));
+    n.tags.push_back(std::make_pair("public_transport", std::string("platform")));
+    stops.push_back(&n - &nodes.front());
+  } else if(tag == "natural=tree" && rnd.chance(20)) {
+    static const char * const genus[] = { "Tilia", "Acer", "Quercus", "Betula", "Fagus" };
+    n.tags.push_back(std::make_pair("genus", std::string(pick(genus))));
+  }
+}
+
+void osm_generator::add_multipolygon()
+{
+  static const weighted_value types[] = {
+    { "landuse=grass", 30 }, { "leisure=park", 25 }, { "landuse=forest", 20 },
+    { "natural=water", 15 }, { "building=yes", 10 }
+  };
+
+  gen_relation &r = relations.back();
+  r.tags.push_back(std::make_pair("type", std::string("multipolygon")));
+  add_tag(r, pick(types));
+  r.members.push_back(gen_member("way", areas[rnd.next(areas.size())], "outer"));
+  const unsigned int inner = rnd.next(3);
+  for(unsigned int i = 0; i < inner && !buildings.empty(); i++)
+    r.members.push_back(gen_member("way", buildings[rnd.next(buildings.size())], "inner"));
+}
+
+void osm_generator::add_route()
+{
+  static const char * const networks[] = { "GVH", "ÜSTRA", "RegioBus" };
+
+  gen_relation &r = relations.back();
+  r.tags.push_back(std::make_pair("type", std::string("route")));
+  r.tags.push_back(std::make_pair("route", std::string(rnd.chance(80) ? "bus" : "tram")));
+  const std::string ref = number(1, 800);
+  r.tags.push_back(std::make_pair("ref", ref));
+  r.tags.push_back(std::make_pair("name", "Bus " + ref + ": " + street_name() + " => " + street_name()));
+  r.tags.push_back(std::make_pair("network", std::string(pick(networks))));
+
+  const unsigned int count = 2 + rnd.next(6);
+  for(unsigned int i = 0; i < count && !nodes.empty(); i++)
+    r.members.push_back(gen_member("node", stops.empty() ? rnd.next(nodes.size()) : stops[rnd.next(stops.size())],
+                                   "stop"));
+  const unsigned int wcount = 3 + rnd.next(15);
+  for(unsigned int i = 0; i < wcount; i++)
+    r.members.push_back(gen_member("way", streets[rnd.next(streets.size())], ""));
+
+  routes.push_back(relations.size() - 1);
+}
+
+void osm_generator::add_restriction()
+{
+  static const weighted_value types[] = {
+    { "no_left_turn", 40 }, { "no_u_turn", 20 }, { "no_right_turn", 15 },
+    { "only_straight_on", 15 }, { "only_right_turn", 10 }
+  };
+
+  gen_relation &r = relations.back();
+  r.tags.push_back(std::make_pair("type", std::string("restriction")));
+  r.tags.push_back(std::make_pair("restriction", pick(types)));
+  const unsigned int from = streets[rnd.next(streets.size())];
+  r.members.push_back(gen_member("way", from, "from"));
+  r.members.push_back(gen_member("node", ways[from].nodes.back(), "via"));
+  r.members.push_back(gen_member("way", streets[rnd.next(streets.size())], "to"));
+}
+
+void osm_generator::add_route_master()
+{
+  gen_relation &r = relations.back();
+  r.tags.push_back(std::make_pair("type", std::string("route_master")));
+  r.tags.push_back(std::make_pair("route_master", std::string("bus")));
+  const unsigned int count = 1 + rnd.next(2);
+  for(unsigned int i = 0; i < count; i++)
+    r.members.push_back(gen_member("relation", routes[rnd.next(routes.size())], ""));
+}
+
+void osm_generator::add_collection()
+{
+  // fallback if there are no ways to build anything better from
+  gen_relation &r = relations.back();
+  r.tags.push_back(std::make_pair("type", std::string("site")));
+  r.tags.push_back(std::make_pair("name", street_name()));
+  const unsigned int count = 1 + rnd.next(5);
+  for(unsigned int i = 0; i < count && !nodes.empty(); i++)
+    r.members.push_back(gen_member("node", rnd.next(nodes.size()), ""));
+}
+
+void osm_generator::generate(unsigned int nodeCount, unsigned int wayCount, unsigned int relationCount)
+{
+  // roughly the density of a city center
+  extent = 8.0 * std::sqrt(static_cast<double>(nodeCount) + 1);
+  nodeBudget = nodeCount;
+  nodes.reserve(nodeCount);
+  ways.reserve(wayCount);
+  relations.reserve(relationCount);
+
+  for(unsigned int i = 0; i < wayCount; i++) {
+    const unsigned int kind = rnd.next(100);
+    if(kind < 66)
+      add_building();
+    else if(kind < 86)
+      add_street();
+    else if(kind < 96)
+      add_area();
+    else
+      add_line();
+  }
+
+  // all remaining nodes are free standing, most of them are points of interest
+  while(nodes.size() < nodeBudget) {
+    gen_node &n = nodes[add_node(rnd.between(-extent / 2, extent / 2), rnd.between(-extent / 2, extent / 2))];
+    if(rnd.chance(85))
+      add_poi(n);
+  }
+
+  for(unsigned int i = 0; i < relationCount; i++) {
+    relations.resize(relations.size() + 1);
+    init_meta(relations.back());
+    const unsigned int kind = rnd.next(100);
+    if(kind < 45 && !areas.empty())
+      add_multipolygon();
+    else if(kind < 75 && !streets.empty())
+      add_route();
+    else if(kind < 95 && !streets.empty())
+      add_restriction();
+    else if(!routes.empty())
+      add_route_master();
+    else
+      add_collection();
+  }
+}
+
+bool osm_generator::write(const char *filename) const
+{
+  FILE *f = fopen(filename, "w");
+  if(f == nullptr)
+    return false;
+
+  fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<osm version=\"0.6\" generator=\"osm2go_bench\">\n", f);
+  fprintf(f, " <bounds minlat=\"%.7f\" minlon=\"%.7f\" maxlat=\"%.7f\" maxlon=\"%.7f\"/>\n",
+          lat(-extent / 2), lon(-extent / 2), lat(extent / 2), lon(extent / 2));
+
+  for(unsigned int i = 0; i < nodes.size(); i++) {
+    const gen_node &n = nodes[i];
+    fprintf(f, " <node id=\"%u\" lat=\"%.7f\" lon=\"%.7f\"", i + 1, lat(n.y), lon(n.x));
+    write_attributes(f, n, n.tags.empty());
+    if(!n.tags.empty()) {
+      write_tags(f, n.tags);
+      fputs(" </node>\n", f);
+    }
+  }
+  for(unsigned int i = 0; i < ways.size(); i++) {
+    const gen_way &w = ways[i];
+    fprintf(f, " <way id=\"%u\"", i + 1);
+    write_attributes(f, w);
+    for(std::vector<unsigned int>::const_iterator it = w.nodes.begin(); it != w.nodes.end(); it++)
+      fprintf(f, "  <nd ref=\"%u\"/>\n", *it + 1);
+    write_tags(f, w.tags);
+    fputs(" </way>\n", f);
+  }
+  for(unsigned int i = 0; i < relations.size(); i++) {
+    const gen_relation &r = relations[i];
+    fprintf(f, " <relation id=\"%u\"", i + 1);
+    write_attributes(f, r);
+    for(std::vector<gen_member>::const_iterator it = r.members.begin(); it != r.members.end(); it++)
+      fprintf(f, "  <member type=\"%s\" ref=\"%u\" role=\"%s\"/>\n", it->type, it->index + 1, it->role);
+    write_tags(f, r.tags);
+    fputs(" </relation>\n", f);
+  }
+
+  fputs("</osm>\n", f);
+  return fclose(f) == 0;
+}
+
+void osm_generator::write_tags(FILE *f, const tag_list &tags)
+{
+  for(tag_list::const_iterator it = tags.begin(); it != tags.end(); it++)
+    fprintf(f, "  <tag k=\"%s\" v=\"%s\"/>\n", xml_escape(it->first).c_str(), xml_escape(it->second).c_str());
+}
+
+void osm_generator::write_attributes(FILE *f, const gen_object &obj, bool empty)
+{
+  const time_t t = 1262304000 + obj.timestamp;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char tbuf[32];
+  strftime(tbuf, sizeof(tbuf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+  fprintf(f, " version=\"%u\" changeset=\"%u\" timestamp=\"%s\" user=\"mapper%u\" uid=\"%u\"%s>\n",
+          obj.version, obj.changeset, tbuf, obj.uid, obj.uid, empty ? "/" : "");
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "test_lcg.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief deterministic generator for city-like OSM data
+ *
+ * The generated data looks like a part of a city: a network of streets that
+ * share their crossing nodes, many small buildings, some larger areas like
+ * parks and landuse polygons, and free standing points of interest. The
+ * relations are multipolygons, bus routes, and turn restrictions referencing
+ * these objects. The tag distributions roughly follow those of real city
+ * data.
+ *
+ * The same parameters always create the same output.
+ */
+class osm_generator {
+public:
+  osm_generator(unsigned int nodeCount, unsigned int wayCount, unsigned int relationCount, uint32_t seed = 1);
+
+  /**
+   * @brief write the generated data as OSM XML file
+   * @returns if the file could be written
+   */
+  bool write(const char *filename) const;
+
+private:
+  typedef std::vector<std::pair<std::string, std::string> > tag_list;
+
+  struct gen_object {
+    tag_list tags;
+    unsigned int version;
+    unsigned int changeset;
+    unsigned int uid;
+    unsigned int timestamp;   ///< seconds since 2010-01-01
+  };
+
+  struct gen_node : public gen_object {
+    double x, y;   ///< meters from the center
+  };
+
+  struct gen_way : public gen_object {
+    std::vector<unsigned int> nodes;
+  };
+
+  struct gen_member {
+    gen_member(const char *t, unsigned int i, const char *r) : type(t), index(i), role(r) {}
+    const char *type;
+    unsigned int index;
+    const char *role;
+  };
+
+  struct gen_relation : public gen_object {
+    std::vector<gen_member> members;
+  };
+
+  struct weighted_value {
+    const char *value;
+    unsigned int weight;
+  };
+
+  lcg rnd;
+  double extent;      ///< size of the area in meters
+  std::vector<gen_node> nodes;
+  std::vector<gen_way> ways;
+  std::vector<gen_relation> relations;
+  unsigned int nodeBudget;
+  std::vector<unsigned int> streets;    ///< indexes of ways with highway=*
+  std::vector<unsigned int> buildings;  ///< indexes of closed building ways
+  std::vector<unsigned int> areas;      ///< indexes of other closed ways
+  std::vector<unsigned int> stops;      ///< indexes of nodes with highway=bus_stop
+  std::vector<unsigned int> routes;     ///< indexes of route relations
+
+  template<size_t N>
+  const char *pick(const weighted_value (&table)[N]);
+  template<size_t N>
+  const char *pick(const char * const (&table)[N]);
+
+  /**
+   * @brief add a tag given as "key=value"
+   */
+  static void add_tag(gen_object &obj, const std::string &tag);
+  std::string number(unsigned int low, unsigned int high);
+  std::string street_name();
+  void init_meta(gen_object &obj);
+
+  unsigned int add_node(double x, double y);
+  /**
+   * @brief get a node at the given position
+   *
+   * If the node budget is used up an existing node is reused instead.
+   */
+  unsigned int way_node(double x, double y);
+  gen_way &add_way();
+  void add_closed(gen_way &w, const std::vector<std::pair<double, double> > &points);
+
+  void add_building();
+  void add_street();
+  void add_area();
+  void add_line();
+  void add_poi(gen_node &n);
+  void add_multipolygon();
+  void add_route();
+  void add_restriction();
+  void add_route_master();
+  void add_collection();
+
+  void generate(unsigned int nodeCount, unsigned int wayCount, unsigned int relationCount);
+
+  static void write_tags(FILE *f, const tag_list &tags);
+  /**
+   * @brief write the common attributes and close the start tag
+   * @param empty if the element has no children
+   */
+  static void write_attributes(FILE *f, const gen_object &obj, bool empty = false);
+};
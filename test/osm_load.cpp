@@ -4,13 +4,17 @@
 #include <osm_objects.h>
 
 #include <osm2go_cpp.h>
+#include <osm2go_platform.h>
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <libxml/parser.h>
 #include <libxml/xmlstring.h>
+#include <unistd.h>
+#include <zlib.h>
 
 namespace {
 
@@ -80,6 +84,562 @@ struct tag_counter {
   }
 };
 
+
+osm_t *
+parse_string(const char *data, size_t len)
+{
+  char fname[] = "/tmp/osm2go-osmload-XXXXXX";
+  int fd = mkstemp(fname);
+  assert(fd >= 0);
+  assert_cmpnum(write(fd, data, len), len);
+  close(fd);
+
+  osm_t *ret = osm_t::parse(std::string(), fname);
+  unlink(fname);
+
+  return ret;
+}
+
+void
+check_parse(const char *header)
+{
+  std::string data = header;
+  data += "<osm version=\"0.6\" upload=\"false\">\n"
+          " <bounds minlat=\"52.0\" minlon=\"9.0\" maxlat=\"52.1\" maxlon=\"9.1\"/>\n"
+          " <node id=\"1\" version=\"2\" user=\"a&amp;b\" uid=\"7\" lat=\"52.05\" lon=\"9.05\" timestamp=\"2015-10-10T10:56:21Z\">\n"
+          "  <tag k=\"name\" v=\"&quot;A&apos;s&quot; &lt;&gt; &#228;&#xE4;\"/>\n"
+          "  <tag k=\"note\" v=\"line1&#10;line2\n\tnext\"/>\n"
+          " </node>\n"
+          " <node id='2' version='1' lat='52.0600000001' lon='9.06000000002' ><unknown><tag k='a' v='b'/></unknown></node>\n"
+          " <way id=\"3\" version=\"1\"><nd ref=\"1\"/><nd ref=\"2\"/><tag k=\"highway\" v=\"path\"/></way>\n"
+          " <relation id=\"4\" version=\"1\"><member type=\"way\" ref=\"3\" role=\"outer\"/><member type=\"relation\" ref=\"5\" role=\"\"/></relation>\n"
+          " <relation id=\"5\" version=\"1\"><member type=\"node\" ref=\"1\" role=\"a\"/></relation>\n"
+          "</osm>\n";
+
+  std::unique_ptr<osm_t> osm(parse_string(data.c_str(), data.size()));
+  assert(osm);
+
+  assert_cmpnum(osm->uploadPolicy, osm_t::Upload_Discouraged);
+  assert_cmpnum(osm->nodes.size(), 2);
+  assert_cmpnum(osm->ways.size(), 1);
+  assert_cmpnum(osm->relations.size(), 2);
+
+  const node_t * const n = osm->object_by_id<node_t>(1);
+  assert(n != nullptr);
+  assert_cmpnum(n->version, 2);
+  assert_cmpnum(n->time, 1444474581);
+  assert_cmpnum(n->user, 7);
+  assert_cmpstr(osm->users[7], "a&b");
+  assert_cmpnum(n->ways, 1);
+  assert_cmpstr(n->tags.get_value("name"), "\"A's\" <> \xc3\xa4\xc3\xa4");
+  assert_cmpstr(n->tags.get_value("note"), "line1\nline2  next");
+
+  const node_t * const n2 = osm->object_by_id<node_t>(2);
+  assert(n2 != nullptr);
+  assert(n2->tags.empty());
+  // more decimals than the fixed point format has
+  assert_cmpnum(n2->pos.ilat, 520600000);
+  assert_cmpnum(n2->pos.ilon, 90600000);
+
+  const way_t * const w = osm->object_by_id<way_t>(3);
+  assert(w != nullptr);
+  assert_cmpnum(w->node_chain.size(), 2);
+  assert(w->node_chain.front() == n);
+  assert(w->node_chain.back() == n2);
+  assert_cmpstr(w->tags.get_value("highway"), "path");
+
+  const relation_t * const r = osm->object_by_id<relation_t>(4);
+  assert(r != nullptr);
+  assert_cmpnum(r->members.size(), 2);
+  assert(r->members.front().object == w);
+  assert_cmpstr(r->members.front().role, "outer");
+  // the reference to the later relation is resolved after parsing
+  assert(r->members.back().object == osm->object_by_id<relation_t>(5));
+  assert_null(r->members.back().role);
+}
+
+/**
+ * @brief compare the objects of 2 different osm_t instances
+ *
+ * The object pointers differ between the instances, so references are compared by id.
+ */
+struct osm_compare {
+  const osm_t &other;
+  explicit inline osm_compare(const osm_t &o) : other(o) {}
+
+  template<typename T>
+  const T *check_base(const T *obj) const
+  {
+    const T * const o = other.object_by_id<T>(obj->id);
+    assert(o != nullptr);
+    assert(static_cast<const base_attributes &>(*o) == *obj);
+    assert(o->flags == obj->flags);
+    assert(o->tags == obj->tags.asMap());
+    return o;
+  }
+
+  void operator()(const std::pair<item_id_t, node_t *> &p) const
+  {
+    const node_t * const o = check_base(p.second);
+    assert(o->pos == p.second->pos);
+    assert_cmpnum(o->lpos.x, p.second->lpos.x);
+    assert_cmpnum(o->lpos.y, p.second->lpos.y);
+    assert_cmpnum(o->ways, p.second->ways);
+  }
+
+  void operator()(const std::pair<item_id_t, way_t *> &p) const
+  {
+    const way_t * const o = check_base(p.second);
+    assert_cmpnum(o->node_chain.size(), p.second->node_chain.size());
+    for(size_t i = 0; i < o->node_chain.size(); i++)
+      assert_cmpnum(o->node_chain[i]->id, p.second->node_chain[i]->id);
+  }
+
+  void operator()(const std::pair<item_id_t, relation_t *> &p) const
+  {
+    const relation_t * const o = check_base(p.second);
+    assert_cmpnum(o->members.size(), p.second->members.size());
+    for(size_t i = 0; i < o->members.size(); i++) {
+      const member_t &m = o->members[i];
+      const member_t &om = p.second->members[i];
+      assert_cmpnum(m.object.type, om.object.type);
+      assert_cmpnum(m.object.get_id(), om.object.get_id());
+      if(om.role == nullptr)
+        assert_null(m.role);
+      else
+        assert_cmpstr(m.role, om.role);
+    }
+  }
+};
+
+void
+check_invalid_ids(const char *header)
+{
+  std::string data = header;
+  data += "<osm version='0.6'>\n"
+          " <bounds minlat='52.0' minlon='9.0' maxlat='52.1' maxlon='9.1'/>\n"
+          " <node id='1' version='1' lat='52.01' lon='9.01'/>\n"
+          " <node id='2x' version='1' lat='52.02' lon='9.02'><tag k='a' v='b'/></node>\n"
+          " <node id='99999999999999999999' version='1' lat='52.03' lon='9.03'/>\n"
+          " <node id='4' version='-1' lat='52.04' lon='9.04'/>\n"
+          " <node id='5' version='4294967296' lat='52.05' lon='9.05'/>\n"
+          " <node id='6' lat='52.06' lon='9.06'/>\n"
+          " <node id='7' version='3' lat='52.07' lon='9.07'/>\n"
+          " <way id='8' version='1'><nd ref='1'/><nd ref='1a'/><nd ref='7'/></way>\n"
+          "</osm>\n";
+
+  std::unique_ptr<osm_t> osm(parse_string(data.c_str(), data.size()));
+  assert(osm);
+
+  assert_cmpnum(osm->nodes.size(), 2);
+  assert(osm->object_by_id<node_t>(1) != nullptr);
+  assert(osm->object_by_id<node_t>(7) != nullptr);
+
+  const way_t * const w = osm->object_by_id<way_t>(8);
+  assert(w != nullptr);
+  assert_cmpnum(w->node_chain.size(), 2);
+}
+
+void
+check_shared_tags()
+{
+  const char data[] =
+      "<?xml version='1.0' encoding='UTF-8'?>\n"
+      "<osm version='0.6'>\n"
+      " <bounds minlat='52.0' minlon='9.0' maxlat='52.1' maxlon='9.1'/>\n"
+      " <node id='1' version='1' lat='52.01' lon='9.01'><tag k='created_by' v='JOSM'/></node>\n"
+      " <node id='2' version='1' lat='52.02' lon='9.02'><tag k='created_by' v='JOSM'/></node>\n"
+      " <node id='3' version='1' lat='52.03' lon='9.03'><tag k='created_by' v='JOSM'/><tag k='name' v='x'/></node>\n"
+      " <node id='4' version='1' lat='52.04' lon='9.04'><tag k='created_by' v='JOSM'/></node>\n"
+      " <node id='5' version='1' lat='52.05' lon='9.05'><tag k='created_by' v='JOSMx'/></node>\n"
+      " <node id='6' version='1' lat='52.06' lon='9.06'/>\n"
+      "</osm>\n";
+
+  std::unique_ptr<osm_t> osm(parse_string(data, strlen(data)));
+  assert(osm);
+  assert_cmpnum(osm->nodes.size(), 6);
+
+  std::array<const node_t *, 6> n;
+  for(unsigned int i = 0; i < n.size(); i++) {
+    n[i] = osm->object_by_id<node_t>(i + 1);
+    assert(n[i] != nullptr);
+  }
+
+  assert_cmpstr(n[0]->tags.get_value("created_by"), "JOSM");
+  assert(!n[0]->tags.hasNonDiscardableTags());
+  assert_cmpstr(n[1]->tags.get_value("created_by"), "JOSM");
+  assert(n[0]->tags != n[2]->tags);
+  assert_cmpstr(n[2]->tags.get_value("name"), "x");
+  assert_cmpstr(n[3]->tags.get_value("created_by"), "JOSM");
+  assert(!n[3]->tags.hasNonDiscardableTags());
+  assert_cmpstr(n[4]->tags.get_value("created_by"), "JOSMx");
+  assert(n[5]->tags.empty());
+}
+
+void
+check_snapshot(const char *fname)
+{
+  std::unique_ptr<osm_t> osm(osm_t::parse(std::string(), fname));
+  assert(osm);
+
+  char snapname[] = "/tmp/osm2go-snapshot-XXXXXX";
+  int fd = mkstemp(snapname);
+  assert(fd >= 0);
+  close(fd);
+
+  assert(osm->saveSnapshot(snapname, fname));
+
+  std::unique_ptr<osm_t> snap(osm_t::loadSnapshot(snapname, fname));
+  assert(snap);
+
+  assert_cmpnum(snap->uploadPolicy, osm->uploadPolicy);
+  assert(snap->bounds.ll == osm->bounds.ll);
+  assert_cmpnum(snap->bounds.min.x, osm->bounds.min.x);
+  assert_cmpnum(snap->bounds.max.y, osm->bounds.max.y);
+  assert(snap->users == osm->users);
+  assert_cmpnum(snap->nodes.size(), osm->nodes.size());
+  assert_cmpnum(snap->ways.size(), osm->ways.size());
+  assert_cmpnum(snap->relations.size(), osm->relations.size());
+
+  const osm_compare cmp(*snap);
+  std::for_each(osm->nodes.begin(), osm->nodes.end(), cmp);
+  std::for_each(osm->ways.begin(), osm->ways.end(), cmp);
+  std::for_each(osm->relations.begin(), osm->relations.end(), cmp);
+
+  // a snapshot from a different source is not used
+  assert_null(osm_t::loadSnapshot(snapname, snapname));
+
+  // a damaged snapshot is rejected
+  assert_cmpnum(truncate(snapname, 64), 0);
+  assert_null(osm_t::loadSnapshot(snapname, fname));
+
+  unlink(snapname);
+}
+
+/**
+ * @brief minimal encoder for the protocol buffer messages of PBF files
+ */
+class pbf_message {
+  void varint(uint64_t v)
+  {
+    for(; v >= 0x80; v >>= 7)
+      data.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    data.push_back(static_cast<char>(v));
+  }
+  inline void key(unsigned int field, unsigned int wire)
+  { varint((field << 3) | wire); }
+
+public:
+  std::string data;
+
+  pbf_message &value(unsigned int field, uint64_t v)
+  {
+    key(field, 0);
+    varint(v);
+    return *this;
+  }
+  pbf_message &svalue(unsigned int field, int64_t v)
+  { return value(field, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+  pbf_message &bytes(unsigned int field, const std::string &v)
+  {
+    key(field, 2);
+    varint(v.size());
+    data += v;
+    return *this;
+  }
+  inline pbf_message &message(unsigned int field, const pbf_message &m)
+  { return bytes(field, m.data); }
+  /// packed repeated field
+  pbf_message &packed(unsigned int field, const std::vector<uint64_t> &v)
+  {
+    pbf_message p;
+    for(size_t i = 0; i < v.size(); i++)
+      p.varint(v[i]);
+    return message(field, p);
+  }
+  pbf_message &spacked(unsigned int field, const std::vector<int64_t> &v)
+  {
+    std::vector<uint64_t> z;
+    for(size_t i = 0; i < v.size(); i++)
+      z.push_back((static_cast<uint64_t>(v[i]) << 1) ^ static_cast<uint64_t>(v[i] >> 63));
+    return packed(field, z);
+  }
+};
+
+std::string
+pbf_blob(const std::string &type, const pbf_message &block, bool compress)
+{
+  pbf_message blob;
+  if(compress) {
+    std::string z(compressBound(block.data.size()), '\0');
+    uLongf zlen = z.size();
+    assert_cmpnum(::compress(reinterpret_cast<Bytef *>(&z[0]), &zlen,
+                             reinterpret_cast<const Bytef *>(block.data.data()), block.data.size()), Z_OK);
+    z.resize(zlen);
+    blob.value(2, block.data.size()).bytes(3, z);
+  } else {
+    blob.bytes(1, block.data);
+  }
+
+  pbf_message header;
+  header.bytes(1, type).value(3, blob.data.size());
+  const uint32_t hlen = header.data.size();
+  std::string ret;
+  ret.push_back(static_cast<char>(hlen >> 24));
+  ret.push_back(static_cast<char>(hlen >> 16));
+  ret.push_back(static_cast<char>(hlen >> 8));
+  ret.push_back(static_cast<char>(hlen));
+  return ret + header.data + blob.data;
+}
+
+std::vector<uint64_t>
+uvec(const std::initializer_list<uint64_t> &l)
+{
+  return std::vector<uint64_t>(l);
+}
+
+std::vector<int64_t>
+svec(const std::initializer_list<int64_t> &l)
+{
+  return std::vector<int64_t>(l);
+}
+
+pbf_message
+pbf_strings(const std::initializer_list<const char *> &l)
+{
+  pbf_message ret;
+  for(const char *s : l)
+    ret.bytes(1, s);
+  return ret;
+}
+
+std::string
+pbf_header()
+{
+  pbf_message bbox;
+  bbox.svalue(1, 9000000000LL).svalue(2, 9100000000LL).svalue(3, 52100000000LL).svalue(4, 52000000000LL);
+  pbf_message header;
+  header.message(1, bbox).bytes(4, "OsmSchema-V0.6").bytes(4, "DenseNodes").bytes(16, "osm_load");
+
+  return pbf_blob("OSMHeader", header, false);
+}
+
+void
+check_pbf()
+{
+  // the nodes, compressed
+  pbf_message denseInfo;
+  denseInfo.packed(1, uvec({ 2, 1 }))
+           .spacked(2, svec({ 1444474581, -1000 }))
+           .spacked(4, svec({ 7, -7 }))
+           .spacked(5, svec({ 3, -3 }));
+  pbf_message dense;
+  dense.spacked(1, svec({ 1, 1 }))
+       .message(5, denseInfo)
+       .spacked(8, svec({ 520500000, 100000 }))
+       .spacked(9, svec({ 90500000, 100000 }))
+       .packed(10, uvec({ 1, 2, 0, 0 }));
+  pbf_message nodes;
+  nodes.message(2, dense);
+  pbf_message nodeBlock;
+  nodeBlock.message(1, pbf_strings({ "", "name", "A", "a&b" })).message(2, nodes);
+
+  // ways and relations, with a different string table and granularity
+  pbf_message info;
+  info.value(1, 1);
+  pbf_message way;
+  way.value(1, 3).packed(2, uvec({ 1 })).packed(3, uvec({ 2 })).message(4, info)
+     .spacked(8, svec({ 1, 1 }));
+  pbf_message ways;
+  ways.message(3, way);
+  pbf_message rel4;
+  rel4.value(1, 4).message(4, info)
+      .packed(8, uvec({ 3, 0 })).spacked(9, svec({ 3, 2 })).packed(10, uvec({ 1, 2 }));
+  pbf_message rel5;
+  rel5.value(1, 5).message(4, info)
+      .packed(8, uvec({ 4 })).spacked(9, svec({ 1 })).packed(10, uvec({ 0 }));
+  pbf_message relations;
+  relations.message(4, rel4).message(4, rel5);
+  pbf_message objBlock;
+  objBlock.message(1, pbf_strings({ "", "highway", "path", "outer", "a" }))
+          .message(2, ways).message(2, relations).value(17, 1000);
+
+  std::string data = pbf_header() + pbf_blob("OSMData", nodeBlock, true) + pbf_blob("OSMData", objBlock, false);
+
+  std::unique_ptr<osm_t> osm(parse_string(data.c_str(), data.size()));
+  assert(osm);
+
+  assert(osm->bounds.ll == pos_area(pos_t(52.0, 9.0), pos_t(52.1, 9.1)));
+  assert_cmpnum(osm->nodes.size(), 2);
+  assert_cmpnum(osm->ways.size(), 1);
+  assert_cmpnum(osm->relations.size(), 2);
+
+  const node_t * const n = osm->object_by_id<node_t>(1);
+  assert(n != nullptr);
+  assert_cmpnum(n->version, 2);
+  assert_cmpnum(n->time, 1444474581);
+  assert_cmpnum(n->user, 7);
+  assert_cmpstr(osm->users[7], "a&b");
+  assert_cmpstr(n->tags.get_value("name"), "A");
+  assert_cmpnum(n->ways, 1);
+  assert(n->pos == pos_t(52.05, 9.05));
+
+  const node_t * const n2 = osm->object_by_id<node_t>(2);
+  assert(n2 != nullptr);
+  assert_cmpnum(n2->version, 1);
+  assert_cmpnum(n2->time, 1444473581);
+  assert_cmpnum(n2->user, 0);
+  assert(n2->tags.empty());
+  assert(n2->pos == pos_t(52.06, 9.06));
+
+  const way_t * const w = osm->object_by_id<way_t>(3);
+  assert(w != nullptr);
+  assert_cmpnum(w->version, 1);
+  assert_cmpnum(w->node_chain.size(), 2);
+  assert(w->node_chain.front() == n);
+  assert(w->node_chain.back() == n2);
+  assert_cmpstr(w->tags.get_value("highway"), "path");
+
+  const relation_t * const r = osm->object_by_id<relation_t>(4);
+  assert(r != nullptr);
+  assert_cmpnum(r->members.size(), 2);
+  assert(r->members.front().object == w);
+  assert_cmpstr(r->members.front().role, "outer");
+  assert(r->members.back().object == osm->object_by_id<relation_t>(5));
+  assert_null(r->members.back().role);
+
+  const relation_t * const r5 = osm->object_by_id<relation_t>(5);
+  assert_cmpnum(r5->members.size(), 1);
+  assert(r5->members.front().object == n);
+  assert_cmpstr(r5->members.front().role, "a");
+
+  // files without metadata are rejected, the objects could not be uploaded
+  nodeBlock.data.clear();
+  dense.data.clear();
+  nodes.data.clear();
+  dense.spacked(1, svec({ 1 })).spacked(8, svec({ 520500000 })).spacked(9, svec({ 90500000 }));
+  nodes.message(2, dense);
+  nodeBlock.message(1, pbf_strings({ "" })).message(2, nodes);
+  data = pbf_header() + pbf_blob("OSMData", nodeBlock, true);
+  osm.reset(parse_string(data.c_str(), data.size()));
+  assert(!osm);
+
+  // unknown required features
+  pbf_message header;
+  header.bytes(4, "OsmSchema-V0.6").bytes(4, "HistoricalInformation");
+  data = pbf_blob("OSMHeader", header, false);
+  osm.reset(parse_string(data.c_str(), data.size()));
+  assert(!osm);
+}
+
+std::string
+gzip_string(const std::string &data)
+{
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  assert_cmpnum(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY), Z_OK);
+  std::string ret(deflateBound(&zs, data.size()), '\0');
+  zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+  zs.avail_in = data.size();
+  zs.next_out = reinterpret_cast<Bytef *>(&ret[0]);
+  zs.avail_out = ret.size();
+  assert_cmpnum(deflate(&zs, Z_FINISH), Z_STREAM_END);
+  ret.resize(zs.total_out);
+  deflateEnd(&zs);
+  return ret;
+}
+
+osm_t *
+parse_stream(const std::string &data, size_t step)
+{
+  std::unique_ptr<osm_stream_parser> parser(osm_stream_parser::create());
+  for(size_t pos = 0; pos < data.size(); pos += step)
+    parser->feed(data.data() + pos, std::min(step, data.size() - pos));
+  return parser->finish();
+}
+
+void
+check_stream_result(const osm_t &expected, const osm_t *osm)
+{
+  assert(osm != nullptr);
+  assert_cmpnum(osm->uploadPolicy, expected.uploadPolicy);
+  assert(osm->bounds.ll == expected.bounds.ll);
+  assert(osm->users == expected.users);
+  assert_cmpnum(osm->nodes.size(), expected.nodes.size());
+  assert_cmpnum(osm->ways.size(), expected.ways.size());
+  assert_cmpnum(osm->relations.size(), expected.relations.size());
+
+  const osm_compare cmp(*osm);
+  std::for_each(expected.nodes.begin(), expected.nodes.end(), cmp);
+  std::for_each(expected.ways.begin(), expected.ways.end(), cmp);
+  std::for_each(expected.relations.begin(), expected.relations.end(), cmp);
+}
+
+void
+check_stream(const char *fname)
+{
+  std::unique_ptr<osm_t> expected(osm_t::parse(std::string(), fname));
+  assert(expected);
+
+  osm2go_platform::MappedFile map(fname);
+  assert(map);
+  const std::string data(map.data(), map.length());
+
+  // pieces that do not match any structure
+  std::unique_ptr<osm_t> osm(parse_stream(data, 7));
+  check_stream_result(*expected, osm.get());
+
+  // everything at once
+  osm.reset(parse_stream(data, data.size()));
+  check_stream_result(*expected, osm.get());
+
+  const std::string gz = gzip_string(data);
+  osm.reset(parse_stream(gz, 13));
+  check_stream_result(*expected, osm.get());
+
+  // compressed files are read the same way
+  osm.reset(parse_string(gz.data(), gz.size()));
+  check_stream_result(*expected, osm.get());
+
+  // incomplete data
+  osm.reset(parse_stream(data.substr(0, data.size() - 10), 100));
+  assert(!osm);
+  osm.reset(parse_stream(gz.substr(0, gz.size() / 2), 100));
+  assert(!osm);
+
+  // something big enough to be scanned in several parts while it arrives
+  std::string big = "<?xml version='1.0' encoding='UTF-8'?>\n"
+                    "<osm version='0.6' generator='osm_load'>\n"
+                    " <bounds minlat='52.0' minlon='9.0' maxlat='52.1' maxlon='9.1'/>\n";
+  const unsigned int nodeCount = 40000;
+  char buf[256];
+  for(unsigned int i = 1; i <= nodeCount; i++) {
+    snprintf(buf, sizeof(buf), " <node id='%u' version='1' lat='52.0%u' lon='9.0%u'>\n"
+                               "  <tag k='ref' v='%u'/>\n </node>\n", i, i, i, i);
+    big += buf;
+  }
+  for(unsigned int i = 1; i < nodeCount; i += 2) {
+    snprintf(buf, sizeof(buf), " <way id='%u' version='1'><nd ref='%u'/><nd ref='%u'/></way>\n",
+             i, i, i + 1);
+    big += buf;
+  }
+  big += "</osm>\n";
+  assert_cmpnum_op(big.size(), >, 4 * 1024 * 1024);
+
+  expected.reset(parse_string(big.c_str(), big.size()));
+  assert(expected);
+  assert_cmpnum(expected->nodes.size(), nodeCount);
+  assert_cmpnum(expected->ways.size(), nodeCount / 2);
+
+  osm.reset(parse_stream(big, 16 * 1024));
+  check_stream_result(*expected, osm.get());
+  const std::string biggz = gzip_string(big);
+  osm.reset(parse_stream(biggz, 16 * 1024));
+  check_stream_result(*expected, osm.get());
+  osm.reset(parse_string(biggz.data(), biggz.size()));
+  check_stream_result(*expected, osm.get());
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -90,6 +650,15 @@ int main(int argc, char **argv)
   xmlInitParser();
 
   check_memberParser();
+  check_parse("<?xml version='1.0' encoding='UTF-8'?>\n<!-- a comment -->\n");
+  // the scanner only supports UTF-8, so this is parsed by libxml
+  check_parse("<?xml version='1.0' encoding='ISO-8859-1'?>\n");
+  check_invalid_ids("<?xml version='1.0' encoding='UTF-8'?>\n");
+  check_invalid_ids("<?xml version='1.0' encoding='ISO-8859-1'?>\n");
+  check_shared_tags();
+  check_snapshot(argv[1]);
+  check_pbf();
+  check_stream(argv[1]);
 
   std::unique_ptr<osm_t> osm(osm_t::parse(std::string(), argv[1]));
   if(!osm) {
@@ -0,0 +1,150 @@
+#include <misc.h>
+#include <pos.h>
+
+#include <osm2go_annotations.h>
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+time_t reference_time(const char *str)
+{
+  struct tm ctime;
+  memset(&ctime, 0, sizeof(ctime));
+  const char *end = strptime(str, "%FT%TZ", &ctime);
+  assert(end != nullptr);
+  assert_cmpnum(*end, '\0');
+  return timegm(&ctime);
+}
+
+void test_float_int()
+{
+  int32_t val = 42;
+
+  assert(parse_float_int("0", 7, val));
+  assert_cmpnum(val, 0);
+  assert(parse_float_int("52.2692786", 7, val));
+  assert_cmpnum(val, 522692786);
+  assert(parse_float_int("-9.575", 7, val));
+  assert_cmpnum(val, -95750000);
+  assert(parse_float_int("180", 7, val));
+  assert_cmpnum(val, 1800000000);
+  assert(parse_float_int("-.5", 7, val));
+  assert_cmpnum(val, -5000000);
+  assert(parse_float_int("7.", 7, val));
+  assert_cmpnum(val, 70000000);
+  assert(parse_float_int("1.25", 2, val));
+  assert_cmpnum(val, 125);
+
+  // parsing stops at the first character that is not part of the number
+  assert(parse_float_int("1.5\" lon=\"2\"", 7, val));
+  assert_cmpnum(val, 15000000);
+
+  // all these need rounding or a different parser
+  val = 42;
+  assert(!parse_float_int("52.26927861", 7, val));
+  assert(!parse_float_int("1e5", 7, val));
+  assert(!parse_float_int("1.5E-3", 7, val));
+  assert(!parse_float_int("", 7, val));
+  assert(!parse_float_int("-", 7, val));
+  assert(!parse_float_int(".", 7, val));
+  assert(!parse_float_int("nan", 7, val));
+  // out of range
+  assert(!parse_float_int("214.7483648", 7, val));
+  assert(!parse_float_int("12345678901234567890", 0, val));
+  assert_cmpnum(val, 42);
+  assert(parse_float_int("214.7483647", 7, val));
+  assert_cmpnum(val, INT32_MAX);
+}
+
+void test_coord()
+{
+  // the result must be exactly the same as before
+  const char *values[] = { "52.2692786", "-9.5750497", "0.0000001", "-0.0000001",
+                           "89.9999999", "-180", "52.26927861234", "1e-3", "13.4" };
+  for(unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    assert(pos_parse_coord(values[i]) == static_cast<pos_float_t>(strtod(values[i], nullptr)));
+
+  assert(std::isnan(pos_parse_coord(nullptr)));
+
+  // the same fixed point value is created
+  const pos_fixed_t fixed(pos_t(pos_parse_coord("52.2692786"), pos_parse_coord("-9.5750497")));
+  assert_cmpnum(fixed.ilat, 522692786);
+  assert_cmpnum(fixed.ilon, -95750497);
+}
+
+void test_int64()
+{
+  int64_t v = 0;
+  assert(parse_int64("0", v));
+  assert_cmpnum(v, 0);
+  assert(parse_int64("42", v));
+  assert_cmpnum(v, 42);
+  assert(parse_int64("-1", v));
+  assert_cmpnum(v, -1);
+  assert(parse_int64("9223372036854775807", v));
+  assert_cmpnum(v, INT64_MAX);
+  assert(parse_int64("-9223372036854775807", v));
+  assert_cmpnum(v, -INT64_MAX);
+  // the raw attribute values of the XML scanner end with the quote
+  assert(parse_int64("12345\" version=\"3\"", v));
+  assert_cmpnum(v, 12345);
+  assert(parse_int64("678' version='3'", v));
+  assert_cmpnum(v, 678);
+
+  v = 17;
+  assert(!parse_int64("", v));
+  assert(!parse_int64("-", v));
+  assert(!parse_int64("abc", v));
+  assert(!parse_int64("12abc", v));
+  assert(!parse_int64("1.5", v));
+  assert(!parse_int64(" 1", v));
+  assert(!parse_int64("9223372036854775808", v));
+  assert(!parse_int64("-9223372036854775808", v));
+  assert(!parse_int64("99999999999999999999", v));
+  assert_cmpnum(v, 17);
+}
+
+void test_timestamp()
+{
+  const char *values[] = { "1970-01-01T00:00:00Z", "2000-02-29T12:34:56Z", "2016-12-31T23:59:59Z",
+                           "2017-01-01T00:00:00Z", "1999-03-01T00:00:01Z", "2100-02-28T23:59:59Z",
+                           "2038-01-19T03:14:08Z", "2010-10-10T10:10:10Z" };
+  for(unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    time_t t = 0;
+    assert(parse_iso8601_utc(values[i], t));
+    assert_cmpnum(t, reference_time(values[i]));
+  }
+
+  // the end of the string is not relevant
+  time_t t = 0;
+  assert(parse_iso8601_utc("2010-10-10T10:10:10Z\" uid=\"1\"", t));
+  assert_cmpnum(t, reference_time("2010-10-10T10:10:10Z"));
+
+  const char *invalid[] = { "", "2010", "2010-10-10", "2010-10-10T10:10:10", "2010-10-10T10:10:10+01:00",
+                            "2010-10-10 10:10:10Z", "2010-13-10T10:10:10Z", "2010-00-10T10:10:10Z",
+                            "2010-10-32T10:10:10Z", "2010-10-10T24:10:10Z", "2010-10-10T10:60:10Z",
+                            "2010-1a-10T10:10:10Z", "2010-10-10T10:10:10.5Z" };
+  for(unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    t = 42;
+    assert(!parse_iso8601_utc(invalid[i], t));
+    assert_cmpnum(t, 42);
+  }
+}
+
+} // namespace
+
+int main()
+{
+  test_float_int();
+  test_coord();
+  test_int64();
+  test_timestamp();
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <misc.h>
+#include <pos.h>
+
+#include <osm2go_annotations.h>
+#include <osm2go_platform.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * @brief compare the number parsing of the OSM parser to the generic functions
+ *
+ * All id, version, timestamp, and coordinate attributes of the given OSM file
+ * are collected and then parsed repeatedly, once with the functions used
+ * before (strtoll(), strptime() and timegm(), the platform string_to_double())
+ * and once with the dedicated functions from misc.h.
+ */
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double elapsed_ms(clock_type::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+struct attribute_values {
+  std::vector<const char *> ids;   ///< ids, versions, and node references
+  std::vector<const char *> times;
+  std::vector<const char *> coords;
+  unsigned int objects;
+};
+
+void collect(const std::string &data, const char *name, std::vector<const char *> &values)
+{
+  const char quotes[] = { '"', '\'' };
+  for(unsigned int i = 0; i < sizeof(quotes); i++) {
+    const std::string pattern = std::string(" ") + name + '=' + quotes[i];
+    for(std::string::size_type pos = data.find(pattern); pos != std::string::npos;
+        pos = data.find(pattern, pos + 1))
+      values.push_back(data.c_str() + pos + pattern.size());
+  }
+}
+
+time_t generic_time(const char *str)
+{
+  struct tm ctime;
+  memset(&ctime, 0, sizeof(ctime));
+  strptime(str, "%FT%T%z", &ctime);
+
+  long gmtoff = ctime.tm_gmtoff;
+
+  return timegm(&ctime) - gmtoff;
+}
+
+int64_t run_generic(const attribute_values &values)
+{
+  int64_t sum = 0;
+  for(std::vector<const char *>::const_iterator it = values.ids.begin(); it != values.ids.end(); it++)
+    sum += strtoll(*it, nullptr, 10);
+  for(std::vector<const char *>::const_iterator it = values.times.begin(); it != values.times.end(); it++)
+    sum += generic_time(*it);
+  for(std::vector<const char *>::const_iterator it = values.coords.begin(); it != values.coords.end(); it++)
+    sum += static_cast<int64_t>(osm2go_platform::string_to_double(*it) * 1e7);
+  return sum;
+}
+
+int64_t run_dedicated(const attribute_values &values)
+{
+  int64_t sum = 0;
+  for(std::vector<const char *>::const_iterator it = values.ids.begin(); it != values.ids.end(); it++) {
+    int64_t v;
+    if(likely(parse_int64(*it, v)))
+      sum += v;
+  }
+  for(std::vector<const char *>::const_iterator it = values.times.begin(); it != values.times.end(); it++) {
+    time_t t;
+    if(likely(parse_iso8601_utc(*it, t)))
+      sum += t;
+    else
+      sum += generic_time(*it);
+  }
+  for(std::vector<const char *>::const_iterator it = values.coords.begin(); it != values.coords.end(); it++)
+    sum += static_cast<int64_t>(pos_parse_coord(*it) * 1e7);
+  return sum;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s file.osm [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  unsigned int iterations = 10000;
+  if(argc > 2)
+    iterations = strtoul(argv[2], nullptr, 10);
+
+  std::ifstream file(argv[1]);
+  const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if(data.empty()) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  attribute_values values;
+  collect(data, "id", values.ids);
+  values.objects = values.ids.size();
+  collect(data, "version", values.ids);
+  collect(data, "ref", values.ids);
+  collect(data, "timestamp", values.times);
+  collect(data, "lat", values.coords);
+  collect(data, "lon", values.coords);
+
+  printf("%u objects: %zu integers, %zu timestamps, %zu coordinates\n", values.objects,
+         values.ids.size(), values.times.size(), values.coords.size());
+  if(values.objects == 0)
+    return 1;
+
+  int64_t sum = 0;
+  clock_type::time_point start = clock_type::now();
+  for(unsigned int i = 0; i < iterations; i++)
+    sum += run_generic(values);
+  const double generic = elapsed_ms(start);
+
+  int64_t dsum = 0;
+  start = clock_type::now();
+  for(unsigned int i = 0; i < iterations; i++)
+    dsum += run_dedicated(values);
+  const double dedicated = elapsed_ms(start);
+
+  // both must have parsed the same values
+  assert_cmpnum(sum, dsum);
+
+  const double scale = 1e6 / (static_cast<double>(iterations) * values.objects);
+  printf("generic   %9.3f ms  %7.1f ns per object\n", generic, generic * scale);
+  printf("dedicated %9.3f ms  %7.1f ns per object\n", dedicated, dedicated * scale);
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief a simple LCG to get deterministic test data
+ *
+ * The output must not depend on the C library, so the same seed gives the
+ * same data everywhere.
+ */
+struct lcg {
+  uint32_t seed;
+  explicit inline lcg(uint32_t s) : seed(s) {}
+
+  /**
+   * @brief a random number in [0, range)
+   *
+   * Only 24 bits of randomness are available, see large().
+   */
+  inline unsigned int next(unsigned int range)
+  {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % range;
+  }
+
+  /**
+   * @brief a random number in [-spread, spread]
+   */
+  inline int offset(int spread)
+  {
+    return static_cast<int>(next(2 * spread + 1)) - spread;
+  }
+
+  /**
+   * @brief a random number in [0, range) for ranges bigger than 2^24
+   */
+  inline unsigned int large(unsigned int range)
+  {
+    return ((next(1 << 16) << 16) | next(1 << 16)) % range;
+  }
+
+  inline bool chance(unsigned int percent)
+  {
+    return next(100) < percent;
+  }
+
+  inline double between(double low, double high)
+  {
+    return low + (high - low) * next(1 << 16) / (1 << 16);
+  }
+};
@@ -12,18 +12,18 @@ class verify_osm_db {
   verify_osm_map(osm_t::ref osm)
   {
     const std::unordered_map<item_id_t, const T *> &orig = osm->originalObjects<T>();
-    const std::map<item_id_t, T *> &objects = osm->objects<T>();
+    const object_map<T> &objects = osm->objects<T>();
 
     unsigned int o_modified = 0;
     unsigned int o_deleted = 0;
     unsigned int modified = 0;
     unsigned int deleted = 0;
 
-    const typename std::map<item_id_t, T *>::const_iterator itEnd = objects.end();
+    const typename object_map<T>::const_iterator itEnd = objects.end();
     const typename std::unordered_map<item_id_t, const T *>::const_iterator oitEnd = orig.end();
 
     for (typename std::unordered_map<item_id_t, const T *>::const_iterator oit = orig.begin(); oit != oitEnd; oit++) {
-      const typename std::map<item_id_t, T *>::const_iterator it = objects.find(oit->first);
+      const typename object_map<T>::const_iterator it = objects.find(oit->first);
       assert(it != itEnd);
       if (it->second->flags & OSM_FLAG_DELETED)
         o_deleted++;
@@ -33,7 +33,7 @@ class verify_osm_db {
         assert_unreachable();
     }
 
-    for (typename std::map<item_id_t, T *>::const_iterator it = objects.begin(); it != itEnd; it++) {
+    for (typename object_map<T>::const_iterator it = objects.begin(); it != itEnd; it++) {
       unsigned int flags = it->second->flags;
       assert(it->second->id != ID_ILLEGAL);
       // ignore new entries: they are not accounted for in the original map